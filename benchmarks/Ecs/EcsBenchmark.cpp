@@ -0,0 +1,407 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <cstdlib>
+
+#include <neolib/task/async_task.hpp>
+#include <neolib/task/async_thread.hpp>
+#include <neolib/ecs/ecs.hpp>
+#include <neolib/ecs/entity_archetype.hpp>
+#include <neolib/ecs/entity_info.hpp>
+#include <neolib/ecs/system.hpp>
+#include <neolib/ecs/system_scheduler.hpp>
+#include <neolib/ecs/view.hpp>
+
+// Measures ECS throughput at several world sizes and writes one record per measurement to stdout, either as
+// JSON lines (default) or CSV. Usage: EcsBenchmark [--sizes=10000,100000,1000000] [--repeat=3] [--format=json|csv]
+
+template<> neolib::i_async_task& neolib::services::start_service<neolib::i_async_task>()
+{
+    static neolib::async_task mainTask;
+    static neolib::async_thread mainThread{ mainTask, "neolib::ecs benchmark(s)", true };
+    return mainTask;
+}
+
+namespace
+{
+    struct vec3_component_meta : neolib::ecs::i_component_data::meta
+    {
+        static uint32_t field_count()
+        {
+            return 1;
+        }
+        static neolib::ecs::component_data_field_type field_type(uint32_t aFieldIndex)
+        {
+            switch (aFieldIndex)
+            {
+            case 0:
+                return neolib::ecs::component_data_field_type::Vec3;
+            default:
+                throw invalid_field_index();
+            }
+        }
+        static const neolib::i_string& field_name(uint32_t aFieldIndex)
+        {
+            static const neolib::string sFieldNames[] =
+            {
+                "Value"
+            };
+            return sFieldNames[aFieldIndex];
+        }
+    };
+
+    struct position
+    {
+        neolib::vec3 value;
+
+        struct meta : vec3_component_meta
+        {
+            static const neolib::uuid& id()
+            {
+                static const neolib::uuid sId = { 0x9a3b6c21, 0x54e8, 0x4f0d, 0x8b71, { 0x2d, 0xc6, 0x10, 0x7a, 0x93, 0xe4 } };
+                return sId;
+            }
+            static const neolib::i_string& name()
+            {
+                static const neolib::string sName = "Position";
+                return sName;
+            }
+        };
+    };
+
+    struct velocity
+    {
+        neolib::vec3 value;
+
+        struct meta : vec3_component_meta
+        {
+            static const neolib::uuid& id()
+            {
+                static const neolib::uuid sId = { 0x1f7e40b8, 0xa2c3, 0x4d96, 0x9e05, { 0x6b, 0x38, 0xf1, 0x4c, 0x0a, 0x7d } };
+                return sId;
+            }
+            static const neolib::i_string& name()
+            {
+                static const neolib::string sName = "Velocity";
+                return sName;
+            }
+        };
+    };
+
+    neolib::ecs::entity_archetype const& particle_archetype()
+    {
+        static neolib::ecs::entity_archetype const sArchetype{ "Particle", { position::meta::id(), velocity::meta::id() } };
+        return sArchetype;
+    }
+
+    neolib::ecs::entity_archetype const& body_archetype()
+    {
+        static neolib::ecs::entity_archetype const sArchetype{ "Body", { position::meta::id() } };
+        return sArchetype;
+    }
+
+    template <typename Derived, typename... ComponentData>
+    class benchmark_system : public neolib::ecs::system<ComponentData...>
+    {
+    public:
+        benchmark_system(neolib::ecs::i_ecs& aEcs) :
+            neolib::ecs::system<ComponentData...>{ aEcs }
+        {
+        }
+    public:
+        const neolib::ecs::system_id& id() const override
+        {
+            return Derived::meta::id();
+        }
+        const neolib::i_string& name() const override
+        {
+            return Derived::meta::name();
+        }
+    };
+
+    class integrator : public benchmark_system<integrator, position, const velocity>
+    {
+    public:
+        using benchmark_system::benchmark_system;
+    public:
+        bool apply() override
+        {
+            neolib::ecs::view<position, const velocity>{ ecs() }.for_each([](neolib::ecs::entity_id, position& p, velocity const& v) { p.value += v.value; });
+            return true;
+        }
+    public:
+        struct meta
+        {
+            static const neolib::uuid& id()
+            {
+                static const neolib::uuid sId = { 0x5c02e7a9, 0x3b14, 0x4a8f, 0xb6d2, { 0x81, 0x4e, 0x27, 0xc9, 0x5f, 0x03 } };
+                return sId;
+            }
+            static const neolib::i_string& name()
+            {
+                static const neolib::string sName = "Integrator";
+                return sName;
+            }
+        };
+    };
+
+    template <int Index>
+    class idle_system : public benchmark_system<idle_system<Index>, const velocity>
+    {
+    public:
+        using benchmark_system<idle_system<Index>, const velocity>::benchmark_system;
+    public:
+        bool apply() override
+        {
+            return true;
+        }
+    public:
+        struct meta
+        {
+            static const neolib::uuid& id()
+            {
+                static const neolib::uuid sId = { 0xe6d41f30, 0x7c25, 0x4b19, 0x8a60, { 0x3f, 0x92, 0xd7, 0x18, 0xb4, static_cast<std::uint8_t>(Index) } };
+                return sId;
+            }
+            static const neolib::i_string& name()
+            {
+                static const neolib::string sName = "Idle " + std::to_string(Index);
+                return sName;
+            }
+        };
+    };
+
+    enum class output_format
+    {
+        Json,
+        Csv
+    };
+
+    struct settings
+    {
+        std::vector<std::size_t> sizes = { 10000u, 100000u, 1000000u };
+        std::size_t repeat = 3u;
+        output_format format = output_format::Json;
+    };
+
+    class reporter
+    {
+    public:
+        reporter(settings const& aSettings) :
+            iSettings{ aSettings }
+        {
+            if (iSettings.format == output_format::Csv)
+                std::cout << "benchmark,entities,operations,seconds,ns_per_operation,operations_per_second" << std::endl;
+        }
+    public:
+        // Runs aSetup then times aRun, keeping the fastest of the configured repetitions.
+        void measure(std::string const& aName, std::size_t aEntities, std::size_t aOperations, std::function<void()> const& aSetup, std::function<void()> const& aRun)
+        {
+            double best = std::numeric_limits<double>::max();
+            for (std::size_t pass = 0u; pass < iSettings.repeat; ++pass)
+            {
+                aSetup();
+                auto const start = std::chrono::steady_clock::now();
+                aRun();
+                auto const end = std::chrono::steady_clock::now();
+                best = std::min(best, std::chrono::duration<double>(end - start).count());
+            }
+            auto const nsPerOperation = best * 1.0e9 / static_cast<double>(std::max<std::size_t>(aOperations, 1u));
+            auto const operationsPerSecond = best > 0.0 ? static_cast<double>(aOperations) / best : 0.0;
+            if (iSettings.format == output_format::Csv)
+                std::cout << aName << "," << aEntities << "," << aOperations << "," << best << "," << nsPerOperation << "," << operationsPerSecond << std::endl;
+            else
+                std::cout << "{\"benchmark\":\"" << aName << "\",\"entities\":" << aEntities << ",\"operations\":" << aOperations <<
+                    ",\"seconds\":" << best << ",\"ns_per_operation\":" << nsPerOperation << ",\"operations_per_second\":" << operationsPerSecond << "}" << std::endl;
+        }
+    private:
+        settings const& iSettings;
+    };
+
+    neolib::ecs::ecs_flags const worldFlags = neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads;
+
+    void run(reporter& aReporter, std::size_t aCount)
+    {
+        std::unique_ptr<neolib::ecs::ecs> world;
+        std::vector<neolib::ecs::entity_id> entities;
+        auto fresh_world = [&]()
+        {
+            entities.clear();
+            world = std::make_unique<neolib::ecs::ecs>(worldFlags);
+            world->register_archetype(particle_archetype());
+            world->register_archetype(body_archetype());
+        };
+        auto populated_world = [&]()
+        {
+            fresh_world();
+            entities = world->create_entities(particle_archetype(), aCount, position{}, velocity{ { 1.0, 0.0, 0.0 } });
+        };
+
+        aReporter.measure("create_entity", aCount, aCount, fresh_world, [&]()
+        {
+            for (std::size_t i = 0u; i < aCount; ++i)
+                entities.push_back(world->create_entity(particle_archetype(), position{}, velocity{}));
+        });
+        aReporter.measure("create_entities", aCount, aCount, fresh_world, [&]()
+        {
+            entities = world->create_entities(particle_archetype(), aCount, position{}, velocity{});
+        });
+        aReporter.measure("destroy_entity", aCount, aCount, populated_world, [&]()
+        {
+            for (auto entity : entities)
+                world->destroy_entity(entity);
+        });
+        aReporter.measure("destroy_entities", aCount, aCount, populated_world, [&]()
+        {
+            world->destroy_entities(entities);
+        });
+        aReporter.measure("populate", aCount, aCount, [&]()
+        {
+            fresh_world();
+            entities = world->create_entities(body_archetype(), aCount, position{});
+        }, [&]()
+        {
+            auto& velocities = world->component<velocity>();
+            for (auto entity : entities)
+                velocities.populate(entity, velocity{ { 1.0, 0.0, 0.0 } });
+        });
+        aReporter.measure("commit_async_entity_creation", aCount, aCount, [&]()
+        {
+            fresh_world();
+            neolib::ecs::i_ecs& ecs = *world;
+            for (std::size_t i = 0u; i < aCount; ++i)
+                ecs.async_create_entity(particle_archetype(), position{}, velocity{});
+        }, [&]()
+        {
+            world->commit_async_entity_creation();
+        });
+        aReporter.measure("commit_async_entity_destruction", aCount, aCount, [&]()
+        {
+            populated_world();
+            for (auto entity : entities)
+                world->async_destroy_entity(entity);
+        }, [&]()
+        {
+            world->commit_async_entity_destruction();
+        });
+
+        populated_world();
+        for (std::size_t i = 0u; i < aCount; i += 2u)
+            world->create_entity(body_archetype(), position{});
+        aReporter.measure("iterate_single", aCount, aCount, []() {}, [&]()
+        {
+            neolib::ecs::view<position>{ *world }.for_each([](neolib::ecs::entity_id, position& p) { p.value.x += 1.0; });
+        });
+        aReporter.measure("iterate_multi", aCount, aCount, []() {}, [&]()
+        {
+            neolib::ecs::view<position, const velocity>{ *world }.for_each([](neolib::ecs::entity_id, position& p, velocity const& v) { p.value += v.value; });
+        });
+        aReporter.measure("iterate_multi_parallel", aCount, aCount, []() {}, [&]()
+        {
+            neolib::ecs::view<position, const velocity>{ *world }.parallel_for_each([](neolib::ecs::entity_id, position& p, velocity const& v) { p.value += v.value; });
+        });
+
+        auto& positions = world->component<position>();
+        aReporter.measure("snapshot_full", aCount, aCount, [&]() { positions.component_data(); }, [&]()
+        {
+            positions.take_snapshot();
+        });
+        aReporter.measure("snapshot_incremental_1pct", aCount, aCount / 100u, [&]()
+        {
+            positions.take_snapshot();
+            for (std::size_t i = 0u; i < entities.size(); i += 100u)
+                positions.entity_record(entities[i]).value.y += 1.0;
+        }, [&]()
+        {
+            positions.take_snapshot();
+        });
+
+        neolib::ecs::system_scheduler scheduler{ *world };
+        scheduler.add(world->system<integrator>());
+        aReporter.measure("system_frame", aCount, aCount, []() {}, [&]()
+        {
+            scheduler.run_frame();
+        });
+    }
+
+    void run_scheduler_overhead(reporter& aReporter)
+    {
+        std::size_t const frames = 10000u;
+        neolib::ecs::ecs world{ worldFlags };
+        neolib::ecs::system_scheduler scheduler{ world };
+        scheduler.add(world.system<idle_system<0>>());
+        scheduler.add(world.system<idle_system<1>>());
+        scheduler.add(world.system<idle_system<2>>());
+        scheduler.add(world.system<idle_system<3>>());
+        aReporter.measure("system_scheduling_overhead", 0u, frames, []() {}, [&]()
+        {
+            for (std::size_t frame = 0u; frame < frames; ++frame)
+                scheduler.run_frame();
+        });
+    }
+
+    settings parse_arguments(int argc, char* argv[])
+    {
+        settings result;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string const argument = argv[i];
+            auto value_of = [&](std::string const& aOption) -> std::optional<std::string>
+            {
+                if (argument.rfind(aOption, 0) == 0)
+                    return argument.substr(aOption.size());
+                return {};
+            };
+            if (auto const sizes = value_of("--sizes="))
+            {
+                result.sizes.clear();
+                for (std::size_t first = 0u; first < sizes->size();)
+                {
+                    auto const last = std::min(sizes->find(',', first), sizes->size());
+                    result.sizes.push_back(std::stoull(sizes->substr(first, last - first)));
+                    first = last + 1u;
+                }
+            }
+            else if (auto const repeat = value_of("--repeat="))
+                result.repeat = std::max<std::size_t>(std::stoull(*repeat), 1u);
+            else if (auto const format = value_of("--format="))
+            {
+                if (*format == "json")
+                    result.format = output_format::Json;
+                else if (*format == "csv")
+                    result.format = output_format::Csv;
+                else
+                    throw std::invalid_argument("unknown format: " + *format);
+            }
+            else
+                throw std::invalid_argument("unknown argument: " + argument);
+        }
+        return result;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    neolib::allocate_service_provider();
+
+    try
+    {
+        auto const settings = parse_arguments(argc, argv);
+        reporter output{ settings };
+        for (auto size : settings.sizes)
+            run(output, size);
+        run_scheduler_overhead(output);
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << "EcsBenchmark: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
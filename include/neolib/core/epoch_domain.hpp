@@ -0,0 +1,179 @@
+// epoch_domain.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace neolib
+{
+    // Epoch-based reclamation: readers announce the epoch they entered in a reader slot without taking a
+    // lock and writers retire replaced objects tagged with the epoch at retirement. A retired object is
+    // destroyed once every reader that might still hold it has left, i.e. when no active reader announced
+    // an epoch at or before its tag.
+    class epoch_domain
+    {
+    public:
+        typedef std::uint64_t epoch_type;
+        static constexpr std::size_t reader_slots = 64u;
+    private:
+        static constexpr epoch_type inactive = 0u;
+        struct alignas(64) reader_slot
+        {
+            std::atomic<epoch_type> epoch = inactive;
+        };
+        struct retired
+        {
+            epoch_type epoch;
+            void* object;
+            void (*deleter)(void*);
+        };
+    public:
+        class read_guard
+        {
+        public:
+            read_guard(epoch_domain const& aDomain) :
+                iDomain{ &aDomain }, iSlot{ aDomain.enter() }
+            {
+            }
+            ~read_guard()
+            {
+                if (iDomain)
+                    iDomain->leave(iSlot);
+            }
+            read_guard(read_guard&& aOther) noexcept :
+                iDomain{ aOther.iDomain }, iSlot{ aOther.iSlot }
+            {
+                aOther.iDomain = nullptr;
+            }
+            read_guard(read_guard const&) = delete;
+            read_guard& operator=(read_guard const&) = delete;
+        private:
+            epoch_domain const* iDomain;
+            std::size_t iSlot;
+        };
+    public:
+        epoch_domain() :
+            iEpoch{ 1u }
+        {
+        }
+        ~epoch_domain()
+        {
+            for (auto const& r : iRetired)
+                r.deleter(r.object);
+        }
+        epoch_domain(epoch_domain const&) = delete;
+        epoch_domain& operator=(epoch_domain const&) = delete;
+    public:
+        epoch_type epoch() const
+        {
+            return iEpoch.load();
+        }
+        read_guard read() const
+        {
+            return read_guard{ *this };
+        }
+        // Call after the object has been unlinked so that no new reader can reach it.
+        template <typename T>
+        void retire(T const* aObject)
+        {
+            if (aObject == nullptr)
+                return;
+            std::scoped_lock lock{ iRetiredMutex };
+            iRetired.push_back(retired{ iEpoch.fetch_add(1u), const_cast<T*>(aObject), [](void* aObject) { delete static_cast<T*>(aObject); } });
+            do_reclaim();
+        }
+        std::size_t reclaim()
+        {
+            std::scoped_lock lock{ iRetiredMutex };
+            return do_reclaim();
+        }
+        std::size_t retired_count() const
+        {
+            std::scoped_lock lock{ iRetiredMutex };
+            return iRetired.size();
+        }
+    private:
+        // Claims a free reader slot, starting from one derived from the thread id so that threads rarely
+        // contend for the same slot. If every slot is in use the reader yields until one is released.
+        std::size_t enter() const
+        {
+            auto slot = std::hash<std::thread::id>{}(std::this_thread::get_id()) % reader_slots;
+            for (std::size_t attempt = 1u;; ++attempt, slot = (slot + 1u) % reader_slots)
+            {
+                auto expected = inactive;
+                if (iSlots[slot].epoch.load(std::memory_order_relaxed) == inactive &&
+                    iSlots[slot].epoch.compare_exchange_strong(expected, iEpoch.load()))
+                    return slot;
+                if (attempt % reader_slots == 0u)
+                    std::this_thread::yield();
+            }
+        }
+        void leave(std::size_t aSlot) const
+        {
+            iSlots[aSlot].epoch.store(inactive, std::memory_order_release);
+        }
+        std::size_t do_reclaim()
+        {
+            auto oldestActive = std::numeric_limits<epoch_type>::max();
+            for (auto const& slot : iSlots)
+            {
+                auto const announced = slot.epoch.load();
+                if (announced != inactive)
+                    oldestActive = std::min(oldestActive, announced);
+            }
+            auto const reclaimable = std::stable_partition(iRetired.begin(), iRetired.end(), [&](retired const& r) { return r.epoch >= oldestActive; });
+            std::size_t const count = std::distance(reclaimable, iRetired.end());
+            for (auto r = reclaimable; r != iRetired.end(); ++r)
+                r->deleter(r->object);
+            iRetired.erase(reclaimable, iRetired.end());
+            return count;
+        }
+    private:
+        std::atomic<epoch_type> iEpoch;
+        mutable std::array<reader_slot, reader_slots> iSlots;
+        mutable std::mutex iRetiredMutex;
+        std::vector<retired> iRetired;
+    };
+}
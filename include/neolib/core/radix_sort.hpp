@@ -0,0 +1,117 @@
+// radix_sort.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace neolib
+{
+    // Maps an arithmetic (or enum) value onto an unsigned integer whose natural order matches the value's order.
+    template <typename T>
+    constexpr std::uint64_t radix_key(T aValue)
+    {
+        if constexpr (std::is_enum_v<T>)
+            return radix_key(static_cast<std::underlying_type_t<T>>(aValue));
+        else if constexpr (std::is_same_v<T, bool>)
+            return aValue ? 1u : 0u;
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            static_assert(sizeof(T) == sizeof(std::uint32_t) || sizeof(T) == sizeof(std::uint64_t), "neolib::radix_key: unsupported floating point type");
+            typedef std::conditional_t<sizeof(T) == sizeof(std::uint32_t), std::uint32_t, std::uint64_t> bits_type;
+            constexpr bits_type signBit = bits_type{ 1u } << (sizeof(bits_type) * 8u - 1u);
+            auto const bits = std::bit_cast<bits_type>(aValue == T{} ? T{} : aValue); // -0.0 == 0.0
+            return (bits & signBit) ? static_cast<bits_type>(~bits) : static_cast<bits_type>(bits | signBit);
+        }
+        else if constexpr (std::is_signed_v<T>)
+        {
+            typedef std::make_unsigned_t<T> bits_type;
+            constexpr bits_type signBit = bits_type{ 1u } << (sizeof(bits_type) * 8u - 1u);
+            return static_cast<bits_type>(static_cast<bits_type>(aValue) ^ signBit);
+        }
+        else
+        {
+            static_assert(std::is_unsigned_v<T>, "neolib::radix_key: key must be arithmetic or enum");
+            return aValue;
+        }
+    }
+
+    struct radix_entry
+    {
+        std::uint64_t key;
+        std::size_t index;
+    };
+
+    // Stable LSD radix sort of (key, index) entries by key, one byte per pass. Passes in which every entry
+    // has the same digit are skipped so narrow keys cost no more than their width. aScratch is resized as
+    // needed and can be reused across calls to avoid allocation.
+    inline void radix_sort(std::vector<radix_entry>& aEntries, std::vector<radix_entry>& aScratch)
+    {
+        constexpr std::size_t digits = sizeof(std::uint64_t);
+        constexpr std::size_t buckets = 256u;
+        if (aEntries.size() < 2u)
+            return;
+        std::array<std::array<std::size_t, buckets>, digits> histograms = {};
+        for (auto const& entry : aEntries)
+            for (std::size_t digit = 0u; digit < digits; ++digit)
+                ++histograms[digit][(entry.key >> (digit * 8u)) & 0xFFu];
+        aScratch.resize(aEntries.size());
+        auto* source = &aEntries;
+        auto* destination = &aScratch;
+        for (std::size_t digit = 0u; digit < digits; ++digit)
+        {
+            auto& histogram = histograms[digit];
+            if (histogram[((*source)[0].key >> (digit * 8u)) & 0xFFu] == aEntries.size())
+                continue;
+            std::size_t offset = 0u;
+            for (auto& count : histogram)
+            {
+                auto const next = offset + count;
+                count = offset;
+                offset = next;
+            }
+            for (auto const& entry : *source)
+                (*destination)[histogram[(entry.key >> (digit * 8u)) & 0xFFu]++] = entry;
+            std::swap(source, destination);
+        }
+        if (source != &aEntries)
+            aEntries.swap(aScratch);
+    }
+}
@@ -0,0 +1,214 @@
+// timing_wheel.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace neolib
+{
+    // Hierarchical timing wheel: each level has 256 slots, a slot at level n spans 256^n time units and the
+    // eight levels together cover the full 64-bit range. An entry lives at the level of the highest byte in
+    // which its expiry differs from the current time and moves down a level each time the wheel reaches its
+    // slot, so advancing only touches slots that hold entries, however far time moves.
+    template <typename Time, typename Payload>
+    class timing_wheel
+    {
+        static_assert(std::is_integral_v<Time>, "neolib::timing_wheel: time must be integral");
+    public:
+        typedef Time time_type;
+        typedef Payload payload_type;
+        struct entry
+        {
+            time_type expiry;
+            payload_type payload;
+        };
+    private:
+        static constexpr std::size_t levels = sizeof(std::uint64_t);
+        static constexpr std::size_t slot_count = 256u;
+        typedef std::array<std::uint64_t, slot_count / 64u> occupancy;
+        struct level
+        {
+            std::array<std::vector<entry>, slot_count> slots;
+            occupancy occupied = {};
+        };
+    public:
+        timing_wheel(time_type aNow = std::numeric_limits<time_type>::min()) :
+            iCurrent{ key(aNow) }, iLevels{ std::make_unique<std::array<level, levels>>() }, iSize{ 0u }
+        {
+        }
+    public:
+        bool empty() const
+        {
+            return iSize == 0u;
+        }
+        std::size_t size() const
+        {
+            return iSize;
+        }
+        time_type now() const
+        {
+            return from_key(iCurrent);
+        }
+        // Earliest time at which advance() may have work to do; exact for entries due within the current
+        // 256 time units and otherwise the start of the slot holding the next entry.
+        std::optional<time_type> next_expiry() const
+        {
+            if (!iDue.empty())
+                return now();
+            for (std::size_t l = 0u; l < levels; ++l)
+                if (auto const slot = next_occupied(l))
+                    return from_key(slot_start(l, *slot));
+            return {};
+        }
+        void schedule(time_type aExpiry, payload_type const& aPayload)
+        {
+            place(entry{ aExpiry, aPayload });
+            ++iSize;
+        }
+        void clear()
+        {
+            iDue.clear();
+            for (auto& l : *iLevels)
+            {
+                for (auto& s : l.slots)
+                    s.clear();
+                l.occupied = {};
+            }
+            iSize = 0u;
+        }
+        // Advances to aNow, calling aExpired(entry) for every entry with an expiry at or before aNow.
+        template <typename Callable>
+        void advance(time_type aNow, Callable&& aExpired)
+        {
+            auto const target = key(aNow);
+            if (target < iCurrent)
+                return;
+            fire(iDue, aExpired);
+            for (;;)
+            {
+                std::optional<std::size_t> nextLevel;
+                std::size_t nextSlot = 0u;
+                for (std::size_t l = 0u; l < levels && !nextLevel; ++l)
+                    if (auto const slot = next_occupied(l))
+                        nextLevel = l, nextSlot = *slot;
+                if (!nextLevel || slot_start(*nextLevel, nextSlot) > target)
+                    break;
+                iCurrent = slot_start(*nextLevel, nextSlot);
+                auto& l = (*iLevels)[*nextLevel];
+                l.occupied[nextSlot / 64u] &= ~(std::uint64_t{ 1u } << (nextSlot % 64u));
+                iCascade.swap(l.slots[nextSlot]);
+                for (auto& e : iCascade)
+                    place(std::move(e));
+                iCascade.clear();
+                fire(iDue, aExpired);
+            }
+            iCurrent = target;
+        }
+    private:
+        static std::uint64_t key(time_type aTime)
+        {
+            if constexpr (std::is_signed_v<time_type>)
+                return static_cast<std::uint64_t>(static_cast<std::int64_t>(aTime)) ^ (std::uint64_t{ 1u } << 63u);
+            else
+                return static_cast<std::uint64_t>(aTime);
+        }
+        static time_type from_key(std::uint64_t aKey)
+        {
+            if constexpr (std::is_signed_v<time_type>)
+                return static_cast<time_type>(static_cast<std::int64_t>(aKey ^ (std::uint64_t{ 1u } << 63u)));
+            else
+                return static_cast<time_type>(aKey);
+        }
+        std::uint64_t slot_start(std::size_t aLevel, std::size_t aSlot) const
+        {
+            auto const shift = aLevel * 8u;
+            auto const above = shift + 8u < 64u ? (iCurrent >> (shift + 8u)) << (shift + 8u) : 0u;
+            return above | (static_cast<std::uint64_t>(aSlot) << shift);
+        }
+        std::optional<std::size_t> next_occupied(std::size_t aLevel) const
+        {
+            auto const& occupied = (*iLevels)[aLevel].occupied;
+            std::size_t const first = ((iCurrent >> (aLevel * 8u)) & 0xFFu) + 1u;
+            for (std::size_t word = first / 64u; word < occupied.size(); ++word)
+            {
+                auto bits = occupied[word];
+                if (word == first / 64u)
+                    bits &= first % 64u == 0u ? ~std::uint64_t{} : ~((std::uint64_t{ 1u } << (first % 64u)) - 1u);
+                if (bits != 0u)
+                    return word * 64u + static_cast<std::size_t>(std::countr_zero(bits));
+            }
+            return {};
+        }
+        void place(entry&& aEntry)
+        {
+            auto const expiry = key(aEntry.expiry);
+            if (expiry <= iCurrent)
+            {
+                iDue.push_back(std::move(aEntry));
+                return;
+            }
+            auto const level = static_cast<std::size_t>(std::bit_width(expiry ^ iCurrent) - 1) / 8u;
+            auto const slot = static_cast<std::size_t>((expiry >> (level * 8u)) & 0xFFu);
+            auto& l = (*iLevels)[level];
+            l.slots[slot].push_back(std::move(aEntry));
+            l.occupied[slot / 64u] |= std::uint64_t{ 1u } << (slot % 64u);
+        }
+        template <typename Callable>
+        void fire(std::vector<entry>& aEntries, Callable& aExpired)
+        {
+            iSize -= aEntries.size();
+            iFiring.swap(aEntries);
+            for (auto const& e : iFiring)
+                aExpired(e);
+            iFiring.clear();
+        }
+    private:
+        std::uint64_t iCurrent;
+        std::unique_ptr<std::array<level, levels>> iLevels;
+        std::size_t iSize;
+        std::vector<entry> iDue;
+        std::vector<entry> iCascade;
+        std::vector<entry> iFiring;
+    };
+}
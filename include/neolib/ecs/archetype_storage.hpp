@@ -0,0 +1,383 @@
+// archetype_storage.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <array>
+#include <vector>
+#include <memory>
+#include <new>
+#include <span>
+#include <utility>
+#include <neolib/ecs/ecs_ids.hpp>
+#include <neolib/ecs/i_ecs.hpp>
+#include <neolib/ecs/i_entity_archetype.hpp>
+#include <neolib/ecs/i_archetype_storage.hpp>
+
+namespace neolib::ecs
+{
+    constexpr std::size_t default_archetype_chunk_size = 16u * 1024u;
+    constexpr std::size_t archetype_chunk_column_alignment = 64u;
+
+    // Entities sharing exactly the same component set (as described by an entity archetype)
+    // stored in fixed-size chunks; each chunk holds one contiguous column per component so
+    // iterating several components of the same entity touches adjacent cache lines rather than
+    // chasing a reverse index per component.
+    // This is a container alongside the ECS rather than a storage mode of it: the only integration
+    // is that destroying an entity removes its row here. Records stored here are not visible
+    // through component<Data>, views, systems or the system scheduler, snapshots, has_component
+    // and entity signatures, or save_world; access them through this storage only.
+    template <std::size_t ChunkSize, typename... ComponentData>
+    class basic_archetype_storage : public i_archetype_storage
+    {
+        static_assert(sizeof...(ComponentData) > 0, "neolib::ecs::archetype_storage: no components");
+        static_assert((std::is_same_v<ComponentData, ecs_data_type_t<ComponentData>> && ...), "neolib::ecs::archetype_storage: component data must not be cv/ref qualified");
+    public:
+        struct entity_record_not_found : std::logic_error { entity_record_not_found() : std::logic_error("neolib::ecs::archetype_storage::entity_record_not_found") {} };
+        struct entity_record_exists : std::logic_error { entity_record_exists() : std::logic_error("neolib::ecs::archetype_storage::entity_record_exists") {} };
+        struct archetype_mismatch : std::logic_error { archetype_mismatch() : std::logic_error("neolib::ecs::archetype_storage::archetype_mismatch") {} };
+    public:
+        static constexpr std::size_t column_count = sizeof...(ComponentData) + 1u;
+        static constexpr std::size_t row_size = sizeof(entity_id) + (sizeof(ComponentData) + ...);
+        static constexpr std::size_t chunk_capacity = 
+            ChunkSize > row_size + archetype_chunk_column_alignment * column_count ? 
+                (ChunkSize - archetype_chunk_column_alignment * column_count) / row_size : 1u;
+    private:
+        static constexpr std::size_t align_column(std::size_t aOffset)
+        {
+            return (aOffset + archetype_chunk_column_alignment - 1u) & ~(archetype_chunk_column_alignment - 1u);
+        }
+        static constexpr std::array<std::size_t, column_count + 1u> compute_column_offsets()
+        {
+            std::array<std::size_t, column_count + 1u> result = {};
+            std::array<std::size_t, column_count> const sizes = { sizeof(entity_id), sizeof(ComponentData)... };
+            for (std::size_t column = 0u; column < column_count; ++column)
+                result[column + 1u] = align_column(result[column] + sizes[column] * chunk_capacity);
+            return result;
+        }
+        static constexpr std::array<std::size_t, column_count + 1u> column_offsets = compute_column_offsets();
+    public:
+        static constexpr std::size_t chunk_bytes = column_offsets[column_count];
+    public:
+        class chunk
+        {
+            friend class basic_archetype_storage;
+        public:
+            static constexpr std::size_t capacity = chunk_capacity;
+        public:
+            chunk() :
+                iStorage{ static_cast<std::byte*>(::operator new(chunk_bytes, std::align_val_t{ archetype_chunk_column_alignment })) }
+            {
+            }
+            ~chunk()
+            {
+                (destroy_column<ComponentData>(), ...);
+                ::operator delete(iStorage, std::align_val_t{ archetype_chunk_column_alignment });
+            }
+            chunk(chunk const&) = delete;
+            chunk& operator=(chunk const&) = delete;
+        public:
+            std::size_t size() const
+            {
+                return iSize;
+            }
+            bool empty() const
+            {
+                return iSize == 0u;
+            }
+            bool full() const
+            {
+                return iSize == capacity;
+            }
+        public:
+            std::span<entity_id const> entities() const
+            {
+                return std::span<entity_id const>{ entity_column(), iSize };
+            }
+            template <typename Data>
+            std::span<Data const> column() const
+            {
+                return std::span<Data const>{ column_data<Data>(), iSize };
+            }
+            template <typename Data>
+            std::span<Data> column()
+            {
+                return std::span<Data>{ column_data<Data>(), iSize };
+            }
+        private:
+            entity_id* entity_column() const
+            {
+                return reinterpret_cast<entity_id*>(iStorage);
+            }
+            template <typename Data>
+            Data* column_data() const
+            {
+                return std::launder(reinterpret_cast<Data*>(iStorage + column_offsets[index_of_v<Data, ComponentData...> + 1u]));
+            }
+            template <typename Data>
+            void destroy_column()
+            {
+                if constexpr (!std::is_trivially_destructible_v<Data>)
+                    std::destroy_n(column_data<Data>(), iSize);
+            }
+        private:
+            std::byte* iStorage;
+            std::size_t iSize = 0u;
+        };
+        typedef std::vector<std::unique_ptr<chunk>> chunk_list;
+    private:
+        struct location
+        {
+            std::uint32_t chunk;
+            std::uint32_t row;
+        };
+        static constexpr location invalid = { ~std::uint32_t{}, ~std::uint32_t{} };
+    public:
+        basic_archetype_storage(i_ecs& aEcs, const i_entity_archetype& aArchetype) :
+            iEcs{ aEcs }, iArchetypeId{ aArchetype.id() }
+        {
+            std::array<component_id, sizeof...(ComponentData)> const ids = { ComponentData::meta::id()... };
+            if (aArchetype.components().size() != ids.size())
+                throw archetype_mismatch();
+            for (auto const& id : ids)
+                if (aArchetype.components().find(id) == aArchetype.components().end())
+                    throw archetype_mismatch();
+            if (!ecs().archetype_registered(aArchetype))
+                ecs().register_archetype(aArchetype);
+            ecs().register_archetype_storage(*this);
+        }
+        ~basic_archetype_storage()
+        {
+            ecs().unregister_archetype_storage(*this);
+        }
+        basic_archetype_storage(basic_archetype_storage const&) = delete;
+        basic_archetype_storage& operator=(basic_archetype_storage const&) = delete;
+    public:
+        i_ecs& ecs() const final
+        {
+            return iEcs;
+        }
+        const entity_archetype_id& archetype_id() const final
+        {
+            return iArchetypeId;
+        }
+    public:
+        ecs_mutex<basic_archetype_storage>& mutex() const final
+        {
+            return iMutex;
+        }
+    public:
+        std::size_t size() const final
+        {
+            return iSize;
+        }
+        std::size_t chunk_count() const final
+        {
+            return iChunks.size();
+        }
+        const chunk_list& chunks() const
+        {
+            return iChunks;
+        }
+        bool has_entity_record_no_lock(entity_id aEntity) const final
+        {
+            return iLocations.size() > aEntity && iLocations[aEntity].chunk != invalid.chunk;
+        }
+        bool has_entity_record(entity_id aEntity) const final
+        {
+            std::scoped_lock<ecs_mutex<basic_archetype_storage>> lock{ mutex() };
+            return has_entity_record_no_lock(aEntity);
+        }
+        template <typename Data>
+        const Data& entity_record_no_lock(entity_id aEntity) const
+        {
+            auto const& where = find(aEntity);
+            return iChunks[where.chunk]->template column_data<Data>()[where.row];
+        }
+        template <typename Data>
+        Data& entity_record_no_lock(entity_id aEntity)
+        {
+            return const_cast<Data&>(to_const(*this).template entity_record_no_lock<Data>(aEntity));
+        }
+        template <typename Data>
+        const Data& entity_record(entity_id aEntity) const
+        {
+            std::scoped_lock<ecs_mutex<basic_archetype_storage>> lock{ mutex() };
+            return entity_record_no_lock<Data>(aEntity);
+        }
+        template <typename Data>
+        Data& entity_record(entity_id aEntity)
+        {
+            std::scoped_lock<ecs_mutex<basic_archetype_storage>> lock{ mutex() };
+            return entity_record_no_lock<Data>(aEntity);
+        }
+    public:
+        template <typename... Data>
+        entity_id create_entity(Data&&... aComponentData)
+        {
+            auto const newEntity = ecs().create_entity(archetype_id());
+            try
+            {
+                populate(newEntity, std::forward<Data>(aComponentData)...);
+            }
+            catch (...)
+            {
+                ecs().destroy_entity(newEntity);
+                throw;
+            }
+            return newEntity;
+        }
+        template <typename... Data>
+        void populate(entity_id aEntity, Data&&... aComponentData)
+        {
+            static_assert(sizeof...(Data) == sizeof...(ComponentData), "neolib::ecs::archetype_storage: all archetype components must be supplied");
+            std::scoped_lock<ecs_mutex<basic_archetype_storage>> lock{ mutex() };
+            if (has_entity_record_no_lock(aEntity))
+                throw entity_record_exists();
+            if (iLocations.size() <= aEntity)
+                iLocations.resize(aEntity + 1u, invalid);
+            bool const newChunk = iChunks.empty() || iChunks.back()->full();
+            if (newChunk)
+                iChunks.push_back(std::make_unique<chunk>());
+            auto& target = *iChunks.back();
+            auto const row = target.iSize;
+            try
+            {
+                construct_row(target, row, std::forward<Data>(aComponentData)...);
+            }
+            catch (...)
+            {
+                if (newChunk)
+                    iChunks.pop_back();
+                throw;
+            }
+            target.entity_column()[row] = aEntity;
+            ++target.iSize;
+            ++iSize;
+            iLocations[aEntity] = location{ static_cast<std::uint32_t>(iChunks.size() - 1u), static_cast<std::uint32_t>(row) };
+        }
+        void destroy_entity_record(entity_id aEntity) final
+        {
+            std::scoped_lock<ecs_mutex<basic_archetype_storage>> lock{ mutex() };
+            destroy_entity_record_no_lock(aEntity);
+        }
+        void destroy_entity_records(std::span<entity_id const> aEntities) final
+        {
+            std::scoped_lock<ecs_mutex<basic_archetype_storage>> lock{ mutex() };
+            for (auto entity : aEntities)
+                if (has_entity_record_no_lock(entity))
+                    destroy_entity_record_no_lock(entity);
+        }
+        void destroy_entity_record_no_lock(entity_id aEntity)
+        {
+            auto const where = find(aEntity);
+            auto& hole = *iChunks[where.chunk];
+            auto& tail = *iChunks.back();
+            auto const tailRow = tail.iSize - 1u;
+            if (&hole != &tail || where.row != tailRow)
+            {
+                ((hole.template column_data<ComponentData>()[where.row] = std::move(tail.template column_data<ComponentData>()[tailRow])), ...);
+                auto const movedEntity = tail.entity_column()[tailRow];
+                hole.entity_column()[where.row] = movedEntity;
+                iLocations[movedEntity] = where;
+            }
+            (std::destroy_at(&tail.template column_data<ComponentData>()[tailRow]), ...);
+            --tail.iSize;
+            --iSize;
+            iLocations[aEntity] = invalid;
+            if (tail.empty() && iChunks.size() > 1u)
+                iChunks.pop_back();
+        }
+    public:
+        template <typename Callable>
+        void apply(const Callable& aCallable)
+        {
+            std::scoped_lock<ecs_mutex<basic_archetype_storage>> lock{ mutex() };
+            for (auto& c : iChunks)
+            {
+                auto const entities = c->entity_column();
+                auto const columns = std::make_tuple(c->template column_data<ComponentData>()...);
+                for (std::size_t row = 0u; row < c->size(); ++row)
+                    std::apply([&](auto... column) { aCallable(entities[row], column[row]...); }, columns);
+            }
+        }
+        template <typename Callable>
+        void apply_chunks(const Callable& aCallable)
+        {
+            std::scoped_lock<ecs_mutex<basic_archetype_storage>> lock{ mutex() };
+            for (auto& c : iChunks)
+                aCallable(*c);
+        }
+    private:
+        const location& find(entity_id aEntity) const
+        {
+            if (!has_entity_record_no_lock(aEntity))
+                throw entity_record_not_found();
+            return iLocations[aEntity];
+        }
+        // Constructs the row's columns in order; if a constructor throws the columns already constructed
+        // are destroyed before the exception propagates.
+        template <typename... Data>
+        static void construct_row(chunk& aChunk, std::size_t aRow, Data&&... aComponentData)
+        {
+            std::size_t constructed = 0u;
+            try
+            {
+                ((std::construct_at(aChunk.template column_data<ComponentData>() + aRow, std::forward<Data>(aComponentData)), ++constructed), ...);
+            }
+            catch (...)
+            {
+                destroy_row(aChunk, aRow, constructed, std::index_sequence_for<ComponentData...>{});
+                throw;
+            }
+        }
+        template <std::size_t... Column>
+        static void destroy_row(chunk& aChunk, std::size_t aRow, std::size_t aColumns, std::index_sequence<Column...>)
+        {
+            ((Column < aColumns ? std::destroy_at(aChunk.template column_data<ComponentData>() + aRow) : void()), ...);
+        }
+    private:
+        mutable ecs_mutex<basic_archetype_storage> iMutex;
+        i_ecs& iEcs;
+        entity_archetype_id iArchetypeId;
+        chunk_list iChunks;
+        std::vector<location> iLocations;
+        std::size_t iSize = 0u;
+    };
+
+    template <typename... ComponentData>
+    using archetype_storage = basic_archetype_storage<default_archetype_chunk_size, ComponentData...>;
+}
@@ -0,0 +1,441 @@
+// command_buffer.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+#include <neolib/ecs/ecs_ids.hpp>
+#include <neolib/ecs/i_ecs.hpp>
+#include <neolib/ecs/i_entity_archetype.hpp>
+#include <neolib/ecs/component.hpp>
+
+namespace neolib::ecs
+{
+    class command_buffer;
+    class command_buffers;
+
+    enum class command : std::uint32_t
+    {
+        CreateEntity,
+        Populate,
+        RemoveComponent,
+        DestroyEntity
+    };
+
+    struct command_record
+    {
+        entity_id entity;
+        std::uint64_t sequence;
+        void* payload;
+    };
+
+    // Type-erased operations for a component type referenced by recorded commands.
+    struct command_component_traits
+    {
+        void (*populate)(i_ecs& aEcs, std::span<entity_id const> aEntities, std::span<command_record const> aRecords);
+        void (*remove)(i_ecs& aEcs, std::span<entity_id const> aEntities);
+        void (*destroy)(void* aPayload);
+    };
+
+    template <typename Data>
+    inline const command_component_traits& command_traits()
+    {
+        static const command_component_traits sTraits
+        {
+            [](i_ecs& aEcs, std::span<entity_id const> aEntities, std::span<command_record const> aRecords)
+            {
+                aEcs.component<Data>().populate_from(aEntities, [&](std::size_t aIndex) -> Data&&
+                {
+                    return std::move(*static_cast<Data*>(aRecords[aIndex].payload));
+                });
+            },
+            [](i_ecs& aEcs, std::span<entity_id const> aEntities)
+            {
+                if (aEcs.component_instantiated<Data>())
+                    aEcs.component<Data>().destroy_entity_records(aEntities);
+            },
+            [](void* aPayload)
+            {
+                static_cast<Data*>(aPayload)->~Data();
+            }
+        };
+        return sTraits;
+    }
+
+    // Records structural changes in a compact binary form for later application by command_buffers::commit().
+    // Records are written into fixed blocks that are kept when the buffer is cleared, so recording does not
+    // allocate once the buffer has grown to its working size. A buffer must only be used by one thread at a
+    // time; obtain a per-thread buffer with command_buffers::local().
+    class command_buffer
+    {
+        friend class command_buffers;
+    public:
+        static constexpr std::size_t record_alignment = alignof(std::max_align_t);
+        static constexpr std::size_t block_size = 64u * 1024u;
+    private:
+        struct header
+        {
+            command op;
+            std::uint32_t size;
+            entity_id entity;
+            command_component_traits const* traits;
+        };
+        static constexpr std::size_t payload_offset = (sizeof(header) + record_alignment - 1u) / record_alignment * record_alignment;
+        struct block
+        {
+            std::unique_ptr<std::byte[]> data;
+            std::size_t capacity;
+            std::size_t used;
+        };
+    public:
+        command_buffer(i_ecs& aEcs) :
+            iEcs{ aEcs }, iBlock{ 0u }, iCount{ 0u }
+        {
+        }
+        ~command_buffer()
+        {
+            discard();
+        }
+        command_buffer(const command_buffer&) = delete;
+        command_buffer& operator=(const command_buffer&) = delete;
+    public:
+        i_ecs& ecs() const
+        {
+            return iEcs;
+        }
+        bool empty() const
+        {
+            return iCount == 0u;
+        }
+        std::size_t size() const
+        {
+            return iCount;
+        }
+    public:
+        // The entity id is reserved immediately so that it can be referred to by later commands; the entity
+        // comes into existence when the buffer is committed.
+        entity_id create_entity(const entity_archetype_id& aArchetypeId)
+        {
+            auto const newEntity = iEcs.next_entity_id();
+            try
+            {
+                record(command::CreateEntity, newEntity, nullptr, sizeof(entity_archetype_id), [&](void* aPayload) { new (aPayload) entity_archetype_id{ aArchetypeId }; });
+            }
+            catch (...)
+            {
+                iEcs.free_entity_id(newEntity);
+                throw;
+            }
+            return newEntity;
+        }
+        template <typename Archetype>
+        entity_id create_entity(const Archetype& aArchetype)
+        {
+            if (!iEcs.archetype_registered(aArchetype))
+                iEcs.register_archetype(aArchetype);
+            return create_entity(aArchetype.id());
+        }
+        template <typename Archetype, typename... ComponentData>
+        entity_id create_entity(const Archetype& aArchetype, ComponentData&&... aComponentData)
+        {
+            auto const newEntity = create_entity(aArchetype);
+            (populate(newEntity, std::forward<ComponentData>(aComponentData)), ...);
+            return newEntity;
+        }
+        template <typename ComponentData>
+        void populate(entity_id aEntity, ComponentData&& aComponentData)
+        {
+            typedef ecs_data_type_t<ComponentData> data_type;
+            static_assert(alignof(data_type) <= record_alignment, "neolib::ecs::command_buffer: over-aligned component data");
+            record(command::Populate, aEntity, &command_traits<data_type>(), sizeof(data_type), [&](void* aPayload)
+            {
+                new (aPayload) data_type{ std::forward<ComponentData>(aComponentData) };
+            });
+        }
+        template <typename ComponentData>
+        void remove_component(entity_id aEntity)
+        {
+            record(command::RemoveComponent, aEntity, &command_traits<ecs_data_type_t<ComponentData>>(), 0u, [](void*) {});
+        }
+        void destroy_entity(entity_id aEntity)
+        {
+            record(command::DestroyEntity, aEntity, nullptr, 0u, [](void*) {});
+        }
+    private:
+        // The payload is constructed before the record is counted so a throwing constructor leaves the
+        // buffer unchanged.
+        template <typename Construct>
+        void record(command aOp, entity_id aEntity, command_component_traits const* aTraits, std::size_t aPayloadSize, Construct&& aConstruct)
+        {
+            auto const size = (payload_offset + aPayloadSize + record_alignment - 1u) / record_alignment * record_alignment;
+            for (;; ++iBlock)
+            {
+                if (iBlock == iBlocks.size())
+                    iBlocks.push_back(make_block(size));
+                auto& b = iBlocks[iBlock];
+                if (b.used == 0u && b.capacity < size)
+                    b = make_block(size);
+                if (b.capacity - b.used >= size)
+                {
+                    auto const start = b.data.get() + b.used;
+                    aConstruct(start + payload_offset);
+                    new (start) header{ aOp, static_cast<std::uint32_t>(size), aEntity, aTraits };
+                    b.used += size;
+                    ++iCount;
+                    return;
+                }
+            }
+        }
+        static block make_block(std::size_t aMinimumSize)
+        {
+            auto const capacity = std::max(block_size, aMinimumSize);
+            return block{ std::unique_ptr<std::byte[]>{ new std::byte[capacity] }, capacity, 0u };
+        }
+        template <typename Visitor>
+        void for_each(const Visitor& aVisitor) const
+        {
+            for (std::size_t blockIndex = 0u; blockIndex < iBlocks.size() && blockIndex <= iBlock; ++blockIndex)
+            {
+                auto const& b = iBlocks[blockIndex];
+                for (std::size_t offset = 0u; offset < b.used;)
+                {
+                    auto const& h = *reinterpret_cast<header const*>(b.data.get() + offset);
+                    aVisitor(h, b.data.get() + offset + payload_offset);
+                    offset += h.size;
+                }
+            }
+        }
+        void clear()
+        {
+            for (std::size_t blockIndex = 0u; blockIndex < iBlocks.size() && blockIndex <= iBlock; ++blockIndex)
+                iBlocks[blockIndex].used = 0u;
+            iBlock = 0u;
+            iCount = 0u;
+        }
+        // Drops uncommitted commands, releasing reserved entity ids and destroying recorded component data.
+        void discard()
+        {
+            for_each([&](header const& aHeader, void* aPayload)
+            {
+                if (aHeader.op == command::CreateEntity)
+                    iEcs.free_entity_id(aHeader.entity);
+                else if (aHeader.op == command::Populate)
+                    aHeader.traits->destroy(aPayload);
+            });
+            clear();
+        }
+    private:
+        i_ecs& iEcs;
+        std::vector<block> iBlocks;
+        std::size_t iBlock;
+        std::size_t iCount;
+    };
+
+    // Owns one command_buffer per recording thread and applies them all at a sync point. commit() groups the
+    // recorded commands by kind and component, orders each group by entity and applies it with one lock of
+    // the affected component: entity creations first, then component data, then archetype default components,
+    // then component removals and finally entity destruction. Of the populate and remove commands recorded for
+    // the same entity and component only the last one recorded is applied.
+    class command_buffers
+    {
+    private:
+        struct pending
+        {
+            command_component_traits const* traits;
+            entity_id entity;
+            std::uint64_t sequence;
+            void* payload;
+        };
+        struct pending_creation
+        {
+            entity_archetype_id archetype;
+            entity_id entity;
+        };
+    public:
+        command_buffers(i_ecs& aEcs) :
+            iEcs{ aEcs }, iId{ next_id() }
+        {
+        }
+        command_buffers(const command_buffers&) = delete;
+        command_buffers& operator=(const command_buffers&) = delete;
+    public:
+        i_ecs& ecs() const
+        {
+            return iEcs;
+        }
+        command_buffer& local()
+        {
+            thread_local std::vector<std::pair<std::uint64_t, command_buffer*>> tBuffers;
+            for (auto const& b : tBuffers)
+                if (b.first == iId)
+                    return *b.second;
+            std::scoped_lock lock{ iMutex };
+            auto& newBuffer = *iBuffers.emplace_back(std::make_unique<command_buffer>(iEcs));
+            std::erase_if(tBuffers, [&](auto const& b) { return b.second == &newBuffer; });
+            tBuffers.emplace_back(iId, &newBuffer);
+            return newBuffer;
+        }
+        // Must not run concurrently with recording into any of the buffers.
+        void commit()
+        {
+            std::scoped_lock lock{ iMutex };
+            iCreations.clear();
+            iComponentCommands.clear();
+            iPopulates.clear();
+            iRemovals.clear();
+            iDestructions.clear();
+            std::uint64_t sequence = 0u;
+            for (auto& buffer : iBuffers)
+                buffer->for_each([&](command_buffer::header const& aHeader, void* aPayload)
+                {
+                    switch (aHeader.op)
+                    {
+                    case command::CreateEntity:
+                        iCreations.push_back({ *static_cast<entity_archetype_id const*>(aPayload), aHeader.entity });
+                        break;
+                    case command::Populate:
+                        iComponentCommands.push_back({ aHeader.traits, aHeader.entity, sequence, aPayload });
+                        break;
+                    case command::RemoveComponent:
+                        iComponentCommands.push_back({ aHeader.traits, aHeader.entity, sequence, nullptr });
+                        break;
+                    case command::DestroyEntity:
+                        iDestructions.push_back(aHeader.entity);
+                        break;
+                    }
+                    ++sequence;
+                });
+            struct cleanup
+            {
+                command_buffers& owner;
+                ~cleanup()
+                {
+                    for (auto const& c : owner.iComponentCommands)
+                        if (c.payload != nullptr)
+                            c.traits->destroy(c.payload);
+                    owner.iComponentCommands.clear();
+                    owner.iPopulates.clear();
+                    for (auto& buffer : owner.iBuffers)
+                        buffer->clear();
+                }
+            } guard{ *this };
+            auto const byTraitsThenEntity = [](pending const& aLhs, pending const& aRhs)
+            {
+                return std::tie(aLhs.traits, aLhs.entity, aLhs.sequence) < std::tie(aRhs.traits, aRhs.entity, aRhs.sequence);
+            };
+            std::sort(iCreations.begin(), iCreations.end(), [](pending_creation const& aLhs, pending_creation const& aRhs)
+            {
+                return std::tie(aLhs.archetype, aLhs.entity) < std::tie(aRhs.archetype, aRhs.entity);
+            });
+            for_each_group(iCreations, [](auto const& aLhs, auto const& aRhs) { return aLhs.archetype == aRhs.archetype; }, [&](auto aFirst, auto aLast)
+            {
+                gather(aFirst, aLast);
+                iEcs.commit_entities(aFirst->archetype, iEntities);
+            });
+            std::sort(iComponentCommands.begin(), iComponentCommands.end(), byTraitsThenEntity);
+            for_each_group(iComponentCommands, [](auto const& aLhs, auto const& aRhs) { return aLhs.traits == aRhs.traits && aLhs.entity == aRhs.entity; }, [&](auto, auto aLast)
+            {
+                auto const& last = *std::prev(aLast);
+                (last.payload != nullptr ? iPopulates : iRemovals).push_back(last);
+            });
+            for_each_group(iPopulates, [](auto const& aLhs, auto const& aRhs) { return aLhs.traits == aRhs.traits; }, [&](auto aFirst, auto aLast)
+            {
+                gather(aFirst, aLast);
+                iRecords.clear();
+                for (auto p = aFirst; p != aLast; ++p)
+                    iRecords.push_back({ p->entity, p->sequence, p->payload });
+                aFirst->traits->populate(iEcs, iEntities, iRecords);
+            });
+            for_each_group(iCreations, [](auto const& aLhs, auto const& aRhs) { return aLhs.archetype == aRhs.archetype; }, [&](auto aFirst, auto aLast)
+            {
+                gather(aFirst, aLast);
+                iEcs.archetype(aFirst->archetype).populate_default_components(iEcs, std::span<entity_id const>{ iEntities });
+            });
+            for_each_group(iRemovals, [](auto const& aLhs, auto const& aRhs) { return aLhs.traits == aRhs.traits; }, [&](auto aFirst, auto aLast)
+            {
+                gather(aFirst, aLast);
+                aFirst->traits->remove(iEcs, iEntities);
+            });
+            std::sort(iDestructions.begin(), iDestructions.end());
+            iDestructions.erase(std::unique(iDestructions.begin(), iDestructions.end()), iDestructions.end());
+            std::erase_if(iDestructions, [&](entity_id aEntity) { return (iEcs.entity_generation(aEntity) & 1u) == 0u; });
+            iEcs.destroy_entities(iDestructions);
+        }
+    private:
+        static std::uint64_t next_id()
+        {
+            static std::atomic<std::uint64_t> sNextId = 1u;
+            return sNextId++;
+        }
+        template <typename Container, typename Same, typename Apply>
+        static void for_each_group(Container const& aContainer, const Same& aSame, const Apply& aApply)
+        {
+            for (auto first = aContainer.begin(); first != aContainer.end();)
+            {
+                auto last = std::next(first);
+                while (last != aContainer.end() && aSame(*first, *last))
+                    ++last;
+                aApply(first, last);
+                first = last;
+            }
+        }
+        template <typename Iter>
+        void gather(Iter aFirst, Iter aLast)
+        {
+            iEntities.clear();
+            for (auto i = aFirst; i != aLast; ++i)
+                iEntities.push_back(i->entity);
+        }
+    private:
+        i_ecs& iEcs;
+        std::uint64_t const iId;
+        std::mutex iMutex;
+        std::vector<std::unique_ptr<command_buffer>> iBuffers;
+        std::vector<pending_creation> iCreations;
+        std::vector<pending> iComponentCommands;
+        std::vector<pending> iPopulates;
+        std::vector<pending> iRemovals;
+        std::vector<entity_id> iDestructions;
+        std::vector<entity_id> iEntities;
+        std::vector<command_record> iRecords;
+    };
+}
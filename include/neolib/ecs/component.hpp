@@ -37,10 +37,17 @@
 
 #include <neolib/neolib.hpp>
 #include <atomic>
+#include <cstring>
+#include <memory>
+#include <optional>
 #include <vector>
-#include <unordered_map>
+#include <deque>
 #include <string>
+#include <string_view>
+#include <boost/unordered/unordered_flat_map.hpp>
 #include <neolib/core/intrusive_sort.hpp>
+#include <neolib/core/radix_sort.hpp>
+#include <neolib/core/epoch_domain.hpp>
 #include <neolib/task/thread_pool.hpp>
 #include <neolib/ecs/ecs_ids.hpp>
 #include <neolib/ecs/i_ecs.hpp>
@@ -68,6 +75,78 @@ namespace neolib::ecs
         return batchable(*lhs.ptr(), *rhs.ptr());
     }
 
+    // Shared component name with its hash computed once, for repeated lookups of the same name. One-off
+    // lookups can pass a std::string_view instead, which is hashed without copying the name.
+    class shared_key
+    {
+    public:
+        struct hash
+        {
+            typedef void is_transparent;
+            std::size_t operator()(std::string_view aName) const
+            {
+                return std::hash<std::string_view>{}(aName);
+            }
+            std::size_t operator()(const std::string& aName) const
+            {
+                return std::hash<std::string_view>{}(aName);
+            }
+            std::size_t operator()(const shared_key& aKey) const
+            {
+                return aKey.hash_value();
+            }
+        };
+        struct equal_to
+        {
+            typedef void is_transparent;
+            bool operator()(const std::string& aLhs, const std::string& aRhs) const
+            {
+                return aLhs == aRhs;
+            }
+            bool operator()(const shared_key& aLhs, const std::string& aRhs) const
+            {
+                return aLhs.name() == aRhs;
+            }
+            bool operator()(const std::string& aLhs, const shared_key& aRhs) const
+            {
+                return aLhs == aRhs.name();
+            }
+            bool operator()(std::string_view aLhs, const std::string& aRhs) const
+            {
+                return aLhs == aRhs;
+            }
+            bool operator()(const std::string& aLhs, std::string_view aRhs) const
+            {
+                return aLhs == aRhs;
+            }
+        };
+    public:
+        explicit shared_key(std::string aName) :
+            iName{ std::move(aName) }, iHash{ hash{}(iName) }
+        {
+        }
+        explicit shared_key(std::string_view aName) :
+            shared_key{ std::string{ aName } }
+        {
+        }
+        explicit shared_key(const char* aName) :
+            shared_key{ std::string{ aName } }
+        {
+        }
+    public:
+        const std::string& name() const
+        {
+            return iName;
+        }
+        std::size_t hash_value() const
+        {
+            return iHash;
+        }
+    private:
+        std::string iName;
+        std::size_t iHash;
+    };
+
     namespace detail
     {
         template <typename Data>
@@ -94,7 +173,7 @@ namespace neolib::ecs
             typedef ecs_data_type_t<Data> data_type;
             typedef data_type mapped_type;
             typedef std::pair<const std::string, mapped_type> value_type;
-            typedef std::unordered_map<std::string, mapped_type> container_type;
+            typedef std::deque<value_type> container_type;
             static constexpr bool optional = false;
         };
 
@@ -104,7 +183,7 @@ namespace neolib::ecs
             typedef ecs_data_type_t<Data> data_type;
             typedef std::optional<data_type> mapped_type;
             typedef std::pair<const std::string, mapped_type> value_type;
-            typedef std::unordered_map<std::string, mapped_type> container_type;
+            typedef std::deque<value_type> container_type;
             static constexpr bool optional = true;
         };
     }
@@ -204,6 +283,145 @@ namespace neolib::ecs
         component_data_t iComponentData;
     };
 
+    // Immutable point-in-time copy of a component's records. Storage is split into pages that are
+    // shared with the previous generation when unmodified so taking a snapshot only copies dirty pages.
+    // The owning component can mark records dead (when they are destroyed) without taking a new snapshot;
+    // lookups, for_each() and size() exclude dead records. Index access (operator[] and entity()) ranges
+    // over [0, extent()) and includes dead records: skip those for which live() is false.
+    template <typename Data>
+    class component_snapshot
+    {
+    public:
+        struct entity_record_not_found : std::logic_error { entity_record_not_found() : std::logic_error("neolib::component_snapshot::entity_record_not_found") {} };
+    public:
+        typedef typename detail::crack_component_data<Data>::value_type value_type;
+        typedef std::size_t reverse_index_t;
+        typedef uint64_t version_t;
+        static constexpr std::size_t page_size = 1024u;
+        struct page
+        {
+            std::vector<value_type> data;
+            std::vector<entity_id> entities;
+        };
+        typedef std::vector<reverse_index_t> index_page;
+        typedef std::shared_ptr<page const> page_pointer;
+        typedef std::shared_ptr<index_page const> index_page_pointer;
+        typedef std::vector<page_pointer> pages_t;
+        typedef std::vector<index_page_pointer> index_pages_t;
+    private:
+        static constexpr reverse_index_t invalid = ~reverse_index_t{};
+    public:
+        component_snapshot(version_t aVersion, std::size_t aSize, pages_t&& aPages, index_pages_t&& aIndexPages) :
+            iVersion{ aVersion }, 
+            iSize{ aSize }, 
+            iPages{ std::move(aPages) }, 
+            iIndexPages{ std::move(aIndexPages) },
+            iDead{ new std::atomic<std::uint64_t>[(iIndexPages.size() * page_size + 63u) / 64u]{} },
+            iDeadCount{ 0u }
+        {
+        }
+    public:
+        version_t version() const
+        {
+            return iVersion;
+        }
+        std::size_t size() const
+        {
+            return iSize - iDeadCount.load(std::memory_order_acquire);
+        }
+        std::size_t extent() const
+        {
+            return iSize;
+        }
+        bool empty() const
+        {
+            return size() == 0u;
+        }
+        const pages_t& pages() const
+        {
+            return iPages;
+        }
+        const index_pages_t& index_pages() const
+        {
+            return iIndexPages;
+        }
+    public:
+        entity_id entity(std::size_t aIndex) const
+        {
+            return iPages[aIndex / page_size]->entities[aIndex % page_size];
+        }
+        const value_type& operator[](std::size_t aIndex) const
+        {
+            return iPages[aIndex / page_size]->data[aIndex % page_size];
+        }
+        bool live(std::size_t aIndex) const
+        {
+            return iDeadCount.load(std::memory_order_acquire) == 0u || !dead(entity(aIndex));
+        }
+        reverse_index_t reverse_index(entity_id aEntity) const
+        {
+            auto const reverseIndex = live_reverse_index(aEntity);
+            return reverseIndex != invalid && !dead(aEntity) ? reverseIndex : invalid;
+        }
+        bool has_entity_record(entity_id aEntity) const
+        {
+            return reverse_index(aEntity) != invalid;
+        }
+        const value_type& entity_record(entity_id aEntity) const
+        {
+            auto const reverseIndex = reverse_index(aEntity);
+            if (reverseIndex == invalid)
+                throw entity_record_not_found();
+            return (*this)[reverseIndex];
+        }
+        // As entity_record(); kept for callers written against the component copy that scoped_snapshot
+        // used to expose. A snapshot is immutable so no lock is needed either way.
+        const value_type& entity_record_no_lock(entity_id aEntity) const
+        {
+            return entity_record(aEntity);
+        }
+        template <typename Callable>
+        void for_each(const Callable& aCallable) const
+        {
+            bool const anyDead = iDeadCount.load(std::memory_order_acquire) != 0u;
+            for (auto const& p : iPages)
+                for (std::size_t index = 0u; index < p->data.size(); ++index)
+                    if (!anyDead || !dead(p->entities[index]))
+                        aCallable(p->entities[index], p->data[index]);
+        }
+    public:
+        // Called by the owning component (under its lock) when aEntity's record is destroyed.
+        void mark_dead(entity_id aEntity) const
+        {
+            if (live_reverse_index(aEntity) == invalid)
+                return;
+            auto const bit = std::uint64_t{ 1u } << (aEntity % 64u);
+            if ((iDead[aEntity / 64u].fetch_or(bit, std::memory_order_acq_rel) & bit) == 0u)
+                iDeadCount.fetch_add(1u, std::memory_order_release);
+        }
+    private:
+        reverse_index_t live_reverse_index(entity_id aEntity) const
+        {
+            auto const pageIndex = aEntity / page_size;
+            if (pageIndex >= iIndexPages.size())
+                return invalid;
+            auto const& indexPage = *iIndexPages[pageIndex];
+            auto const offset = aEntity % page_size;
+            return offset < indexPage.size() ? indexPage[offset] : invalid;
+        }
+        bool dead(entity_id aEntity) const
+        {
+            return (iDead[aEntity / 64u].load(std::memory_order_acquire) & (std::uint64_t{ 1u } << (aEntity % 64u))) != 0u;
+        }
+    private:
+        version_t iVersion;
+        std::size_t iSize;
+        pages_t iPages;
+        index_pages_t iIndexPages;
+        std::unique_ptr<std::atomic<std::uint64_t>[]> iDead;
+        mutable std::atomic<std::size_t> iDeadCount;
+    };
+
     template <typename Data>
     class component : public component_base<Data, i_component>
     {
@@ -219,49 +437,87 @@ namespace neolib::ecs
         typedef std::vector<entity_id> component_data_entities_t;
         typedef typename component_data_t::size_type reverse_index_t;
         typedef std::vector<reverse_index_t> reverse_indices_t;
+        static_assert(std::is_same_v<reverse_index_t, std::size_t>);
     public:
-        typedef std::unique_ptr<component> snapshot_ptr;
+        using typename i_component::not_bitwise_serializable;
+    public:
+        typedef component_snapshot<Data> snapshot_type;
+        typedef typename snapshot_type::version_t version_t;
+        typedef std::shared_ptr<snapshot_type const> snapshot_ptr;
+        // Keeps the latest snapshot alive. data() returns the paged snapshot rather than, as it once did, a
+        // component copy: component_data() and entities() are gone (use for_each() or index access up to
+        // extent()); entity_record_no_lock() is still available.
         class scoped_snapshot
         {
         public:
-            scoped_snapshot(component& aOwner) :
-                iOwner{ aOwner }
+            scoped_snapshot(const component& aOwner) :
+                iSnapshot{ aOwner.latest_snapshot() }
             {
-                ++iOwner.iUsingSnapshot;
             }
-            scoped_snapshot(const scoped_snapshot& aOther) :
-                iOwner{ aOther.iOwner }
+        public:
+            const snapshot_type& data() const
             {
-                ++iOwner.iUsingSnapshot;
+                return *iSnapshot;
             }
-            ~scoped_snapshot()
+            const snapshot_ptr& ptr() const
             {
-                --iOwner.iUsingSnapshot;
+                return iSnapshot;
             }
+        private:
+            snapshot_ptr iSnapshot;
+        };
+        // Lock-free view of the version most recently published with publish(); the version stays valid
+        // for as long as this object is alive.
+        class epoch_read
+        {
         public:
-            component& data() const
+            epoch_read(epoch_domain::read_guard&& aGuard, const snapshot_type& aData) :
+                iGuard{ std::move(aGuard) }, iData{ &aData }
             {
-                return *iOwner.iSnapshot;
+            }
+        public:
+            const snapshot_type& data() const
+            {
+                return *iData;
+            }
+            const snapshot_type* operator->() const
+            {
+                return iData;
             }
         private:
-            component& iOwner;
+            epoch_domain::read_guard iGuard;
+            const snapshot_type* iData;
         };
     private:
         static constexpr reverse_index_t invalid = ~reverse_index_t{};
+        static constexpr std::size_t page_size = snapshot_type::page_size;
+    public:
+        static constexpr std::size_t default_grain_size = 1024u;
+        static constexpr std::size_t default_parallel_sort_size = 65536u;
+    private:
+        static constexpr bool bitwise_candidate = std::is_trivially_copyable_v<value_type> && std::is_default_constructible_v<value_type> && !data_meta_type::has_handles;
     public:
         component(i_ecs& aEcs) : 
             base_type{ aEcs },
-            iHaveSnapshot{ false },
-            iUsingSnapshot{ 0u }
+            iOrdinal{ aEcs.ordinal(data_meta_type::id()) },
+            iVersion{ 1u },
+            iAllModified{ 0u },
+            iChangeTracking{ false }
         {
         }
         component(const component& aOther) :
             base_type{ aOther },
             iEntities{ aOther.iEntities },
             iReverseIndices{ aOther.iReverseIndices },
-            iHaveSnapshot{ false },
-            iUsingSnapshot{ 0u }
+            iVersion{ 1u },
+            iAllModified{ 0u },
+            iChangeTracking{ aOther.iChangeTracking }
         {
+            reset_versions();
+        }
+        ~component()
+        {
+            delete iPublished.load();
         }
     public:
         component& operator=(const component& aRhs)
@@ -269,6 +525,8 @@ namespace neolib::ecs
             base_type::operator=(aRhs);
             iEntities = aRhs.iEntities;    
             iReverseIndices = aRhs.iReverseIndices;
+            iChangeTracking = aRhs.iChangeTracking;
+            reset_versions();
             return *this;
         }
     public:
@@ -283,8 +541,24 @@ namespace neolib::ecs
         using base_type::field_type_id;
         using base_type::field_name;
     public:
-        using base_type::component_data;
-        using base_type::operator[];
+        const component_data_t& component_data() const
+        {
+            return base_type::component_data();
+        }
+        component_data_t& component_data()
+        {
+            touch_all();
+            return base_type::component_data();
+        }
+        const value_type& operator[](reverse_index_t aIndex) const
+        {
+            return base_type::component_data()[aIndex];
+        }
+        value_type& operator[](reverse_index_t aIndex)
+        {
+            touch_record(aIndex);
+            return base_type::component_data()[aIndex];
+        }
     public:
         entity_id entity(const value_type& aData) const
         {
@@ -299,6 +573,7 @@ namespace neolib::ecs
         }
         component_data_entities_t& entities()
         {
+            touch_all();
             return iEntities;
         }
         const reverse_indices_t& reverse_indices() const
@@ -307,12 +582,13 @@ namespace neolib::ecs
         }
         reverse_indices_t& reverse_indices()
         {
+            touch_all();
             return iReverseIndices;
         }
         reverse_index_t reverse_index_no_lock(entity_id aEntity) const
         {
-            if (reverse_indices().size() > aEntity)
-                return reverse_indices()[aEntity];
+            if (iReverseIndices.size() > aEntity)
+                return iReverseIndices[aEntity];
             return invalid;
         }
         bool has_entity_record_no_lock(entity_id aEntity) const final
@@ -330,7 +606,11 @@ namespace neolib::ecs
         {
             if (aCreate && !has_entity_record_no_lock(aEntity))
                 populate(aEntity, value_type{});
-            return const_cast<value_type&>(to_const(*this).entity_record_no_lock(aEntity));
+            auto reverseIndex = reverse_index_no_lock(aEntity);
+            if (reverseIndex == invalid)
+                throw entity_record_not_found();
+            touch_record(reverseIndex);
+            return base_type::component_data()[reverseIndex];
         }
         reverse_index_t reverse_index(entity_id aEntity) const
         {
@@ -352,131 +632,577 @@ namespace neolib::ecs
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
             return entity_record_no_lock(aEntity, aCreate);
         }
+        // Lookups through an entity_ref also check the generation: a stale reference has no record.
+        bool has_entity_record(entity_ref aEntity) const
+        {
+            std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            return ecs().valid(aEntity) && has_entity_record_no_lock(aEntity.id);
+        }
+        const value_type& entity_record(entity_ref aEntity) const
+        {
+            std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            return entity_record_no_lock(ecs().resolve(aEntity));
+        }
+        value_type& entity_record(entity_ref aEntity)
+        {
+            std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            return entity_record_no_lock(ecs().resolve(aEntity));
+        }
         void destroy_entity_record(entity_id aEntity) final
         {
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
-            auto reverseIndex = reverse_index(aEntity);
-            if (reverseIndex == invalid)
-                throw entity_record_not_found();
-            if constexpr (data_meta_type::has_handles)
-                data_meta_type::free_handles(base_type::component_data()[reverseIndex], ecs());
-            std::swap(base_type::component_data()[reverseIndex], base_type::component_data().back());
-            base_type::component_data().pop_back();
-            auto tailEntity = entities().back();
-            std::swap(entities()[reverseIndex], entities().back());
-            entities().pop_back();
-            reverse_indices()[tailEntity] = reverseIndex;
-            reverse_indices()[aEntity] = invalid;
-            if (have_snapshot())
-            {
-                auto ss = snapshot();
-                if (ss.data().has_entity_record(aEntity))
-                    ss.data().destroy_entity_record(aEntity);
-            }
+            destroy_entity_record_no_lock(aEntity);
+        }
+        void destroy_entity_records(std::span<entity_id const> aEntities) final
+        {
+            std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            for (auto entity : aEntities)
+                if (has_entity_record_no_lock(entity))
+                    do_destroy(entity);
+            update_signatures(aEntities, false);
+        }
+        void destroy_entity_record_no_lock(entity_id aEntity)
+        {
+            do_destroy(aEntity);
+            update_signatures(std::span<entity_id const>{ &aEntity, 1u }, false);
         }
         value_type& populate(entity_id aEntity, const value_type& aData)
         {
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
-            return do_populate(aEntity, aData);
+            auto& result = do_populate(aEntity, aData);
+            update_signatures(std::span<entity_id const>{ &aEntity, 1u }, true);
+            return result;
         }
         value_type& populate(entity_id aEntity, value_type&& aData)
         {
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
-            return do_populate(aEntity, aData);
+            auto& result = do_populate(aEntity, aData);
+            update_signatures(std::span<entity_id const>{ &aEntity, 1u }, true);
+            return result;
+        }
+        void populate(std::span<entity_id const> aEntities, const value_type& aData)
+        {
+            std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            reserve_for(aEntities);
+            for (auto entity : aEntities)
+                do_populate(entity, aData);
+            update_signatures(aEntities, true);
+        }
+        void populate(std::span<entity_id const> aEntities, std::span<value_type const> aData)
+        {
+            std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            if (aEntities.size() != aData.size())
+                throw invalid_data();
+            reserve_for(aEntities);
+            for (std::size_t index = 0u; index < aEntities.size(); ++index)
+                do_populate(aEntities[index], aData[index]);
+            update_signatures(aEntities, true);
+        }
+        // Populates aEntities[i] with the value returned by aSource(i) under a single lock.
+        template <typename Source>
+        void populate_from(std::span<entity_id const> aEntities, const Source& aSource)
+        {
+            std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            reserve_for(aEntities);
+            for (std::size_t index = 0u; index < aEntities.size(); ++index)
+                do_populate(aEntities[index], aSource(index));
+            update_signatures(aEntities, true);
         }
         const void* populate(entity_id aEntity, const void* aComponentData, std::size_t aComponentDataSize) final
         {
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
             if ((aComponentData == nullptr && !is_data_optional()) || aComponentDataSize != sizeof(data_type))
                 throw invalid_data();
-            if (aComponentData != nullptr)
-                return &do_populate(aEntity, *static_cast<const data_type*>(aComponentData));
+            auto const& result = aComponentData != nullptr ?
+                do_populate(aEntity, *static_cast<const data_type*>(aComponentData)) :
+                do_populate(aEntity, value_type{}); // empty optional
+            update_signatures(std::span<entity_id const>{ &aEntity, 1u }, true);
+            return &result;
+        }
+    public:
+        // Records must be trivially copyable and the field metadata must describe only plain values (no
+        // strings, pointers or functions).
+        bool bitwise_serializable() const final
+        {
+            if constexpr (!bitwise_candidate)
+                return false;
             else
-                return &do_populate(aEntity, value_type{}); // empty optional
+            {
+                for (uint32_t fieldIndex = 0u; fieldIndex < field_count(); ++fieldIndex)
+                    if (!is_bitwise_field(field_type(fieldIndex)))
+                        return false;
+                return true;
+            }
+        }
+        std::size_t record_size() const final
+        {
+            return sizeof(value_type);
+        }
+        std::size_t record_alignment() const final
+        {
+            return alignof(value_type);
+        }
+        std::span<std::byte const> data_block_no_lock() const final
+        {
+            if (bitwise_serializable())
+                return std::as_bytes(std::span<value_type const>{ base_type::component_data() });
+            else
+                throw not_bitwise_serializable();
+        }
+        std::span<entity_id const> entity_block_no_lock() const final
+        {
+            return iEntities;
+        }
+        std::span<std::size_t const> reverse_index_block_no_lock() const final
+        {
+            return iReverseIndices;
+        }
+        // Replaces the contents of this component with a block of records previously obtained from
+        // data_block_no_lock(); the records are copied in bulk rather than populated one by one.
+        void adopt_blocks_no_lock(std::span<std::byte const> aData, std::span<entity_id const> aEntities, std::span<std::size_t const> aReverseIndices) final
+        {
+            if constexpr (bitwise_candidate)
+            {
+                if (!bitwise_serializable())
+                    throw not_bitwise_serializable();
+                if (aData.size() != aEntities.size() * sizeof(value_type))
+                    throw invalid_data();
+                for (auto reverseIndex : aReverseIndices)
+                    if (reverseIndex != invalid && reverseIndex >= aEntities.size())
+                        throw invalid_data();
+                update_signatures(iEntities, false);
+                auto& data = base_type::component_data();
+                data.resize(aEntities.size());
+                if (!aData.empty())
+                    std::memcpy(static_cast<void*>(data.data()), aData.data(), aData.size());
+                iEntities.assign(aEntities.begin(), aEntities.end());
+                iReverseIndices.assign(aReverseIndices.begin(), aReverseIndices.end());
+                reset_versions();
+                update_signatures(iEntities, true);
+            }
+            else
+                throw not_bitwise_serializable();
         }
     public:
+        version_t version() const
+        {
+            return iVersion.load(std::memory_order_relaxed);
+        }
         bool have_snapshot() const
         {
-            return iHaveSnapshot;
+            return latest_snapshot() != nullptr;
+        }
+        snapshot_ptr latest_snapshot() const
+        {
+            return iSnapshot.load(std::memory_order_acquire);
         }
+        // Publishes a new snapshot generation; pages not modified since the previous generation are shared
+        // with it. Readers holding earlier generations are unaffected.
         void take_snapshot()
         {
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
-            if (!iUsingSnapshot)
+            auto const previous = latest_snapshot();
+            auto const allModified = iAllModified.load(std::memory_order_relaxed);
+            auto const unmodified = [&](version_t aPageVersion)
             {
-                if (iSnapshot == nullptr)
-                    iSnapshot = snapshot_ptr{ new component{*this} };
+                return std::max(aPageVersion, allModified) <= previous->version();
+            };
+            auto const& data = base_type::component_data();
+            auto const pageCount = (data.size() + page_size - 1u) / page_size;
+            typename snapshot_type::pages_t pages;
+            pages.reserve(pageCount);
+            for (std::size_t pageIndex = 0u; pageIndex < pageCount; ++pageIndex)
+            {
+                if (previous && pageIndex < previous->pages().size() && unmodified(iPageVersions[pageIndex]))
+                    pages.push_back(previous->pages()[pageIndex]);
                 else
-                    *iSnapshot = *this;
-                iHaveSnapshot = true;
+                {
+                    auto const first = pageIndex * page_size;
+                    auto const last = std::min(data.size(), first + page_size);
+                    pages.push_back(std::make_shared<typename snapshot_type::page const>(typename snapshot_type::page{
+                        { std::next(data.begin(), first), std::next(data.begin(), last) },
+                        { std::next(iEntities.begin(), first), std::next(iEntities.begin(), last) } }));
+                }
             }
+            auto const indexPageCount = (iReverseIndices.size() + page_size - 1u) / page_size;
+            typename snapshot_type::index_pages_t indexPages;
+            indexPages.reserve(indexPageCount);
+            for (std::size_t pageIndex = 0u; pageIndex < indexPageCount; ++pageIndex)
+            {
+                if (previous && pageIndex < previous->index_pages().size() && unmodified(iIndexPageVersions[pageIndex]))
+                    indexPages.push_back(previous->index_pages()[pageIndex]);
+                else
+                {
+                    auto const first = pageIndex * page_size;
+                    auto const last = std::min(iReverseIndices.size(), first + page_size);
+                    indexPages.push_back(std::make_shared<typename snapshot_type::index_page const>(
+                        std::next(iReverseIndices.begin(), first), std::next(iReverseIndices.begin(), last)));
+                }
+            }
+            iSnapshot.store(std::make_shared<snapshot_type const>(version(), data.size(), std::move(pages), std::move(indexPages)), std::memory_order_release);
+            iVersion.fetch_add(1u, std::memory_order_relaxed);
         }
-        scoped_snapshot snapshot()
+        scoped_snapshot snapshot() const
         {
-            std::scoped_lock<component_mutex<Data>> lock{ mutex() };
             return scoped_snapshot{ *this };
         }
+        // Epoch (RCU) read mode for read-heavy components: the writer publishes a version at its sync point
+        // and any number of readers access it through read() without taking the component mutex. Replaced
+        // versions are freed once no reader is still in the epoch that could see them.
+        void publish()
+        {
+            std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            take_snapshot();
+            iEpochs.retire(iPublished.exchange(new snapshot_ptr{ latest_snapshot() }));
+        }
+        bool have_published() const
+        {
+            return iPublished.load() != nullptr;
+        }
+        epoch_read read() const
+        {
+            auto guard = iEpochs.read();
+            auto const published = iPublished.load();
+            static const snapshot_type sEmpty{ 0u, 0u, {}, {} };
+            return epoch_read{ std::move(guard), published != nullptr ? **published : sEmpty };
+        }
+        const epoch_domain& epochs() const
+        {
+            return iEpochs;
+        }
+        // Frees replaced versions that no reader can still see; publish() also does this.
+        std::size_t reclaim()
+        {
+            return iEpochs.reclaim();
+        }
+    public:
+        bool change_tracking() const
+        {
+            return iChangeTracking;
+        }
+        // Opt-in per-record change stamps; records are stamped with the current version whenever they are
+        // populated or handed out for modification.
+        void enable_change_tracking(bool aEnable = true)
+        {
+            std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            if (aEnable && !iChangeTracking)
+                iRecordVersions.assign(base_type::component_data().size(), version());
+            else if (!aEnable)
+                iRecordVersions = {};
+            iChangeTracking = aEnable;
+        }
+        // Returns the current version and advances it so that subsequent changes compare newer.
+        version_t checkpoint()
+        {
+            return iVersion.fetch_add(1u, std::memory_order_relaxed);
+        }
+        std::size_t page_count() const
+        {
+            return iPageVersions.size();
+        }
+        version_t page_version(std::size_t aPageIndex) const
+        {
+            return std::max(iPageVersions[aPageIndex], iAllModified.load(std::memory_order_relaxed));
+        }
+        version_t record_version(reverse_index_t aIndex) const
+        {
+            auto const pageVersion = std::max(iPageVersions[aIndex / page_size], iAllModified.load(std::memory_order_relaxed));
+            if (!iChangeTracking)
+                return pageVersion;
+            return std::max(iRecordVersions[aIndex], iAllModified.load(std::memory_order_relaxed));
+        }
+        template <typename Callable>
+        void changed_since_no_lock(version_t aVersion, const Callable& aCallable) const
+        {
+            auto const& data = base_type::component_data();
+            auto const allModified = iAllModified.load(std::memory_order_relaxed) > aVersion;
+            for (std::size_t pageIndex = 0u; pageIndex < iPageVersions.size(); ++pageIndex)
+            {
+                if (!allModified && iPageVersions[pageIndex] <= aVersion)
+                    continue;
+                auto const first = pageIndex * page_size;
+                auto const last = std::min(data.size(), first + page_size);
+                for (auto index = first; index < last; ++index)
+                    if (allModified || !iChangeTracking || iRecordVersions[index] > aVersion)
+                        aCallable(iEntities[index], data[index]);
+            }
+        }
+        // Visits the records changed after aVersion (as returned by checkpoint()). Without change
+        // tracking whole modified pages are visited.
+        template <typename Callable>
+        void changed_since(version_t aVersion, const Callable& aCallable) const
+        {
+            std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            changed_since_no_lock(aVersion, aCallable);
+        }
+        void changed_entities_since(version_t aVersion, std::vector<entity_id>& aEntities) const
+        {
+            changed_since(aVersion, [&](entity_id aEntity, const value_type&) { aEntities.push_back(aEntity); });
+        }
+    public:
         template <typename Compare>
         void sort(Compare aComparator)
         {
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            touch_all();
             neolib::intrusive_sort(base_type::component_data().begin(), base_type::component_data().end(),
                 [this](auto lhs, auto rhs) 
                 { 
                     std::swap(*lhs, *rhs);
                     auto lhsIndex = lhs - base_type::component_data().begin();
                     auto rhsIndex = rhs - base_type::component_data().begin();
-                    auto& lhsEntity = entities()[lhsIndex];
-                    auto& rhsEntity = entities()[rhsIndex];
+                    auto& lhsEntity = iEntities[lhsIndex];
+                    auto& rhsEntity = iEntities[rhsIndex];
                     std::swap(lhsEntity, rhsEntity);
-                    if (lhsEntity != invalid)
-                        reverse_indices()[lhsEntity] = lhsIndex;
-                    if (rhsEntity != invalid)
-                        reverse_indices()[rhsEntity] = rhsIndex;
+                    if (iChangeTracking)
+                        std::swap(iRecordVersions[lhsIndex], iRecordVersions[rhsIndex]);
+                    if (lhsEntity != null_entity)
+                        iReverseIndices[lhsEntity] = lhsIndex;
+                    if (rhsEntity != null_entity)
+                        iReverseIndices[rhsEntity] = rhsIndex;
                 }, aComparator);
         }
+        // Sorts records by aKey(record), which must return an arithmetic or enum value, using a stable radix
+        // sort of (key, index) pairs followed by a single gather of data, entities and reverse indices. Keys
+        // are extracted and records gathered on the thread pool once there are aMinimumParallelismCount
+        // records, so aKey must then be safe to call concurrently.
+        template <typename KeyFunction>
+        void sort_by_key(KeyFunction aKey, std::size_t aMinimumParallelismCount = default_parallel_sort_size)
+        {
+            std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            auto const parallel = base_type::component_data().size() >= aMinimumParallelismCount;
+            extract_sort_keys(aKey, parallel);
+            neolib::radix_sort(iSortEntries, iSortScratch);
+            apply_sort_permutation(parallel);
+        }
+        // Incremental variants for records that are already nearly in order, such as frame-to-frame
+        // reorders: a stable insertion sort whose cost grows with the number of out of order records.
+        // Only records that actually move are marked as modified.
+        template <typename KeyFunction>
+        void resort_by_key(KeyFunction aKey)
+        {
+            std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            extract_sort_keys(aKey, false);
+            insertion_sort_entries([](radix_entry const& aLhs, radix_entry const& aRhs) { return aLhs.key < aRhs.key; });
+            apply_sort_permutation(false);
+        }
+        template <typename Compare>
+        void resort(Compare aComparator)
+        {
+            std::scoped_lock<component_mutex<Data>> lock{ mutex() };
+            auto const& data = base_type::component_data();
+            iSortEntries.resize(data.size());
+            for (std::size_t index = 0u; index < data.size(); ++index)
+                iSortEntries[index] = radix_entry{ 0u, index };
+            insertion_sort_entries([&](radix_entry const& aLhs, radix_entry const& aRhs) { return aComparator(data[aLhs.index], data[aRhs.index]); });
+            apply_sort_permutation(false);
+        }
     public:
         template <typename Callable>
         void apply(const Callable& aCallable)
         {
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
-            for (auto& data : component_data())
-                aCallable(*this, data);
+            auto& data = base_type::component_data();
+            touch_records(0u, data.size());
+            for (auto& record : data)
+                aCallable(*this, record);
         }
+        // Records are processed in chunks of aGrainSize that idle threads steal from each other, so uneven
+        // per-record cost does not leave threads waiting on a statically assigned slice.
         template <typename Callable>
-        void parallel_apply(const Callable& aCallable, std::size_t aMinimumParallelismCount = 0)
+        void parallel_apply(const Callable& aCallable, std::size_t aMinimumParallelismCount = 0, std::size_t aGrainSize = default_grain_size)
         {
             std::scoped_lock<component_mutex<Data>> lock{ mutex() };
-            neolib::parallel_apply(ecs().thread_pool(), component_data(), [&](value_type& aData) { aCallable(*this, aData); }, aMinimumParallelismCount);
+            auto& data = base_type::component_data();
+            if (data.size() < aMinimumParallelismCount)
+            {
+                touch_records(0u, data.size());
+                for (auto& record : data)
+                    aCallable(*this, record);
+                return;
+            }
+            neolib::parallel_chunks(ecs().thread_pool(), data.size(), aGrainSize, [&](std::size_t aFirst, std::size_t aLast)
+            {
+                touch_records(aFirst, aLast);
+                for (auto index = aFirst; index < aLast; ++index)
+                    aCallable(*this, data[index]);
+            });
         }
     private:
+        template <typename KeyFunction>
+        void extract_sort_keys(KeyFunction& aKey, bool aParallel)
+        {
+            auto const& data = base_type::component_data();
+            iSortEntries.resize(data.size());
+            auto extract = [&](std::size_t aFirst, std::size_t aLast)
+            {
+                for (auto index = aFirst; index < aLast; ++index)
+                    iSortEntries[index] = radix_entry{ neolib::radix_key(aKey(data[index])), index };
+            };
+            if (aParallel)
+                neolib::parallel_chunks(ecs().thread_pool(), data.size(), default_grain_size, extract);
+            else
+                extract(0u, data.size());
+        }
+        template <typename Less>
+        void insertion_sort_entries(const Less& aLess)
+        {
+            for (std::size_t index = 1u; index < iSortEntries.size(); ++index)
+            {
+                if (!aLess(iSortEntries[index], iSortEntries[index - 1u]))
+                    continue;
+                auto const entry = iSortEntries[index];
+                auto hole = index;
+                do
+                {
+                    iSortEntries[hole] = iSortEntries[hole - 1u];
+                    --hole;
+                } while (hole > 0u && aLess(entry, iSortEntries[hole - 1u]));
+                iSortEntries[hole] = entry;
+            }
+        }
+        // Moves the record at iSortEntries[i].index to position i for the range of positions that change.
+        void apply_sort_permutation(bool aParallel)
+        {
+            std::size_t first = 0u;
+            std::size_t last = iSortEntries.size();
+            while (first < last && iSortEntries[first].index == first)
+                ++first;
+            while (last > first && iSortEntries[last - 1u].index == last - 1u)
+                --last;
+            if (first == last)
+                return;
+            auto& data = base_type::component_data();
+            bool gathered = false;
+            if constexpr (std::is_default_constructible_v<value_type>)
+            {
+                if (aParallel && first == 0u && last == data.size())
+                {
+                    component_data_t sorted(data.size());
+                    neolib::parallel_chunks(ecs().thread_pool(), data.size(), default_grain_size, [&](std::size_t aFirst, std::size_t aLast)
+                    {
+                        for (auto index = aFirst; index < aLast; ++index)
+                            sorted[index] = std::move(data[iSortEntries[index].index]);
+                    });
+                    data.swap(sorted);
+                    gathered = true;
+                }
+            }
+            if (!gathered)
+            {
+                component_data_t moved;
+                moved.reserve(last - first);
+                for (auto index = first; index < last; ++index)
+                    moved.push_back(std::move(data[iSortEntries[index].index]));
+                std::move(moved.begin(), moved.end(), std::next(data.begin(), first));
+            }
+            iSortEntities.assign(std::next(iEntities.begin(), first), std::next(iEntities.begin(), last));
+            for (auto index = first; index < last; ++index)
+            {
+                auto const source = iSortEntries[index].index;
+                if (source == index)
+                    continue;
+                auto const entity = iSortEntities[source - first];
+                iEntities[index] = entity;
+                touch_record(index);
+                if (entity != null_entity)
+                {
+                    iReverseIndices[entity] = index;
+                    touch_index(entity);
+                }
+            }
+        }
+        // A destroyed record (and any handles it owned) must not stay visible to snapshot or epoch readers
+        // until the next explicit take_snapshot() or publish() so it is marked dead in the versions they
+        // currently see.
+        void hide_from_readers(entity_id aEntity) const
+        {
+            auto const snapshot = latest_snapshot();
+            if (snapshot != nullptr)
+                snapshot->mark_dead(aEntity);
+            auto const published = iPublished.load();
+            if (published != nullptr && *published != snapshot)
+                (*published)->mark_dead(aEntity);
+        }
+        void do_destroy(entity_id aEntity)
+        {
+            auto reverseIndex = reverse_index_no_lock(aEntity);
+            if (reverseIndex == invalid)
+                throw entity_record_not_found();
+            hide_from_readers(aEntity);
+            if constexpr (data_meta_type::has_handles)
+                data_meta_type::free_handles(base_type::component_data()[reverseIndex], ecs());
+            touch_record(reverseIndex);
+            touch_record(iEntities.size() - 1u);
+            std::swap(base_type::component_data()[reverseIndex], base_type::component_data().back());
+            base_type::component_data().pop_back();
+            auto tailEntity = iEntities.back();
+            std::swap(iEntities[reverseIndex], iEntities.back());
+            iEntities.pop_back();
+            if (iChangeTracking)
+            {
+                iRecordVersions[reverseIndex] = iRecordVersions.back();
+                iRecordVersions.pop_back();
+            }
+            touch_index(tailEntity);
+            touch_index(aEntity);
+            iReverseIndices[tailEntity] = reverseIndex;
+            iReverseIndices[aEntity] = invalid;
+        }
+        void reserve_for(std::span<entity_id const> aEntities)
+        {
+            auto const newSize = base_type::component_data().size() + aEntities.size();
+            base_type::component_data().reserve(newSize);
+            iEntities.reserve(newSize);
+            if (iChangeTracking)
+                iRecordVersions.reserve(newSize);
+            iPageVersions.reserve((newSize + page_size - 1u) / page_size);
+            entity_id maxEntity = null_entity;
+            for (auto entity : aEntities)
+                maxEntity = std::max(maxEntity, entity);
+            iReverseIndices.reserve(static_cast<std::size_t>(maxEntity) + 1u);
+            iIndexPageVersions.reserve(static_cast<std::size_t>(maxEntity) / page_size + 1u);
+        }
         template <typename T>
         value_type& do_populate(entity_id aEntity, T&& aComponentData)
         {
-            std::scoped_lock<component_mutex<Data>> lock{ mutex() };
-            if (has_entity_record(aEntity))
+            if (has_entity_record_no_lock(aEntity))
                 return do_update(aEntity, aComponentData);
             reverse_index_t reverseIndex = invalid;
             reverseIndex = base_type::component_data().size();
+            if (iPageVersions.size() <= reverseIndex / page_size)
+                iPageVersions.resize(reverseIndex / page_size + 1u, 0u);
             base_type::component_data().push_back(std::forward<T>(aComponentData));
             try
             {
-                entities().push_back(aEntity);
+                iEntities.push_back(aEntity);
+                if (iChangeTracking)
+                    iRecordVersions.push_back(version());
             }
             catch (...)
             {
                 base_type::component_data().pop_back();
+                if (iEntities.size() > base_type::component_data().size())
+                    iEntities.pop_back();
                 throw;
             }
+            touch_record(reverseIndex);
             try
             {
-                if (reverse_indices().size() <= aEntity)
-                    reverse_indices().resize(aEntity + 1, invalid);
-                reverse_indices()[aEntity] = reverseIndex;
+                if (iReverseIndices.size() <= aEntity)
+                {
+                    if (iIndexPageVersions.size() <= aEntity / page_size)
+                        iIndexPageVersions.resize(aEntity / page_size + 1u, 0u);
+                    for (auto pageIndex = iReverseIndices.size() / page_size; pageIndex < aEntity / page_size; ++pageIndex)
+                        touch_index(static_cast<entity_id>(pageIndex * page_size));
+                    iReverseIndices.resize(aEntity + 1, invalid);
+                }
+                touch_index(aEntity);
+                iReverseIndices[aEntity] = reverseIndex;
             }
             catch (...)
             {
-                entities()[reverseIndex] = null_entity;
+                iEntities[reverseIndex] = null_entity;
                 throw;
             }
             return base_type::component_data()[reverseIndex];
@@ -484,17 +1210,67 @@ namespace neolib::ecs
         template <typename T>
         value_type& do_update(entity_id aEntity, T&& aComponentData)
         {
-            std::scoped_lock<component_mutex<Data>> lock{ mutex() };
-            auto& record = entity_record(aEntity);
+            auto& record = entity_record_no_lock(aEntity);
             record = aComponentData;
             return record;
         }
+        void update_signatures(std::span<entity_id const> aEntities, bool aPresent)
+        {
+            if (iOrdinal)
+                ecs().update_signatures(aEntities, *iOrdinal, aPresent);
+        }
+        void touch_record(reverse_index_t aIndex)
+        {
+            std::atomic_ref<version_t>{ iPageVersions[aIndex / page_size] }.store(version(), std::memory_order_relaxed);
+            if (iChangeTracking)
+                std::atomic_ref<version_t>{ iRecordVersions[aIndex] }.store(version(), std::memory_order_relaxed);
+        }
+        void touch_records(reverse_index_t aFirst, reverse_index_t aLast)
+        {
+            if (aFirst == aLast)
+                return;
+            auto const currentVersion = version();
+            for (auto pageIndex = aFirst / page_size; pageIndex <= (aLast - 1u) / page_size; ++pageIndex)
+                std::atomic_ref<version_t>{ iPageVersions[pageIndex] }.store(currentVersion, std::memory_order_relaxed);
+            if (iChangeTracking)
+                for (auto index = aFirst; index < aLast; ++index)
+                    std::atomic_ref<version_t>{ iRecordVersions[index] }.store(currentVersion, std::memory_order_relaxed);
+        }
+        void touch_index(entity_id aEntity)
+        {
+            std::atomic_ref<version_t>{ iIndexPageVersions[aEntity / page_size] }.store(version(), std::memory_order_relaxed);
+        }
+        void touch_all()
+        {
+            iAllModified.store(version(), std::memory_order_relaxed);
+        }
+        // Sizes the page and record stamps to the current records and marks them all modified.
+        void reset_versions()
+        {
+            if (iChangeTracking)
+                iRecordVersions.assign(iEntities.size(), version());
+            else
+                iRecordVersions = {};
+            iPageVersions.assign((iEntities.size() + page_size - 1u) / page_size, version());
+            iIndexPageVersions.assign((iReverseIndices.size() + page_size - 1u) / page_size, version());
+            touch_all();
+        }
     private:
+        std::optional<component_ordinal> iOrdinal;
         component_data_entities_t iEntities;
         reverse_indices_t iReverseIndices;
-        mutable std::atomic<bool> iHaveSnapshot;
-        mutable std::atomic<uint32_t> iUsingSnapshot;
-        mutable snapshot_ptr iSnapshot;
+        std::atomic<version_t> iVersion;
+        std::atomic<version_t> iAllModified;
+        std::vector<version_t> iPageVersions;
+        std::vector<version_t> iIndexPageVersions;
+        bool iChangeTracking;
+        std::vector<version_t> iRecordVersions;
+        std::vector<radix_entry> iSortEntries;
+        std::vector<radix_entry> iSortScratch;
+        component_data_entities_t iSortEntities;
+        std::atomic<snapshot_ptr> iSnapshot;
+        epoch_domain iEpochs;
+        std::atomic<snapshot_ptr const*> iPublished = nullptr;
     };
 
     namespace detail
@@ -603,7 +1379,7 @@ namespace neolib::ecs
         typedef typename base_type::data_meta_type data_meta_type;
         typedef typename base_type::value_type value_type;
         typedef typename base_type::component_data_t component_data_t;
-        typedef typename component_data_t::mapped_type mapped_type;
+        typedef typename detail::crack_component_data<shared<ecs_data_type_t<Data>>>::mapped_type mapped_type;
     public:
         shared_component(i_ecs& aEcs) :
             base_type{ aEcs }
@@ -621,40 +1397,95 @@ namespace neolib::ecs
         using base_type::field_type_id;
         using base_type::field_name;
     public:
-        using base_type::component_data;
+        // Read-only: names and handles are indexed separately, so records are only added through populate().
+        const component_data_t& component_data() const
+        {
+            return base_type::component_data();
+        }
+    public:
+        // Records live in a dense slot array that only grows, so a handle (slot index) and any shared<Data>
+        // pointing at a record stay valid for the lifetime of the component.
+        typedef typename component_data_t::size_type handle_type;
     public:
-        const mapped_type& operator[](typename component_data_t::size_type aIndex) const
+        std::size_t size() const
         {
-            return std::next(component_data().begin(), aIndex)->second;
+            return component_data().size();
         }
-        mapped_type& operator[](typename component_data_t::size_type aIndex)
+        const mapped_type& operator[](handle_type aHandle) const
         {
-            return std::next(component_data().begin(), aIndex)->second;
+            return component_data()[aHandle].second;
         }
-        const mapped_type& operator[](const std::string& aName) const
+        mapped_type& operator[](handle_type aHandle)
         {
-            return component_data()[aName];
+            return base_type::component_data()[aHandle].second;
         }
-        mapped_type& operator[](const std::string& aName)
+        const mapped_type& operator[](const shared_key& aKey) const
         {
-            return component_data()[aName];
+            return (*this)[handle(aKey)];
+        }
+        mapped_type& operator[](const shared_key& aKey)
+        {
+            if (auto const existing = find(aKey))
+                return (*this)[*existing];
+            return (*this)[insert(aKey.name(), mapped_type{})];
+        }
+        const mapped_type& operator[](std::string_view aName) const
+        {
+            return (*this)[handle(aName)];
+        }
+        mapped_type& operator[](std::string_view aName)
+        {
+            if (auto const existing = find(aName))
+                return (*this)[*existing];
+            return (*this)[insert(std::string{ aName }, mapped_type{})];
         }
     public:
-        shared<mapped_type> populate(const std::string& aName, const mapped_type& aData)
+        std::optional<handle_type> find(const shared_key& aKey) const
         {
-            base_type::component_data()[aName] = aData;
-            auto& result = base_type::component_data()[aName];
-            if constexpr (mapped_type::meta::has_updater)
-                mapped_type::meta::update(result, ecs(), null_entity);
-            return shared<mapped_type> { &result };
+            auto const existing = iIndex.find(aKey);
+            if (existing == iIndex.end())
+                return {};
+            return existing->second;
         }
-        shared<mapped_type> populate(const std::string& aName, mapped_type&& aData)
+        std::optional<handle_type> find(std::string_view aName) const
         {
-            base_type::component_data()[aName] = std::move(aData);
-            auto& result = base_type::component_data()[aName];
-            if constexpr (mapped_type::meta::has_updater)
-                mapped_type::meta::update(result, ecs(), null_entity);
-            return shared<mapped_type> { &result };
+            auto const existing = iIndex.find(aName);
+            if (existing == iIndex.end())
+                return {};
+            return existing->second;
+        }
+        handle_type handle(const shared_key& aKey) const
+        {
+            if (auto const existing = find(aKey))
+                return *existing;
+            throw entity_record_not_found();
+        }
+        handle_type handle(std::string_view aName) const
+        {
+            if (auto const existing = find(aName))
+                return *existing;
+            throw entity_record_not_found();
+        }
+        const std::string& name(handle_type aHandle) const
+        {
+            return component_data()[aHandle].first;
+        }
+    public:
+        shared<mapped_type> populate(const shared_key& aKey, const mapped_type& aData)
+        {
+            return do_populate(aKey, aData);
+        }
+        shared<mapped_type> populate(const shared_key& aKey, mapped_type&& aData)
+        {
+            return do_populate(aKey, std::move(aData));
+        }
+        shared<mapped_type> populate(std::string_view aName, const mapped_type& aData)
+        {
+            return do_populate(aName, aData);
+        }
+        shared<mapped_type> populate(std::string_view aName, mapped_type&& aData)
+        {
+            return do_populate(aName, std::move(aData));
         }
         const void* populate(const std::string& aName, const void* aComponentData, std::size_t aComponentDataSize) final
         {
@@ -665,5 +1496,34 @@ namespace neolib::ecs
             else
                 return populate(aName, mapped_type{}).ptr(); // empty optional
         }
+    private:
+        template <typename Key, typename T>
+        shared<mapped_type> do_populate(const Key& aKey, T&& aData)
+        {
+            handle_type slot;
+            if (auto const existing = find(aKey))
+            {
+                slot = *existing;
+                (*this)[slot] = std::forward<T>(aData);
+            }
+            else if constexpr (std::is_same_v<Key, shared_key>)
+                slot = insert(aKey.name(), std::forward<T>(aData));
+            else
+                slot = insert(std::string{ aKey }, std::forward<T>(aData));
+            auto& result = (*this)[slot];
+            if constexpr (mapped_type::meta::has_updater)
+                mapped_type::meta::update(result, ecs(), null_entity);
+            return shared<mapped_type> { &result };
+        }
+        template <typename T>
+        handle_type insert(const std::string& aName, T&& aData)
+        {
+            auto& data = base_type::component_data();
+            data.emplace_back(aName, std::forward<T>(aData));
+            iIndex.emplace(aName, data.size() - 1u);
+            return data.size() - 1u;
+        }
+    private:
+        boost::unordered_flat_map<std::string, handle_type, shared_key::hash, shared_key::equal_to> iIndex;
     };
 }
\ No newline at end of file
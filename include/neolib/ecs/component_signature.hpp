@@ -0,0 +1,160 @@
+// component_signature.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <cstdint>
+#include <vector>
+#include <bit>
+#include <algorithm>
+#include <span>
+#include <neolib/ecs/ecs_ids.hpp>
+
+namespace neolib::ecs
+{
+    // Set of components (indexed by dense component ordinal) that an entity has records in.
+    class component_signature
+    {
+    public:
+        typedef std::uint64_t word_type;
+        static constexpr std::size_t bits_per_word = sizeof(word_type) * 8u;
+    public:
+        component_signature()
+        {
+        }
+        component_signature(std::span<word_type const> aWords) :
+            iWords{ aWords.begin(), aWords.end() }
+        {
+            trim();
+        }
+    public:
+        bool operator==(const component_signature& aRhs) const
+        {
+            return iWords == aRhs.iWords;
+        }
+    public:
+        static std::size_t words_for(component_ordinal aOrdinal)
+        {
+            return aOrdinal / bits_per_word + 1u;
+        }
+        std::span<word_type const> words() const
+        {
+            return iWords;
+        }
+        bool empty() const
+        {
+            return iWords.empty();
+        }
+        std::size_t count() const
+        {
+            std::size_t result = 0u;
+            for (auto word : iWords)
+                result += std::popcount(word);
+            return result;
+        }
+        bool test(component_ordinal aOrdinal) const
+        {
+            auto const word = aOrdinal / bits_per_word;
+            return word < iWords.size() && (iWords[word] & bit(aOrdinal)) != 0u;
+        }
+        component_signature& set(component_ordinal aOrdinal)
+        {
+            auto const word = aOrdinal / bits_per_word;
+            if (iWords.size() <= word)
+                iWords.resize(word + 1u, 0u);
+            iWords[word] |= bit(aOrdinal);
+            return *this;
+        }
+        component_signature& reset(component_ordinal aOrdinal)
+        {
+            auto const word = aOrdinal / bits_per_word;
+            if (word < iWords.size())
+            {
+                iWords[word] &= ~bit(aOrdinal);
+                trim();
+            }
+            return *this;
+        }
+        component_signature& operator|=(std::span<word_type const> aRhs)
+        {
+            if (iWords.size() < aRhs.size())
+                iWords.resize(aRhs.size(), 0u);
+            for (std::size_t word = 0u; word < aRhs.size(); ++word)
+                iWords[word] |= aRhs[word];
+            trim();
+            return *this;
+        }
+        component_signature& operator|=(const component_signature& aRhs)
+        {
+            return *this |= aRhs.words();
+        }
+        bool includes(const component_signature& aRequired) const;
+        template <typename Callable>
+        void for_each(Callable&& aCallable) const
+        {
+            for (std::size_t word = 0u; word < iWords.size(); ++word)
+                for (auto bits = iWords[word]; bits != 0u; bits &= bits - 1u)
+                    aCallable(static_cast<component_ordinal>(word * bits_per_word + std::countr_zero(bits)));
+        }
+    private:
+        static word_type bit(component_ordinal aOrdinal)
+        {
+            return word_type{ 1u } << (aOrdinal % bits_per_word);
+        }
+        void trim()
+        {
+            while (!iWords.empty() && iWords.back() == 0u)
+                iWords.pop_back();
+        }
+    private:
+        std::vector<word_type> iWords;
+    };
+
+    // Tests whether an entity's packed signature words include every component in aRequired.
+    inline bool signature_includes(std::span<component_signature::word_type const> aSignature, std::span<component_signature::word_type const> aRequired)
+    {
+        for (std::size_t word = 0u; word < aRequired.size(); ++word)
+            if (((word < aSignature.size() ? aSignature[word] : 0u) & aRequired[word]) != aRequired[word])
+                return false;
+        return true;
+    }
+
+    // True if every component in aRequired is also in this signature.
+    inline bool component_signature::includes(const component_signature& aRequired) const
+    {
+        return signature_includes(words(), aRequired.words());
+    }
+}
@@ -42,6 +42,7 @@
 #include <neolib/task/timer.hpp>
 #include <neolib/app/object.hpp>
 #include <neolib/ecs/i_ecs.hpp>
+#include <neolib/ecs/generational_id_allocator.hpp>
 #include <neolib/ecs/component.hpp>
 #include <neolib/ecs/system.hpp>
 
@@ -69,9 +70,11 @@ namespace neolib::ecs
         define_declared_event(SystemsResumed, systems_resumed)
         define_declared_event(EntityCreated, entity_created, entity_id)
         define_declared_event(EntityDestroyed, entity_destroyed, entity_id)
+        define_declared_event(EntitiesCreated, entities_created, std::span<entity_id const>)
+        define_declared_event(EntitiesDestroyed, entities_destroyed, std::span<entity_id const>)
         define_declared_event(HandleUpdated, handle_updated, handle_id)
     private:
-        typedef std::vector<handle_t> handles_t;
+        typedef std::vector<std::pair<handle_t, handle_id>> handles_t;
         struct entity_mutex_tag {};
         struct archetype_mutex_tag {};
         struct component_factory_mutex_tag {};
@@ -80,6 +83,7 @@ namespace neolib::ecs
         struct shared_component_mutex_tag {};
         struct system_factory_mutex_tag {};
         struct system_mutex_tag {};
+        struct signature_mutex_tag {};
     public:
         ecs(ecs_flags aCreationFlags = ecs_flags::Default);
         ~ecs();
@@ -100,17 +104,25 @@ namespace neolib::ecs
         void async_create_entity(const std::function<void()>& aCreator) final;
         void commit_async_entity_creation() final;
         void destroy_entity(entity_id aEntityId, bool aNotify = true) override;
+        void create_entities(const entity_archetype_id& aArchetypeId, std::span<entity_id> aNewEntities) override;
+        void destroy_entities(std::span<entity_id const> aEntities, bool aNotify = true) override;
+        void commit_entities(const entity_archetype_id& aArchetypeId, std::span<entity_id const> aReservedEntities) override;
         void async_destroy_entity(entity_id aEntityId, bool aNotify = true) final;
+        void async_destroy_entities(std::span<entity_id const> aEntities, bool aNotify = true) final;
         void commit_async_entity_destruction() final;
     public:
         bool run_threaded(const system_id& aSystemId) const override;
         bool is_child(const system_id& aSystemId, system_id& aParentSystemId) const override;
+        bool is_scheduled(const system_id& aSystemId) const final;
+        void set_scheduled(const system_id& aSystemId, bool aScheduled) final;
         bool all_systems_paused() const final;
         void pause_all_systems() final;
         void resume_all_systems() final;
     public:
         const archetype_registry_t& archetypes() const final;
         archetype_registry_t& archetypes() final;
+        const archetype_storages_t& archetype_storages() const final;
+        archetype_storages_t& archetype_storages() final;
         const component_factories_t& component_factories() const final;
         component_factories_t& component_factories() final;
         const components_t& components() const final;
@@ -138,10 +150,27 @@ namespace neolib::ecs
     public:
         entity_id next_entity_id() final;
         void free_entity_id(entity_id aId) final;
+        generation_t entity_generation(entity_id aId) const final;
+    public:
+        void save_world(const std::string& aPath) const final;
+        void load_world(const std::string& aPath) final;
+    public:
+        component_ordinal ordinal(component_id aComponentId) final;
+        component_signature signature(entity_id aEntity) const final;
+        bool matches(entity_id aEntity, const component_signature& aSignature) const final;
+        bool has_component(entity_id aEntity, component_id aComponentId) const final;
+        void entities_matching(const component_signature& aSignature, std::vector<entity_id>& aEntities) const final;
+        void update_signatures(std::span<entity_id const> aEntities, component_ordinal aOrdinal, bool aPresent) final;
+    private:
+        std::span<component_signature::word_type const> signature_no_lock(entity_id aEntity) const;
+        void destroy_entity_records(std::span<entity_id const> aEntities);
     public:
         bool archetype_registered(const i_entity_archetype& aArchetype) const final;
         void register_archetype(const i_entity_archetype& aArchetype) final;
         void register_archetype(std::shared_ptr<const i_entity_archetype> aArchetype) final;
+        bool archetype_storage_registered(entity_archetype_id aArchetypeId) const final;
+        void register_archetype_storage(i_archetype_storage& aStorage) final;
+        void unregister_archetype_storage(i_archetype_storage& aStorage) final;
         bool component_registered(component_id aComponentId) const final;
         void register_component(component_id aComponentId, component_factory aFactory) final;
         bool shared_component_registered(component_id aComponentId) const final;
@@ -158,9 +187,11 @@ namespace neolib::ecs
         void free_handle_id(handle_id aId);
     public:
         using i_ecs::create_entity;
+        using i_ecs::create_entities;
     public:
         using i_ecs::populate;
         using i_ecs::populate_shared;
+        using i_ecs::has_component;
         using i_ecs::component_instantiated;
         using i_ecs::component;
         using i_ecs::shared_component_instantiated;
@@ -187,19 +218,24 @@ namespace neolib::ecs
         mutable std::optional<neolib::thread_pool> iThreadPool;
         ecs_flags iFlags;
         archetype_registry_t iArchetypeRegistry;
+        archetype_storages_t iArchetypeStorages;
         component_factories_t iComponentFactories;
         mutable components_t iComponents;
         mutable std::vector<proxy_mutex<i_lockable>> iComponentMutexes;
+        mutable ecs_mutex<signature_mutex_tag> iSignatureMutex;
+        boost::unordered_flat_map<component_id, component_ordinal, quick_uuid_hash> iComponentOrdinals;
+        mutable std::vector<i_component*> iOrdinalComponents;
+        std::size_t iSignatureStride;
+        std::vector<component_signature::word_type> iSignatures;
         shared_component_factories_t iSharedComponentFactories;
         mutable shared_components_t iSharedComponents;
         system_factories_t iSystemFactories;
         mutable systems_t iSystems;
+        std::vector<system_id> iScheduledSystems;
         std::vector<std::function<void()>> iEntitiesToCreate;
         std::vector<std::pair<entity_id, bool>> iEntitiesToDestroy;
-        entity_id iNextEntityId;
-        std::vector<entity_id> iFreedEntityIds;
-        handle_id iNextHandleId;
-        std::vector<handle_id> iFreedHandleIds;
+        generational_id_allocator<entity_id> iEntityIds;
+        generational_id_allocator<std::uint32_t> iHandleIds;
         handles_t iHandles;
         neolib::callback_timer iSystemTimer;
         std::atomic<bool> iSystemsPaused;
@@ -49,7 +49,23 @@ namespace neolib::ecs
 
     using id_t = neolib::cookie;
     constexpr id_t null_id = 0;
-    using handle_id = id_t;
+    // A 32-bit handle slot index with the slot's 32-bit generation above it.
+    using handle_id = std::uint64_t;
     using entity_id = id_t;
     constexpr entity_id null_entity = 0;
+
+    using component_ordinal = std::uint32_t;
+
+    using generation_t = std::uint32_t;
+
+    template <typename Id>
+    struct generational_id
+    {
+        Id id = null_id;
+        generation_t generation = 0u;
+
+        auto operator<=>(const generational_id&) const = default;
+    };
+
+    using entity_ref = generational_id<entity_id>;
 }
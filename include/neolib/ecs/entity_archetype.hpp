@@ -59,6 +59,7 @@ namespace neolib::ecs
         const i_string& name() const override;
         const i_set<component_id>& components() const override;
         i_set<component_id>& components() override;
+        using i_entity_archetype::populate_default_components;
         void populate_default_components(i_ecs& aEcs, entity_id aEntity) override;
     private:
         entity_archetype_id iId;
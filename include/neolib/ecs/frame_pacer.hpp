@@ -0,0 +1,168 @@
+// frame_pacer.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <neolib/chrono/fast_clock.hpp>
+
+namespace neolib::ecs
+{
+    struct frame_statistics
+    {
+        std::uint64_t ticks = 0u;
+        std::uint64_t steps = 0u;
+        std::uint64_t catchUpSteps = 0u;
+        std::uint64_t droppedSteps = 0u;
+        std::uint64_t overruns = 0u;
+        std::chrono::nanoseconds lastTickTime = {};
+        std::chrono::nanoseconds maxTickTime = {};
+        std::chrono::nanoseconds maxOverrun = {};
+        std::chrono::nanoseconds totalOverrun = {};
+        std::chrono::nanoseconds maxLateness = {};
+        std::chrono::nanoseconds totalLateness = {};
+    };
+
+    // Paces ticks to a fixed step measured on neolib::chrono::fast_clock (the TSC clock where available).
+    // wait() sleeps until shortly before the next step boundary and then spins for the remainder, so wake-up
+    // accuracy does not depend on the OS timer granularity. Boundaries are derived from the start time rather
+    // than from the previous wake-up so lateness does not accumulate as drift. When a tick overruns, the
+    // steps that fell due are returned together (up to a limit) for the caller to run back to back; any
+    // beyond the limit are dropped and counted. The clock is a parameter so that the pacing arithmetic can
+    // be driven by a manual clock.
+    template <typename Clock>
+    class basic_frame_pacer
+    {
+    public:
+        typedef Clock clock_type;
+        typedef typename clock_type::time_point time_point;
+        typedef std::chrono::nanoseconds duration;
+    public:
+        static constexpr duration default_spin_window = std::chrono::microseconds{ 1500 };
+    public:
+        basic_frame_pacer(duration aStep, std::size_t aMaxStepsPerTick = 4u, duration aSpinWindow = default_spin_window) :
+            iStep{ std::max(aStep, duration{ 1 }) }, iMaxStepsPerTick{ std::max<std::size_t>(aMaxStepsPerTick, 1u) }, iSpinWindow{ aSpinWindow }
+        {
+        }
+    public:
+        duration step() const
+        {
+            return iStep;
+        }
+        std::size_t max_steps_per_tick() const
+        {
+            return iMaxStepsPerTick;
+        }
+        frame_statistics const& statistics() const
+        {
+            return iStatistics;
+        }
+        void reset()
+        {
+            iStarted = false;
+            iStatistics = {};
+        }
+    public:
+        // Waits for the next step boundary and returns the number of steps to run this tick.
+        std::size_t wait()
+        {
+            auto now = clock_type::now();
+            if (!iStarted)
+            {
+                iStarted = true;
+                iNext = now;
+            }
+            if (now < iNext)
+            {
+                auto const remaining = std::chrono::duration_cast<duration>(iNext - now);
+                if (remaining > iSpinWindow)
+                    std::this_thread::sleep_for(remaining - iSpinWindow);
+                while ((now = clock_type::now()) < iNext)
+                    spin();
+            }
+            auto const lateness = std::chrono::duration_cast<duration>(now - iNext);
+            auto const due = static_cast<std::size_t>(lateness / iStep) + 1u;
+            auto const steps = std::min(due, iMaxStepsPerTick);
+            iNext += std::chrono::duration_cast<typename clock_type::duration>(iStep * static_cast<duration::rep>(due));
+            iTickStart = now;
+            ++iStatistics.ticks;
+            iStatistics.steps += steps;
+            iStatistics.catchUpSteps += steps - 1u;
+            iStatistics.droppedSteps += due - steps;
+            iStatistics.maxLateness = std::max(iStatistics.maxLateness, lateness);
+            iStatistics.totalLateness += lateness;
+            return steps;
+        }
+        // Call when the work for the steps returned by wait() is finished; work that runs past the next step
+        // boundary is counted as an overrun.
+        void tick_completed()
+        {
+            auto const now = clock_type::now();
+            auto const tickTime = std::chrono::duration_cast<duration>(now - iTickStart);
+            iStatistics.lastTickTime = tickTime;
+            iStatistics.maxTickTime = std::max(iStatistics.maxTickTime, tickTime);
+            if (now > iNext)
+            {
+                auto const overrun = std::chrono::duration_cast<duration>(now - iNext);
+                ++iStatistics.overruns;
+                iStatistics.maxOverrun = std::max(iStatistics.maxOverrun, overrun);
+                iStatistics.totalOverrun += overrun;
+            }
+        }
+    private:
+        static void spin()
+        {
+#if NEOLIB_HAS_TSC_CLOCK
+            chrono::detail::spin_pause();
+#else
+            std::this_thread::yield();
+#endif
+        }
+    private:
+        duration iStep;
+        std::size_t iMaxStepsPerTick;
+        duration iSpinWindow;
+        bool iStarted = false;
+        time_point iNext = {};
+        time_point iTickStart = {};
+        frame_statistics iStatistics;
+    };
+
+    typedef basic_frame_pacer<chrono::fast_clock> frame_pacer;
+}
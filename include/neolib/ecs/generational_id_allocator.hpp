@@ -0,0 +1,225 @@
+// generational_id_allocator.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <neolib/ecs/ecs_ids.hpp>
+
+namespace neolib::ecs
+{
+    // Lock-free allocator of dense ids. Freed ids are recycled through a tagged Treiber stack and every
+    // id carries a generation that is odd while the id is allocated and even while it is free, so a
+    // recorded (id, generation) pair can be cheaply validated after the id has been reused. Slot
+    // storage is a sequence of geometrically growing buckets that are never moved or freed while the
+    // allocator is alive, which makes concurrent reads of a slot safe.
+    template <typename Id, std::size_t FirstBucketSize = 1024u>
+    class generational_id_allocator
+    {
+        static_assert(std::is_unsigned_v<Id> && sizeof(Id) <= sizeof(std::uint32_t));
+        static_assert(std::has_single_bit(FirstBucketSize));
+    public:
+        struct cannot_restore : std::logic_error { cannot_restore() : std::logic_error("neolib::ecs::generational_id_allocator::cannot_restore") {} };
+    public:
+        typedef Id id_type;
+        typedef std::uint32_t generation_type;
+    private:
+        struct slot
+        {
+            std::atomic<generation_type> generation;
+            std::atomic<id_type> next;
+        };
+        static constexpr std::size_t bucket_count = std::numeric_limits<id_type>::digits + 1u - std::countr_zero(FirstBucketSize);
+    public:
+        generational_id_allocator(id_type aMaxId = std::numeric_limits<id_type>::max()) :
+            iMaxId{ aMaxId }, iBuckets{}, iFreeHead{ 0u }, iHighWater{ 0u }
+        {
+        }
+        ~generational_id_allocator()
+        {
+            for (auto& bucket : iBuckets)
+                delete[] bucket.load(std::memory_order_relaxed);
+        }
+        generational_id_allocator(const generational_id_allocator&) = delete;
+        generational_id_allocator& operator=(const generational_id_allocator&) = delete;
+    public:
+        id_type max_id() const
+        {
+            return iMaxId;
+        }
+        id_type high_water() const
+        {
+            return iHighWater.load(std::memory_order_acquire);
+        }
+        // Returns the null id (0) if no ids remain.
+        id_type allocate()
+        {
+            auto head = iFreeHead.load(std::memory_order_acquire);
+            while (head_index(head) != 0u)
+            {
+                auto const candidate = head_index(head);
+                auto const next = at(candidate).next.load(std::memory_order_relaxed);
+                if (iFreeHead.compare_exchange_weak(head, make_head(head_tag(head) + 1u, next), std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    at(candidate).generation.fetch_add(1u, std::memory_order_release);
+                    return candidate;
+                }
+            }
+            auto highWater = iHighWater.load(std::memory_order_relaxed);
+            do
+            {
+                if (highWater == iMaxId)
+                    return id_type{};
+            } while (!iHighWater.compare_exchange_weak(highWater, highWater + 1u, std::memory_order_acq_rel, std::memory_order_relaxed));
+            auto const newId = static_cast<id_type>(highWater + 1u);
+            ensure_bucket(newId).generation.fetch_add(1u, std::memory_order_release);
+            return newId;
+        }
+        // Returns false, leaving the allocator unchanged, if aId is not currently allocated.
+        bool free(id_type aId)
+        {
+            if (aId == id_type{} || aId > high_water())
+                return false;
+            auto& s = at(aId);
+            auto generation = s.generation.load(std::memory_order_acquire);
+            do
+            {
+                if ((generation & 1u) == 0u)
+                    return false;
+            } while (!s.generation.compare_exchange_weak(generation, generation + 1u, std::memory_order_acq_rel, std::memory_order_acquire));
+            auto head = iFreeHead.load(std::memory_order_acquire);
+            do
+            {
+                s.next.store(head_index(head), std::memory_order_relaxed);
+            } while (!iFreeHead.compare_exchange_weak(head, make_head(head_tag(head) + 1u, aId), std::memory_order_acq_rel, std::memory_order_acquire));
+            return true;
+        }
+        generation_type generation(id_type aId) const
+        {
+            if (aId == id_type{} || aId > high_water())
+                return 0u;
+            auto const bucket = bucket_of(aId);
+            auto const slots = iBuckets[bucket].load(std::memory_order_acquire);
+            if (slots == nullptr)
+                return 0u;
+            return slots[aId - bucket_start(bucket)].generation.load(std::memory_order_acquire);
+        }
+        bool alive(id_type aId) const
+        {
+            return (generation(aId) & 1u) == 1u;
+        }
+        bool valid(id_type aId, generation_type aGeneration) const
+        {
+            return (aGeneration & 1u) == 1u && generation(aId) == aGeneration;
+        }
+        // Reinstates a previously recorded allocator state where aGenerations[n] is the generation of id
+        // n + 1; ids with even generations are placed on the free list. Not thread-safe and only valid
+        // on an allocator that has not yet allocated anything.
+        void restore(std::span<generation_type const> aGenerations)
+        {
+            if (high_water() != id_type{} || aGenerations.size() > iMaxId)
+                throw cannot_restore();
+            std::uint64_t head = make_head(head_tag(iFreeHead.load(std::memory_order_relaxed)) + 1u, id_type{});
+            for (auto index = aGenerations.size(); index-- > 0u;)
+            {
+                auto const id = static_cast<id_type>(index + 1u);
+                auto& s = ensure_bucket(id);
+                s.generation.store(aGenerations[index], std::memory_order_relaxed);
+                if ((aGenerations[index] & 1u) == 0u)
+                {
+                    s.next.store(head_index(head), std::memory_order_relaxed);
+                    head = make_head(head_tag(head), id);
+                }
+            }
+            iFreeHead.store(head, std::memory_order_relaxed);
+            iHighWater.store(static_cast<id_type>(aGenerations.size()), std::memory_order_release);
+        }
+    private:
+        static std::uint64_t make_head(std::uint32_t aTag, id_type aIndex)
+        {
+            return (static_cast<std::uint64_t>(aTag) << 32u) | aIndex;
+        }
+        static id_type head_index(std::uint64_t aHead)
+        {
+            return static_cast<id_type>(aHead & 0xFFFFFFFFu);
+        }
+        static std::uint32_t head_tag(std::uint64_t aHead)
+        {
+            return static_cast<std::uint32_t>(aHead >> 32u);
+        }
+        static std::size_t bucket_of(std::size_t aIndex)
+        {
+            return std::bit_width(aIndex / FirstBucketSize + 1u) - 1u;
+        }
+        static std::size_t bucket_size(std::size_t aBucket)
+        {
+            return FirstBucketSize << aBucket;
+        }
+        static std::size_t bucket_start(std::size_t aBucket)
+        {
+            return FirstBucketSize * ((std::size_t{ 1u } << aBucket) - 1u);
+        }
+        slot& at(id_type aId) const
+        {
+            auto const bucket = bucket_of(aId);
+            return iBuckets[bucket].load(std::memory_order_acquire)[aId - bucket_start(bucket)];
+        }
+        slot& ensure_bucket(id_type aId)
+        {
+            auto const bucket = bucket_of(aId);
+            auto existing = iBuckets[bucket].load(std::memory_order_acquire);
+            if (existing == nullptr)
+            {
+                auto newBucket = std::make_unique<slot[]>(bucket_size(bucket));
+                if (iBuckets[bucket].compare_exchange_strong(existing, newBucket.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+                    existing = newBucket.release();
+            }
+            return existing[aId - bucket_start(bucket)];
+        }
+    private:
+        id_type const iMaxId;
+        mutable std::array<std::atomic<slot*>, bucket_count> iBuckets;
+        std::atomic<std::uint64_t> iFreeHead;
+        std::atomic<id_type> iHighWater;
+    };
+}
@@ -36,6 +36,7 @@
 #pragma once
 
 #include <neolib/neolib.hpp>
+#include <span>
 #include <neolib/core/string.hpp>
 #include <neolib/core/i_mutex.hpp>
 #include <neolib/ecs/ecs_ids.hpp>
@@ -65,10 +66,23 @@ namespace neolib::ecs
 
     class i_component : public i_component_base
     {
+    public:
+        struct not_bitwise_serializable : std::logic_error { not_bitwise_serializable() : std::logic_error("i_component::not_bitwise_serializable") {} };
     public:
         virtual bool has_entity_record_no_lock(entity_id aEntity) const = 0;
         virtual bool has_entity_record(entity_id aEntity) const = 0;
         virtual void destroy_entity_record(entity_id aEntity) = 0;
+        virtual void destroy_entity_records(std::span<entity_id const> aEntities) = 0;
+    public:
+        // Raw block access used for binary world persistence; records are only exposed as bytes when
+        // they hold plain values and no handles.
+        virtual bool bitwise_serializable() const = 0;
+        virtual std::size_t record_size() const = 0;
+        virtual std::size_t record_alignment() const = 0;
+        virtual std::span<std::byte const> data_block_no_lock() const = 0;
+        virtual std::span<entity_id const> entity_block_no_lock() const = 0;
+        virtual std::span<std::size_t const> reverse_index_block_no_lock() const = 0;
+        virtual void adopt_blocks_no_lock(std::span<std::byte const> aData, std::span<entity_id const> aEntities, std::span<std::size_t const> aReverseIndices) = 0;
     public:
         virtual const void* populate(entity_id aEntity, const void* aComponentData, std::size_t aComponentDataSize) = 0;
         template <typename ComponentData>
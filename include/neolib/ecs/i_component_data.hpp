@@ -173,6 +173,29 @@ namespace neolib::ecs
         return aLhs = static_cast<component_data_field_type>(static_cast<std::uint64_t>(aLhs) & static_cast<std::uint64_t>(aRhs));
     }
 
+    // True if a field of this type is a self-contained value whose object representation can be
+    // persisted and restored as raw bytes.
+    inline constexpr bool is_bitwise_field(component_data_field_type aFieldType)
+    {
+        auto constexpr kindMask = static_cast<component_data_field_type>(0x00000000FFFF0000);
+        auto constexpr indirect = component_data_field_type::Array | component_data_field_type::Pointer |
+            component_data_field_type::SharedPointer | component_data_field_type::Range | component_data_field_type::Shared;
+        if ((aFieldType & indirect) != component_data_field_type::Invalid)
+            return false;
+        switch (aFieldType & kindMask)
+        {
+        case component_data_field_type::Invalid:
+            return (aFieldType & static_cast<component_data_field_type>(0xFFFF)) != component_data_field_type::Invalid;
+        case component_data_field_type::Enum:
+        case component_data_field_type::Uuid:
+        case component_data_field_type::Id:
+        case component_data_field_type::SmallId:
+            return true;
+        default:
+            return false;
+        }
+    }
+
     struct i_component_data
     {
         struct meta
@@ -36,13 +36,16 @@
 #pragma once
 
 #include <neolib/neolib.hpp>
+#include <span>
 #include <boost/unordered/unordered_flat_map.hpp>
 #include <neolib/core/i_mutex.hpp>
 #include <neolib/task/thread_pool.hpp>
 #include <neolib/task/event.hpp>
 #include <neolib/app/i_object.hpp>
 #include <neolib/ecs/ecs_ids.hpp>
+#include <neolib/ecs/component_signature.hpp>
 #include <neolib/ecs/i_entity_archetype.hpp>
+#include <neolib/ecs/i_archetype_storage.hpp>
 #include <neolib/ecs/i_component.hpp>
 #include <neolib/ecs/i_system.hpp>
 
@@ -127,8 +130,12 @@ namespace neolib::ecs
     public:
         declare_event(systems_paused)
         declare_event(systems_resumed)
+        // Bulk creation and destruction trigger entities_created/entities_destroyed once per batch
+        // followed by entity_created/entity_destroyed for each entity in the batch.
         declare_event(entity_created, entity_id)
         declare_event(entity_destroyed, entity_id)
+        declare_event(entities_created, std::span<entity_id const>)
+        declare_event(entities_destroyed, std::span<entity_id const>)
         declare_event(handle_updated, handle_id)
     public:
         struct entity_archetype_not_found : std::logic_error { entity_archetype_not_found() : std::logic_error("i_ecs::entity_archetype_not_found") {} };
@@ -136,14 +143,20 @@ namespace neolib::ecs
         struct system_not_found : std::logic_error { system_not_found() : std::logic_error("i_ecs::system_not_found") {} };
         struct uuid_exists : std::runtime_error { uuid_exists(const std::string& aContext) : std::runtime_error("i_ecs::uuid_exists: " + aContext) {} };
         struct entity_ids_exhausted : std::runtime_error { entity_ids_exhausted() : std::runtime_error("i_ecs::entity_ids_exhausted") {} };
+        struct batch_size_mismatch : std::logic_error { batch_size_mismatch() : std::logic_error("i_ecs::batch_size_mismatch") {} };
         struct handle_ids_exhausted : std::runtime_error { handle_ids_exhausted() : std::runtime_error("i_ecs::handle_ids_exhausted") {} };
         struct invalid_handle_id : std::logic_error { invalid_handle_id() : std::logic_error("i_ecs::invalid_handle_id") {} };
+        struct stale_entity_ref : std::logic_error { stale_entity_ref() : std::logic_error("i_ecs::stale_entity_ref") {} };
+        struct world_not_empty : std::logic_error { world_not_empty() : std::logic_error("i_ecs::world_not_empty") {} };
+        struct invalid_world_file : std::runtime_error { invalid_world_file(const std::string& aContext) : std::runtime_error("i_ecs::invalid_world_file: " + aContext) {} };
+        struct incompatible_component : std::runtime_error { incompatible_component(const std::string& aContext) : std::runtime_error("i_ecs::incompatible_component: " + aContext) {} };
     public:
         typedef std::function<std::unique_ptr<i_component>()> component_factory;
         typedef std::function<std::unique_ptr<i_shared_component>()> shared_component_factory;
         typedef std::function<std::unique_ptr<i_system>()> system_factory;
     protected:
         typedef boost::unordered_flat_map<entity_archetype_id, std::shared_ptr<const i_entity_archetype>, quick_uuid_hash> archetype_registry_t;
+        typedef boost::unordered_flat_map<entity_archetype_id, i_archetype_storage*, quick_uuid_hash> archetype_storages_t;
         typedef boost::unordered_flat_map<component_id, component_factory, quick_uuid_hash> component_factories_t;
         typedef boost::unordered_flat_map<component_id, std::unique_ptr<i_component>, quick_uuid_hash> components_t;
         typedef boost::unordered_flat_map<component_id, shared_component_factory, quick_uuid_hash> shared_component_factories_t;
@@ -169,17 +182,25 @@ namespace neolib::ecs
         virtual void async_create_entity(const std::function<void()>& aCreator) = 0; // todo: polymorphic functor
         virtual void commit_async_entity_creation() = 0;
         virtual void destroy_entity(entity_id aEntityId, bool aNotify = true) = 0;
+        virtual void create_entities(const entity_archetype_id& aArchetypeId, std::span<entity_id> aNewEntities) = 0;
+        virtual void destroy_entities(std::span<entity_id const> aEntities, bool aNotify = true) = 0;
+        virtual void commit_entities(const entity_archetype_id& aArchetypeId, std::span<entity_id const> aReservedEntities) = 0;
         virtual void async_destroy_entity(entity_id aEntityId, bool aNotify = true) = 0;
+        virtual void async_destroy_entities(std::span<entity_id const> aEntities, bool aNotify = true) = 0;
         virtual void commit_async_entity_destruction() = 0;
     public:
         virtual bool run_threaded(const system_id& aSystemId) const = 0;
         virtual bool is_child(const system_id& aSystemId, system_id& aParentSystemId) const = 0;
+        virtual bool is_scheduled(const system_id& aSystemId) const = 0;
+        virtual void set_scheduled(const system_id& aSystemId, bool aScheduled) = 0;
         virtual bool all_systems_paused() const = 0;
         virtual void pause_all_systems() = 0;
         virtual void resume_all_systems() = 0;
     public:
         virtual const archetype_registry_t& archetypes() const = 0;
         virtual archetype_registry_t& archetypes() = 0;
+        virtual const archetype_storages_t& archetype_storages() const = 0;
+        virtual archetype_storages_t& archetype_storages() = 0;
         virtual const component_factories_t& component_factories() const = 0;
         virtual component_factories_t& component_factories() = 0;
         virtual const components_t& components() const = 0;
@@ -207,10 +228,24 @@ namespace neolib::ecs
     public:
         virtual entity_id next_entity_id() = 0;
         virtual void free_entity_id(entity_id aId) = 0;
+        virtual generation_t entity_generation(entity_id aId) const = 0;
+    public:
+        virtual void save_world(const std::string& aPath) const = 0;
+        virtual void load_world(const std::string& aPath) = 0;
+    public:
+        virtual component_ordinal ordinal(component_id aComponentId) = 0;
+        virtual component_signature signature(entity_id aEntity) const = 0;
+        virtual bool matches(entity_id aEntity, const component_signature& aSignature) const = 0;
+        virtual bool has_component(entity_id aEntity, component_id aComponentId) const = 0;
+        virtual void entities_matching(const component_signature& aSignature, std::vector<entity_id>& aEntities) const = 0;
+        virtual void update_signatures(std::span<entity_id const> aEntities, component_ordinal aOrdinal, bool aPresent) = 0;
     public:
         virtual bool archetype_registered(const i_entity_archetype& aArchetype) const = 0;
         virtual void register_archetype(const i_entity_archetype& aArchetype) = 0;
         virtual void register_archetype(std::shared_ptr<const i_entity_archetype> aArchetype) = 0;
+        virtual bool archetype_storage_registered(entity_archetype_id aArchetypeId) const = 0;
+        virtual void register_archetype_storage(i_archetype_storage& aStorage) = 0;
+        virtual void unregister_archetype_storage(i_archetype_storage& aStorage) = 0;
         virtual bool component_registered(component_id aComponentId) const = 0;
         virtual void register_component(component_id aComponentId, component_factory aFactory) = 0;
         virtual bool shared_component_registered(component_id aComponentId) const = 0;
@@ -232,6 +267,14 @@ namespace neolib::ecs
         void async_create_entity(entity_archetype_id aArchetypeId, ComponentData... aComponentData);
         template <typename Archetype, typename... ComponentData>
         void async_create_entity(const Archetype& aArchetype, ComponentData... aComponentData);
+        template <typename... ComponentData>
+        std::vector<entity_id> create_entities(const entity_archetype_id& aArchetypeId, std::size_t aCount, const ComponentData&... aPrototype);
+        template <typename Archetype, typename... ComponentData>
+        std::vector<entity_id> create_entities(const Archetype& aArchetype, std::size_t aCount, const ComponentData&... aPrototype);
+        template <typename... ComponentData>
+        std::vector<entity_id> create_entities(const entity_archetype_id& aArchetypeId, const std::vector<ComponentData>&... aComponentData);
+        template <typename Archetype, typename... ComponentData>
+        std::vector<entity_id> create_entities(const Archetype& aArchetype, const std::vector<ComponentData>&... aComponentData);
     public:
         template <typename ComponentData, typename... ComponentDataRest>
         void populate(entity_id aEntity, ComponentData&& aComponentData, ComponentDataRest&&... aComponentDataRest)
@@ -255,6 +298,33 @@ namespace neolib::ecs
         {
             shared_component<ecs_data_type_t<ComponentData>>().populate(aName, std::forward<ComponentData>(aComponentData));
         }
+        entity_ref to_ref(entity_id aEntity) const
+        {
+            return entity_ref{ aEntity, entity_generation(aEntity) };
+        }
+        bool valid(entity_ref aEntity) const
+        {
+            auto const generation = entity_generation(aEntity.id);
+            return (generation & 1u) == 1u && generation == aEntity.generation;
+        }
+        entity_id resolve(entity_ref aEntity) const
+        {
+            if (!valid(aEntity))
+                throw stale_entity_ref();
+            return aEntity.id;
+        }
+        template <typename... ComponentData>
+        component_signature signature_of()
+        {
+            component_signature result;
+            (result.set(ordinal(ecs_data_type_t<ComponentData>::meta::id())), ...);
+            return result;
+        }
+        template <typename ComponentData>
+        bool has_component(entity_id aEntity) const
+        {
+            return has_component(aEntity, ecs_data_type_t<ComponentData>::meta::id());
+        }
         template <typename ComponentData>
         bool component_instantiated() const
         {
@@ -676,7 +746,7 @@ namespace neolib::ecs
         scoped_component_data_lock<std::decay_t<ComponentData>...> lock{ *this };
         auto newEntity = create_entity(aArchetypeId);
         populate(newEntity, std::forward<ComponentData>(aComponentData)...);
-        archetype(aArchetypeId).populate_default_components(*this, newEntity);
+        archetype(aArchetypeId).populate_default_components(*this, std::span<entity_id const>{ &newEntity, 1u });
         return newEntity;
     }
 
@@ -688,6 +758,48 @@ namespace neolib::ecs
         return create_entity(aArchetype.id(), std::forward<ComponentData>(aComponentData)...);
     }
 
+    template <typename... ComponentData>
+    inline std::vector<entity_id> i_ecs::create_entities(const entity_archetype_id& aArchetypeId, std::size_t aCount, const ComponentData&... aPrototype)
+    {
+        scoped_component_data_lock<std::decay_t<ComponentData>...> lock{ *this };
+        std::vector<entity_id> newEntities(aCount);
+        create_entities(aArchetypeId, std::span<entity_id>{ newEntities });
+        (component<ecs_data_type_t<ComponentData>>().populate(newEntities, aPrototype), ...);
+        archetype(aArchetypeId).populate_default_components(*this, std::span<entity_id const>{ newEntities });
+        return newEntities;
+    }
+
+    template <typename Archetype, typename... ComponentData>
+    inline std::vector<entity_id> i_ecs::create_entities(const Archetype& aArchetype, std::size_t aCount, const ComponentData&... aPrototype)
+    {
+        if (!archetype_registered(aArchetype))
+            register_archetype(aArchetype);
+        return create_entities(aArchetype.id(), aCount, aPrototype...);
+    }
+
+    template <typename... ComponentData>
+    inline std::vector<entity_id> i_ecs::create_entities(const entity_archetype_id& aArchetypeId, const std::vector<ComponentData>&... aComponentData)
+    {
+        static_assert(sizeof...(ComponentData) > 0, "neolib::ecs::i_ecs::create_entities: no component data");
+        std::size_t const counts[] = { aComponentData.size()... };
+        if (std::find_if(std::begin(counts), std::end(counts), [&](std::size_t aCount) { return aCount != counts[0]; }) != std::end(counts))
+            throw batch_size_mismatch();
+        scoped_component_data_lock<ComponentData...> lock{ *this };
+        std::vector<entity_id> newEntities(counts[0]);
+        create_entities(aArchetypeId, std::span<entity_id>{ newEntities });
+        (component<ecs_data_type_t<ComponentData>>().populate(newEntities, aComponentData), ...);
+        archetype(aArchetypeId).populate_default_components(*this, std::span<entity_id const>{ newEntities });
+        return newEntities;
+    }
+
+    template <typename Archetype, typename... ComponentData>
+    inline std::vector<entity_id> i_ecs::create_entities(const Archetype& aArchetype, const std::vector<ComponentData>&... aComponentData)
+    {
+        if (!archetype_registered(aArchetype))
+            register_archetype(aArchetype);
+        return create_entities(aArchetype.id(), aComponentData...);
+    }
+
     template <typename... ComponentData>
     inline void i_ecs::async_create_entity(entity_archetype_id aArchetypeId, ComponentData... aComponentData)
     {
@@ -36,6 +36,7 @@
 #pragma once
 
 #include <neolib/neolib.hpp>
+#include <span>
 #include <neolib/core/set.hpp>
 #include <neolib/core/allocator.hpp>
 #include <neolib/core/uuid.hpp>
@@ -54,5 +55,12 @@ namespace neolib::ecs
         virtual const neolib::i_set<component_id>& components() const = 0;
         virtual neolib::i_set<component_id>& components() = 0;
         virtual void populate_default_components(i_ecs& aEcs, entity_id aEntity) = 0;
+        // Batch-aware archetypes can override this to populate each default component once for a whole
+        // batch of new entities.
+        virtual void populate_default_components(i_ecs& aEcs, std::span<entity_id const> aEntities)
+        {
+            for (auto entity : aEntities)
+                populate_default_components(aEcs, entity);
+        }
     };
 }
\ No newline at end of file
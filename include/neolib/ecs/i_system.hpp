@@ -46,6 +46,13 @@ namespace neolib::ecs
 {
     class i_ecs;
 
+    enum class component_access : std::uint32_t
+    {
+        None        = 0x0,
+        ReadOnly    = 0x1,
+        ReadWrite   = 0x2
+    };
+
     class i_system
     {
     public:
@@ -65,6 +72,7 @@ namespace neolib::ecs
     public:
         virtual const i_component& component(component_id aComponentId) const = 0;
         virtual const i_component& component(component_id aComponentId) = 0;
+        virtual component_access access(component_id aComponentId) const = 0;
     public:
         virtual bool components_available() const = 0;
         virtual void update_component_availability() = 0;
@@ -0,0 +1,419 @@
+// soa_mirror.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <neolib/ecs/ecs_ids.hpp>
+#include <neolib/ecs/i_component_data.hpp>
+#include <neolib/ecs/component.hpp>
+
+namespace neolib::ecs
+{
+    constexpr std::size_t soa_column_alignment = 64u;
+
+    // Placement of one component data field within the record as derived from the field types given by
+    // the component's meta; a streamable field (arithmetic or basic vector) is mirrored as one column per
+    // lane.
+    struct soa_field
+    {
+        component_data_field_type type;
+        component_data_field_type scalarType;
+        std::size_t offset;
+        std::size_t size;
+        std::size_t alignment;
+        std::uint32_t lanes;
+    };
+
+    inline constexpr std::size_t scalar_field_size(component_data_field_type aScalarType)
+    {
+        switch (aScalarType)
+        {
+        case component_data_field_type::Bool:
+        case component_data_field_type::Int8:
+        case component_data_field_type::Uint8:
+            return 1u;
+        case component_data_field_type::Int16:
+        case component_data_field_type::Uint16:
+            return 2u;
+        case component_data_field_type::Int32:
+        case component_data_field_type::Uint32:
+        case component_data_field_type::Float32:
+            return 4u;
+        case component_data_field_type::Int64:
+        case component_data_field_type::Uint64:
+        case component_data_field_type::Float64:
+            return 8u;
+        default:
+            return 0u;
+        }
+    }
+
+    template <typename T>
+    inline constexpr component_data_field_type scalar_field_type()
+    {
+        if constexpr (std::is_same_v<T, bool>)
+            return component_data_field_type::Bool;
+        else if constexpr (std::is_same_v<T, float>)
+            return component_data_field_type::Float32;
+        else if constexpr (std::is_same_v<T, double>)
+            return component_data_field_type::Float64;
+        else if constexpr (std::is_integral_v<T> && sizeof(T) == 1u)
+            return std::is_signed_v<T> ? component_data_field_type::Int8 : component_data_field_type::Uint8;
+        else if constexpr (std::is_integral_v<T> && sizeof(T) == 2u)
+            return std::is_signed_v<T> ? component_data_field_type::Int16 : component_data_field_type::Uint16;
+        else if constexpr (std::is_integral_v<T> && sizeof(T) == 4u)
+            return std::is_signed_v<T> ? component_data_field_type::Int32 : component_data_field_type::Uint32;
+        else if constexpr (std::is_integral_v<T> && sizeof(T) == 8u)
+            return std::is_signed_v<T> ? component_data_field_type::Int64 : component_data_field_type::Uint64;
+        else
+            return component_data_field_type::Invalid;
+    }
+
+    // Size, alignment and lane count of a field whose representation follows from its type alone; the
+    // size is zero for fields whose representation the field type does not determine.
+    inline constexpr soa_field describe_field(component_data_field_type aFieldType)
+    {
+        auto constexpr kindMask = static_cast<component_data_field_type>(0xFEFFFFFFFFFF0000);
+        auto constexpr shapeMask = static_cast<component_data_field_type>(0x000000000000FF00);
+        auto constexpr scalarMask = static_cast<component_data_field_type>(0x00000000000000FF);
+        soa_field result = { aFieldType, aFieldType & scalarMask, 0u, 0u, 0u, 0u };
+        auto const scalarSize = scalar_field_size(result.scalarType);
+        if (scalarSize == 0u || (aFieldType & kindMask) != component_data_field_type::Invalid)
+            return result;
+        std::size_t count = 0u;
+        std::uint32_t lanes = 0u;
+        switch (aFieldType & shapeMask)
+        {
+        case component_data_field_type::Invalid:
+            count = 1u;
+            lanes = 1u;
+            break;
+        case component_data_field_type::BasicVec2:
+            count = 2u;
+            lanes = 2u;
+            break;
+        case component_data_field_type::BasicVec3:
+            count = 3u;
+            lanes = 3u;
+            break;
+        case component_data_field_type::BasicVec4:
+            count = 4u;
+            lanes = 4u;
+            break;
+        case component_data_field_type::BasicMat22:
+            count = 4u;
+            break;
+        case component_data_field_type::BasicMat33:
+            count = 9u;
+            break;
+        case component_data_field_type::BasicMat44:
+            count = 16u;
+            break;
+        case component_data_field_type::Aabb3d & shapeMask:
+            count = 6u;
+            break;
+        case component_data_field_type::Aabb2d & shapeMask:
+            count = 4u;
+            break;
+        default:
+            return result;
+        }
+        result.size = scalarSize * count;
+        result.alignment = scalarSize;
+        if ((aFieldType & component_data_field_type::Atomic) == component_data_field_type::Invalid)
+            result.lanes = lanes;
+        return result;
+    }
+
+    // Structure-of-arrays mirror of a component: each lane of each arithmetic or basic vector field is
+    // held in its own contiguous, cache line aligned column so that kernels can stream over a single
+    // field. update() re-gathers only the pages of the component modified since the previous update;
+    // commit() scatters the columns written through mutable_column() back into the component.
+    // Meta data publishes field types but not offsets, so a record cannot in general be split from meta
+    // data alone (which is why archetype storage keeps whole components per column). The mirror
+    // only copies, so it accepts a best guess: offsets are derived assuming the fields are declared in
+    // meta order with natural alignment, and the guess is rejected (unknown_layout) unless it accounts
+    // for exactly sizeof(value_type). A reordered struct can still pass that check, so components whose
+    // layout matters should supply the offsets through a static field_offset(uint32_t) meta member.
+    template <typename Data>
+    class soa_mirror
+    {
+    public:
+        struct unknown_layout : std::logic_error { unknown_layout() : std::logic_error("neolib::ecs::soa_mirror::unknown_layout") {} };
+        struct field_not_streamable : std::logic_error { field_not_streamable() : std::logic_error("neolib::ecs::soa_mirror::field_not_streamable") {} };
+        struct wrong_column_type : std::logic_error { wrong_column_type() : std::logic_error("neolib::ecs::soa_mirror::wrong_column_type") {} };
+        struct outdated : std::logic_error { outdated() : std::logic_error("neolib::ecs::soa_mirror::outdated") {} };
+    public:
+        typedef Data value_type;
+        typedef typename value_type::meta meta_type;
+        typedef neolib::ecs::component<value_type> component_type;
+        typedef typename component_type::version_t version_t;
+        static constexpr std::size_t page_size = component_type::snapshot_type::page_size;
+    private:
+        class column_storage
+        {
+        public:
+            column_storage(std::size_t aElementSize) :
+                iElementSize{ aElementSize }
+            {
+            }
+            column_storage(column_storage&&) = default;
+            column_storage& operator=(column_storage&&) = default;
+        public:
+            std::byte* data() const
+            {
+                return iData.get();
+            }
+            std::size_t element_size() const
+            {
+                return iElementSize;
+            }
+            void reserve(std::size_t aCapacity)
+            {
+                if (aCapacity <= iCapacity)
+                    return;
+                auto const newCapacity = std::max(aCapacity, iCapacity * 2u);
+                storage_ptr newData{ static_cast<std::byte*>(::operator new(newCapacity * iElementSize, std::align_val_t{ soa_column_alignment })) };
+                if (iData)
+                    std::memcpy(newData.get(), iData.get(), iCapacity * iElementSize);
+                iData = std::move(newData);
+                iCapacity = newCapacity;
+            }
+        public:
+            bool dirty = false;
+        private:
+            struct deleter
+            {
+                void operator()(std::byte* aData) const
+                {
+                    ::operator delete(aData, std::align_val_t{ soa_column_alignment });
+                }
+            };
+            typedef std::unique_ptr<std::byte[], deleter> storage_ptr;
+        private:
+            std::size_t iElementSize;
+            std::size_t iCapacity = 0u;
+            storage_ptr iData;
+        };
+    public:
+        soa_mirror(component_type& aComponent) :
+            iComponent{ aComponent },
+            iFields{ layout() }
+        {
+            for (auto const& field : iFields)
+            {
+                iFirstColumn.push_back(static_cast<std::uint32_t>(iColumns.size()));
+                for (std::uint32_t lane = 0u; lane < field.lanes; ++lane)
+                    iColumns.emplace_back(scalar_field_size(field.scalarType));
+            }
+        }
+        soa_mirror(soa_mirror const&) = delete;
+        soa_mirror& operator=(soa_mirror const&) = delete;
+    public:
+        static std::vector<soa_field> const& layout()
+        {
+            static std::vector<soa_field> const sLayout = compute_layout();
+            return sLayout;
+        }
+    public:
+        component_type& owner() const
+        {
+            return iComponent;
+        }
+        std::size_t size() const
+        {
+            return iEntities.size();
+        }
+        std::span<entity_id const> entities() const
+        {
+            return iEntities;
+        }
+        soa_field const& field(std::uint32_t aFieldIndex) const
+        {
+            return iFields.at(aFieldIndex);
+        }
+        template <typename T>
+        std::span<T const> column(std::uint32_t aFieldIndex, std::uint32_t aLane = 0u) const
+        {
+            return { reinterpret_cast<T const*>(column_for<T>(aFieldIndex, aLane).data()), size() };
+        }
+        template <typename T>
+        std::span<T> mutable_column(std::uint32_t aFieldIndex, std::uint32_t aLane = 0u)
+        {
+            auto& c = column_for<T>(aFieldIndex, aLane);
+            c.dirty = true;
+            return { reinterpret_cast<T*>(c.data()), size() };
+        }
+    public:
+        // Brings the mirror up to date with the component; returns the number of records gathered.
+        std::size_t update()
+        {
+            std::scoped_lock<component_mutex<value_type>> lock{ iComponent.mutex() };
+            auto const& data = std::as_const(iComponent).component_data();
+            auto const& entities = std::as_const(iComponent).entities();
+            auto const count = data.size();
+            auto const previousCount = iEntities.size();
+            iEntities.resize(count);
+            for (auto& c : iColumns)
+                c.reserve(count);
+            std::size_t gathered = 0u;
+            auto const pageCount = (count + page_size - 1u) / page_size;
+            for (std::size_t pageIndex = 0u; pageIndex < pageCount; ++pageIndex)
+            {
+                auto const first = pageIndex * page_size;
+                auto const last = std::min(count, first + page_size);
+                bool const modified = !iSynced || last > previousCount || pageIndex >= iComponent.page_count() ||
+                    iComponent.page_version(pageIndex) > *iSynced;
+                if (!modified)
+                    continue;
+                std::copy(std::next(entities.begin(), first), std::next(entities.begin(), last), std::next(iEntities.begin(), first));
+                gather(data, first, last);
+                gathered += last - first;
+            }
+            for (auto& c : iColumns)
+                c.dirty = false;
+            iSynced = iComponent.checkpoint();
+            return gathered;
+        }
+        // Writes the columns modified through mutable_column() back to the records they were gathered
+        // from; throws outdated if records were added, removed or reordered since the last update().
+        void commit()
+        {
+            std::scoped_lock<component_mutex<value_type>> lock{ iComponent.mutex() };
+            auto const& entities = std::as_const(iComponent).entities();
+            if (entities.size() != iEntities.size() || !std::equal(entities.begin(), entities.end(), iEntities.begin()))
+                throw outdated();
+            bool const current = iSynced && std::ranges::all_of(std::views::iota(std::size_t{ 0u }, iComponent.page_count()),
+                [&](std::size_t aPageIndex) { return iComponent.page_version(aPageIndex) <= *iSynced; });
+            auto const& data = std::as_const(iComponent).component_data();
+            for (std::uint32_t fieldIndex = 0u; fieldIndex < iFields.size(); ++fieldIndex)
+            {
+                auto const& field = iFields[fieldIndex];
+                for (std::uint32_t lane = 0u; lane < field.lanes; ++lane)
+                {
+                    auto& c = iColumns[iFirstColumn[fieldIndex] + lane];
+                    if (!c.dirty)
+                        continue;
+                    auto const elementSize = c.element_size();
+                    auto const offset = field.offset + lane * elementSize;
+                    auto source = c.data();
+                    for (std::size_t index = 0u; index < data.size(); ++index, source += elementSize)
+                        if (std::memcmp(reinterpret_cast<std::byte const*>(&data[index]) + offset, source, elementSize) != 0)
+                            std::memcpy(reinterpret_cast<std::byte*>(&iComponent[index]) + offset, source, elementSize);
+                    c.dirty = false;
+                }
+            }
+            if (current)
+                iSynced = iComponent.checkpoint();
+        }
+    private:
+        static std::vector<soa_field> compute_layout()
+        {
+            std::vector<soa_field> result;
+            std::size_t offset = 0u;
+            std::size_t alignment = 1u;
+            for (std::uint32_t fieldIndex = 0u; fieldIndex < meta_type::field_count(); ++fieldIndex)
+            {
+                auto field = describe_field(meta_type::field_type(fieldIndex));
+                if constexpr (requires { meta_type::field_offset(fieldIndex); })
+                    field.offset = meta_type::field_offset(fieldIndex);
+                else
+                {
+                    if (field.size == 0u)
+                        throw unknown_layout();
+                    field.offset = (offset + field.alignment - 1u) / field.alignment * field.alignment;
+                    offset = field.offset + field.size;
+                    alignment = std::max(alignment, field.alignment);
+                }
+                if (field.lanes != 0u && field.offset + field.size > sizeof(value_type))
+                    throw unknown_layout();
+                result.push_back(field);
+            }
+            if constexpr (!requires { meta_type::field_offset(0u); })
+                if ((offset + alignment - 1u) / alignment * alignment != sizeof(value_type))
+                    throw unknown_layout();
+            return result;
+        }
+        template <typename T>
+        column_storage& column_for(std::uint32_t aFieldIndex, std::uint32_t aLane) const
+        {
+            auto const& field = iFields.at(aFieldIndex);
+            if (aLane >= field.lanes)
+                throw field_not_streamable();
+            if (scalar_field_type<T>() != field.scalarType)
+                throw wrong_column_type();
+            return const_cast<column_storage&>(iColumns[iFirstColumn[aFieldIndex] + aLane]);
+        }
+        template <typename Container>
+        void gather(Container const& aData, std::size_t aFirst, std::size_t aLast)
+        {
+            for (std::uint32_t fieldIndex = 0u; fieldIndex < iFields.size(); ++fieldIndex)
+            {
+                auto const& field = iFields[fieldIndex];
+                for (std::uint32_t lane = 0u; lane < field.lanes; ++lane)
+                {
+                    auto& c = iColumns[iFirstColumn[fieldIndex] + lane];
+                    auto const elementSize = c.element_size();
+                    auto const offset = field.offset + lane * elementSize;
+                    auto destination = c.data() + aFirst * elementSize;
+                    for (auto index = aFirst; index < aLast; ++index)
+                    {
+                        std::memcpy(destination, reinterpret_cast<std::byte const*>(&aData[index]) + offset, elementSize);
+                        destination += elementSize;
+                    }
+                }
+            }
+        }
+    private:
+        component_type& iComponent;
+        std::vector<soa_field> const& iFields;
+        std::vector<std::uint32_t> iFirstColumn;
+        std::vector<column_storage> iColumns;
+        std::vector<entity_id> iEntities;
+        std::optional<version_t> iSynced;
+    };
+}
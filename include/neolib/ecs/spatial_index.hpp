@@ -0,0 +1,527 @@
+// spatial_index.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <shared_mutex>
+#include <span>
+#include <vector>
+#include <neolib/core/numerical.hpp>
+#include <neolib/task/event.hpp>
+#include <neolib/ecs/ecs_ids.hpp>
+#include <neolib/ecs/i_ecs.hpp>
+#include <neolib/ecs/component.hpp>
+
+namespace neolib::ecs
+{
+    // Dynamic bounding volume hierarchy over the bounds held in a component. Leaves keep a box enlarged by
+    // a margin so that small movements only update the leaf. update() consumes the component's change stamps
+    // and the ecs destruction events so that only changed entities are visited. Queries take a shared lock
+    // and may run concurrently from parallel systems; update() takes an exclusive lock.
+    template <typename Data, typename Vertex = vec3>
+    class spatial_index
+    {
+    public:
+        typedef Data data_type;
+        typedef Vertex vertex_type;
+        typedef typename Vertex::value_type coordinate_type;
+        typedef basic_aabb<Vertex> aabb_type;
+        typedef std::function<aabb_type(const Data&)> projection;
+        typedef typename component<Data>::version_t version_t;
+    private:
+        typedef std::uint32_t node_index;
+        static constexpr node_index null_node = ~node_index{};
+        struct node
+        {
+            aabb_type box;
+            aabb_type bounds;
+            node_index parent = null_node;
+            node_index left = null_node;
+            node_index right = null_node;
+            entity_id entity = null_entity;
+            std::int32_t height = 0;
+
+            bool leaf() const
+            {
+                return left == null_node;
+            }
+        };
+    public:
+        spatial_index(i_ecs& aEcs, projection aProjection, coordinate_type aMargin = static_cast<coordinate_type>(0.1)) :
+            iEcs{ aEcs }, iProjection{ std::move(aProjection) }, iMargin{ aMargin }, iVersion{ 0u }, iRoot{ null_node }, iFreeNodes{ null_node }
+        {
+            iSink += aEcs.entity_destroyed([this](entity_id aEntity)
+            {
+                std::scoped_lock lock{ iRemovalMutex };
+                iRemovals.push_back(aEntity);
+            });
+            iSink += aEcs.entities_destroyed([this](std::span<entity_id const> aEntities)
+            {
+                std::scoped_lock lock{ iRemovalMutex };
+                iRemovals.insert(iRemovals.end(), aEntities.begin(), aEntities.end());
+            });
+        }
+        spatial_index(const spatial_index&) = delete;
+        spatial_index& operator=(const spatial_index&) = delete;
+    public:
+        i_ecs& ecs() const
+        {
+            return iEcs;
+        }
+        std::size_t size() const
+        {
+            std::shared_lock lock{ iMutex };
+            return iLeafCount;
+        }
+        std::int32_t height() const
+        {
+            std::shared_lock lock{ iMutex };
+            return iRoot != null_node ? iNodes[iRoot].height : 0;
+        }
+        bool contains(entity_id aEntity) const
+        {
+            std::shared_lock lock{ iMutex };
+            return leaf_of(aEntity) != null_node;
+        }
+        std::optional<aabb_type> bounds(entity_id aEntity) const
+        {
+            std::shared_lock lock{ iMutex };
+            auto const leaf = leaf_of(aEntity);
+            if (leaf == null_node)
+                return {};
+            return iNodes[leaf].bounds;
+        }
+    public:
+        // Brings the index up to date with records changed since the previous update and with entities
+        // destroyed since then.
+        void update()
+        {
+            auto& bounds = iEcs.component<Data>();
+            if (!bounds.change_tracking())
+                bounds.enable_change_tracking();
+            std::unique_lock lock{ iMutex };
+            std::vector<entity_id> removals;
+            {
+                std::scoped_lock removalLock{ iRemovalMutex };
+                removals.swap(iRemovals);
+            }
+            for (auto entity : removals)
+                remove(entity);
+            auto const since = iVersion;
+            iVersion = bounds.checkpoint();
+            bounds.changed_since(since, [&](entity_id aEntity, const Data& aData)
+            {
+                upsert(aEntity, iProjection(aData));
+            });
+            if (iLeafCount > to_const(bounds).entities().size())
+            {
+                // records were destroyed without their entity being destroyed
+                for (entity_id entity = 1u; entity < iLeaves.size(); ++entity)
+                    if (iLeaves[entity] != null_node && !bounds.has_entity_record(entity))
+                        remove(entity);
+            }
+        }
+    public:
+        template <typename Callable>
+        void overlapping(const aabb_type& aBox, const Callable& aCallable) const
+        {
+            std::shared_lock lock{ iMutex };
+            traverse([&](const node& aNode) { return aabb_intersects(aNode.box, aBox); }, [&](const node& aLeaf)
+            {
+                if (aabb_intersects(aLeaf.bounds, aBox))
+                    aCallable(aLeaf.entity);
+            });
+        }
+        void overlapping(const aabb_type& aBox, std::vector<entity_id>& aEntities) const
+        {
+            overlapping(aBox, [&](entity_id aEntity) { aEntities.push_back(aEntity); });
+        }
+        template <typename Callable>
+        void within(const Vertex& aPoint, coordinate_type aRadius, const Callable& aCallable) const
+        {
+            std::shared_lock lock{ iMutex };
+            auto const radiusSquared = aRadius * aRadius;
+            traverse([&](const node& aNode) { return distance_squared(aNode.box, aPoint) <= radiusSquared; }, [&](const node& aLeaf)
+            {
+                if (distance_squared(aLeaf.bounds, aPoint) <= radiusSquared)
+                    aCallable(aLeaf.entity);
+            });
+        }
+        // Visits every entity whose bounds are hit by the ray aOrigin + t * aDirection for t in [0, aMaxDistance],
+        // passing the entry parameter t.
+        template <typename Callable>
+        void raycast(const Vertex& aOrigin, const Vertex& aDirection, coordinate_type aMaxDistance, const Callable& aCallable) const
+        {
+            std::shared_lock lock{ iMutex };
+            traverse([&](const node& aNode) { return ray_entry(aNode.box, aOrigin, aDirection, aMaxDistance).has_value(); }, [&](const node& aLeaf)
+            {
+                auto const entry = ray_entry(aLeaf.bounds, aOrigin, aDirection, aMaxDistance);
+                if (entry)
+                    aCallable(aLeaf.entity, *entry);
+            });
+        }
+        std::optional<std::pair<entity_id, coordinate_type>> nearest_hit(const Vertex& aOrigin, const Vertex& aDirection, coordinate_type aMaxDistance) const
+        {
+            std::shared_lock lock{ iMutex };
+            std::optional<std::pair<entity_id, coordinate_type>> result;
+            auto limit = aMaxDistance;
+            traverse([&](const node& aNode) { return ray_entry(aNode.box, aOrigin, aDirection, limit).has_value(); }, [&](const node& aLeaf)
+            {
+                auto const entry = ray_entry(aLeaf.bounds, aOrigin, aDirection, limit);
+                if (entry && (!result || *entry < result->second || (*entry == result->second && aLeaf.entity < result->first)))
+                {
+                    result.emplace(aLeaf.entity, *entry);
+                    limit = *entry;
+                }
+            });
+            return result;
+        }
+        // The aCount entities whose bounds are closest to aPoint, nearest first; ties are ordered by entity id.
+        void nearest(const Vertex& aPoint, std::size_t aCount, std::vector<entity_id>& aEntities) const
+        {
+            std::shared_lock lock{ iMutex };
+            if (iRoot == null_node || aCount == 0u)
+                return;
+            typedef std::pair<coordinate_type, node_index> pending_t;
+            typedef std::pair<coordinate_type, entity_id> found_t;
+            std::priority_queue<pending_t, std::vector<pending_t>, std::greater<pending_t>> pending;
+            std::priority_queue<found_t> found;
+            pending.emplace(distance_squared(iNodes[iRoot].box, aPoint), iRoot);
+            while (!pending.empty())
+            {
+                auto const [distance, index] = pending.top();
+                pending.pop();
+                if (found.size() == aCount && distance > found.top().first)
+                    break;
+                auto const& n = iNodes[index];
+                if (n.leaf())
+                {
+                    found_t const candidate{ distance_squared(n.bounds, aPoint), n.entity };
+                    if (found.size() < aCount)
+                        found.push(candidate);
+                    else if (candidate < found.top())
+                    {
+                        found.pop();
+                        found.push(candidate);
+                    }
+                }
+                else
+                {
+                    pending.emplace(distance_squared(iNodes[n.left].box, aPoint), n.left);
+                    pending.emplace(distance_squared(iNodes[n.right].box, aPoint), n.right);
+                }
+            }
+            auto const first = aEntities.size();
+            aEntities.resize(first + found.size());
+            for (auto i = aEntities.size(); i-- > first; found.pop())
+                aEntities[i] = found.top().second;
+        }
+    private:
+        node_index leaf_of(entity_id aEntity) const
+        {
+            return aEntity < iLeaves.size() ? iLeaves[aEntity] : null_node;
+        }
+        template <typename Descend, typename Visit>
+        void traverse(const Descend& aDescend, const Visit& aVisit) const
+        {
+            if (iRoot == null_node)
+                return;
+            thread_local std::vector<node_index> tStack;
+            auto const base = tStack.size();
+            tStack.push_back(iRoot);
+            while (tStack.size() > base)
+            {
+                auto const index = tStack.back();
+                tStack.pop_back();
+                auto const& n = iNodes[index];
+                if (!aDescend(n))
+                    continue;
+                if (n.leaf())
+                    aVisit(n);
+                else
+                {
+                    tStack.push_back(n.right);
+                    tStack.push_back(n.left);
+                }
+            }
+        }
+        static coordinate_type surface_area(const aabb_type& aBox)
+        {
+            auto const extents = aBox.max - aBox.min;
+            return static_cast<coordinate_type>(2.0) * (extents.x * extents.y + extents.y * extents.z + extents.z * extents.x);
+        }
+        static coordinate_type distance_squared(const aabb_type& aBox, const Vertex& aPoint)
+        {
+            coordinate_type result = {};
+            for (std::uint32_t axis = 0u; axis < 3u; ++axis)
+            {
+                auto const delta = std::max({ aBox.min[axis] - aPoint[axis], aPoint[axis] - aBox.max[axis], coordinate_type{} });
+                result += delta * delta;
+            }
+            return result;
+        }
+        static std::optional<coordinate_type> ray_entry(const aabb_type& aBox, const Vertex& aOrigin, const Vertex& aDirection, coordinate_type aMaxDistance)
+        {
+            coordinate_type entry = {};
+            coordinate_type exit = aMaxDistance;
+            for (std::uint32_t axis = 0u; axis < 3u; ++axis)
+            {
+                if (aDirection[axis] == coordinate_type{})
+                {
+                    if (aOrigin[axis] < aBox.min[axis] || aOrigin[axis] > aBox.max[axis])
+                        return {};
+                    continue;
+                }
+                auto const inverse = static_cast<coordinate_type>(1.0) / aDirection[axis];
+                auto lower = (aBox.min[axis] - aOrigin[axis]) * inverse;
+                auto upper = (aBox.max[axis] - aOrigin[axis]) * inverse;
+                if (lower > upper)
+                    std::swap(lower, upper);
+                entry = std::max(entry, lower);
+                exit = std::min(exit, upper);
+                if (entry > exit)
+                    return {};
+            }
+            return entry;
+        }
+        aabb_type fattened(const aabb_type& aBox) const
+        {
+            Vertex margin;
+            for (std::uint32_t axis = 0u; axis < 3u; ++axis)
+                margin[axis] = iMargin;
+            return aabb_type{ aBox.min - margin, aBox.max + margin };
+        }
+        void upsert(entity_id aEntity, const aabb_type& aBounds)
+        {
+            auto leaf = leaf_of(aEntity);
+            if (leaf != null_node)
+            {
+                iNodes[leaf].bounds = aBounds;
+                if (aabb_contains(iNodes[leaf].box, aBounds))
+                    return;
+                remove_leaf(leaf);
+            }
+            else
+            {
+                leaf = allocate_node();
+                if (iLeaves.size() <= aEntity)
+                    iLeaves.resize(aEntity + 1u, null_node);
+                iLeaves[aEntity] = leaf;
+                iNodes[leaf].entity = aEntity;
+                iNodes[leaf].bounds = aBounds;
+                ++iLeafCount;
+            }
+            iNodes[leaf].box = fattened(aBounds);
+            insert_leaf(leaf);
+        }
+        void remove(entity_id aEntity)
+        {
+            auto const leaf = leaf_of(aEntity);
+            if (leaf == null_node)
+                return;
+            remove_leaf(leaf);
+            free_node(leaf);
+            iLeaves[aEntity] = null_node;
+            --iLeafCount;
+        }
+        node_index allocate_node()
+        {
+            if (iFreeNodes == null_node)
+            {
+                iNodes.emplace_back();
+                return static_cast<node_index>(iNodes.size() - 1u);
+            }
+            auto const result = iFreeNodes;
+            iFreeNodes = iNodes[result].parent;
+            iNodes[result] = node{};
+            return result;
+        }
+        void free_node(node_index aNode)
+        {
+            iNodes[aNode] = node{};
+            iNodes[aNode].parent = iFreeNodes;
+            iFreeNodes = aNode;
+        }
+        void insert_leaf(node_index aLeaf)
+        {
+            if (iRoot == null_node)
+            {
+                iRoot = aLeaf;
+                iNodes[aLeaf].parent = null_node;
+                return;
+            }
+            auto const leafBox = iNodes[aLeaf].box;
+            auto sibling = iRoot;
+            while (!iNodes[sibling].leaf())
+            {
+                auto const& n = iNodes[sibling];
+                auto const area = surface_area(n.box);
+                auto const combinedArea = surface_area(aabb_union(n.box, leafBox));
+                auto const cost = static_cast<coordinate_type>(2.0) * combinedArea;
+                auto const inheritanceCost = static_cast<coordinate_type>(2.0) * (combinedArea - area);
+                auto const descentCost = [&](node_index aChild)
+                {
+                    auto const& child = iNodes[aChild];
+                    auto const unionArea = surface_area(aabb_union(child.box, leafBox));
+                    return (child.leaf() ? unionArea : unionArea - surface_area(child.box)) + inheritanceCost;
+                };
+                auto const leftCost = descentCost(n.left);
+                auto const rightCost = descentCost(n.right);
+                if (cost < leftCost && cost < rightCost)
+                    break;
+                sibling = leftCost < rightCost ? n.left : n.right;
+            }
+            auto const oldParent = iNodes[sibling].parent;
+            auto const newParent = allocate_node();
+            iNodes[newParent].parent = oldParent;
+            iNodes[newParent].box = aabb_union(leafBox, iNodes[sibling].box);
+            iNodes[newParent].height = iNodes[sibling].height + 1;
+            iNodes[newParent].left = sibling;
+            iNodes[newParent].right = aLeaf;
+            if (oldParent != null_node)
+                replace_child(oldParent, sibling, newParent);
+            else
+                iRoot = newParent;
+            iNodes[sibling].parent = newParent;
+            iNodes[aLeaf].parent = newParent;
+            refit(newParent);
+        }
+        void remove_leaf(node_index aLeaf)
+        {
+            if (aLeaf == iRoot)
+            {
+                iRoot = null_node;
+                return;
+            }
+            auto const parent = iNodes[aLeaf].parent;
+            auto const grandParent = iNodes[parent].parent;
+            auto const sibling = iNodes[parent].left == aLeaf ? iNodes[parent].right : iNodes[parent].left;
+            iNodes[sibling].parent = grandParent;
+            if (grandParent != null_node)
+            {
+                replace_child(grandParent, parent, sibling);
+                free_node(parent);
+                refit(grandParent);
+            }
+            else
+            {
+                iRoot = sibling;
+                free_node(parent);
+            }
+            iNodes[aLeaf].parent = null_node;
+        }
+        void replace_child(node_index aParent, node_index aOld, node_index aNew)
+        {
+            if (iNodes[aParent].left == aOld)
+                iNodes[aParent].left = aNew;
+            else
+                iNodes[aParent].right = aNew;
+        }
+        void refit(node_index aNode)
+        {
+            for (auto index = aNode; index != null_node; index = iNodes[index].parent)
+            {
+                index = balance(index);
+                auto& n = iNodes[index];
+                n.height = 1 + std::max(iNodes[n.left].height, iNodes[n.right].height);
+                n.box = aabb_union(iNodes[n.left].box, iNodes[n.right].box);
+            }
+        }
+        // Rotates the taller grandchild up when the subtree at aA is unbalanced; returns the subtree's new root.
+        node_index balance(node_index aA)
+        {
+            auto& a = iNodes[aA];
+            if (a.leaf() || a.height < 2)
+                return aA;
+            auto const iB = a.left;
+            auto const iC = a.right;
+            auto const difference = iNodes[iC].height - iNodes[iB].height;
+            if (difference > 1)
+                return rotate(aA, iC, iB, false);
+            if (difference < -1)
+                return rotate(aA, iB, iC, true);
+            return aA;
+        }
+        node_index rotate(node_index aA, node_index aUp, node_index aStay, bool aUpIsLeft)
+        {
+            auto& a = iNodes[aA];
+            auto& up = iNodes[aUp];
+            auto const iF = up.left;
+            auto const iG = up.right;
+            up.left = aA;
+            up.parent = a.parent;
+            a.parent = aUp;
+            if (up.parent != null_node)
+                replace_child(up.parent, aA, aUp);
+            else
+                iRoot = aUp;
+            auto const taller = iNodes[iF].height > iNodes[iG].height ? iF : iG;
+            auto const shorter = taller == iF ? iG : iF;
+            up.right = taller;
+            if (aUpIsLeft)
+                a.left = shorter;
+            else
+                a.right = shorter;
+            iNodes[shorter].parent = aA;
+            a.box = aabb_union(iNodes[aStay].box, iNodes[shorter].box);
+            a.height = 1 + std::max(iNodes[aStay].height, iNodes[shorter].height);
+            up.box = aabb_union(a.box, iNodes[taller].box);
+            up.height = 1 + std::max(a.height, iNodes[taller].height);
+            return aUp;
+        }
+    private:
+        i_ecs& iEcs;
+        projection iProjection;
+        coordinate_type iMargin;
+        mutable std::shared_mutex iMutex;
+        version_t iVersion;
+        std::vector<node> iNodes;
+        std::vector<node_index> iLeaves;
+        node_index iRoot;
+        node_index iFreeNodes;
+        std::size_t iLeafCount = 0u;
+        std::mutex iRemovalMutex;
+        std::vector<entity_id> iRemovals;
+        sink iSink;
+    };
+}
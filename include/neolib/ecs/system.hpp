@@ -82,26 +82,26 @@ namespace neolib::ecs
         system(i_ecs& aEcs) :
             iEcs{ aEcs }, iComponents{ ComponentData::meta::id()... }, iPaused{ 0u }
         {
-            (ecs().template component<ComponentData>(), ...);
+            (ecs().template component<ecs_data_type_t<ComponentData>>(), ...);
             update_component_availability();
         }
         system(const system& aOther) :
             iEcs{ aOther.iEcs }, iComponents{ aOther.iComponents }, iPaused{ 0u }
         {
-            (ecs().template component<ComponentData>(), ...);
+            (ecs().template component<ecs_data_type_t<ComponentData>>(), ...);
             update_component_availability();
         }
         system(system&& aOther) :
             iEcs{ aOther.iEcs }, iComponents{ std::move(aOther.iComponents) }, iPaused{ 0u }
         {
-            (ecs().template component<ComponentData>(), ...);
+            (ecs().template component<ecs_data_type_t<ComponentData>>(), ...);
             update_component_availability();
         }
         template <typename ComponentIdIter>
         system(i_ecs& aEcs, ComponentIdIter aFirstComponent, ComponentIdIter aLastComponent) :
             iEcs{ aEcs }, iComponents{ aFirstComponent, aLastComponent }, iPaused{ 0u }
         {
-            (ecs().template component<ComponentData>(), ...);
+            (ecs().template component<ecs_data_type_t<ComponentData>>(), ...);
             update_component_availability();
             if (ecs().all_systems_paused())
                 pause();
@@ -132,6 +132,22 @@ namespace neolib::ecs
         {
             return ecs().component(aComponentId);
         }
+        component_access access(component_id aComponentId) const final
+        {
+            // const qualified component data declares read-only access; any other component
+            // in the system's component list is assumed to be mutated.
+            auto result = component_access::None;
+            auto merge = [&](component_access aAccess)
+            {
+                if (static_cast<std::uint32_t>(aAccess) > static_cast<std::uint32_t>(result))
+                    result = aAccess;
+            };
+            ((ComponentData::meta::id() == aComponentId ? 
+                merge(std::is_const_v<ComponentData> ? component_access::ReadOnly : component_access::ReadWrite) : void()), ...);
+            if (result == component_access::None && components().find(aComponentId) != components().end())
+                result = component_access::ReadWrite;
+            return result;
+        }
     public:
         bool components_available() const final
         {
@@ -139,7 +155,7 @@ namespace neolib::ecs
         }
         void update_component_availability() final
         {
-            iComponentsAvailable.store((ecs().template component_instantiated<ComponentData>() && ...));
+            iComponentsAvailable.store((ecs().template component_instantiated<ecs_data_type_t<ComponentData>>() && ...));
         }
         bool can_apply() const final
         {
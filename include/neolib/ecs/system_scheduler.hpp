@@ -0,0 +1,104 @@
+// system_scheduler.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <neolib/ecs/i_ecs.hpp>
+#include <neolib/ecs/i_system.hpp>
+#include <neolib/ecs/frame_pacer.hpp>
+
+namespace neolib::ecs
+{
+    // Applies a set of (unthreaded) systems once per frame on the ECS thread pool. Systems that
+    // do not conflict (no shared component with mutable access) run concurrently; conflicting
+    // systems run in the order they were added. Component locks are still taken: threaded systems,
+    // command buffer commits and other threads may touch the same components during a frame.
+    class NEOLIB_EXPORT system_scheduler
+    {
+    public:
+        struct system_already_scheduled : std::logic_error { system_already_scheduled() : std::logic_error("neolib::ecs::system_scheduler::system_already_scheduled") {} };
+        struct system_not_scheduled : std::logic_error { system_not_scheduled() : std::logic_error("neolib::ecs::system_scheduler::system_not_scheduled") {} };
+        struct frame_in_progress : std::logic_error { frame_in_progress() : std::logic_error("neolib::ecs::system_scheduler::frame_in_progress") {} };
+    private:
+        struct node
+        {
+            i_system* system;
+            std::vector<std::size_t> successors;
+            std::size_t predecessors = 0u;
+        };
+    public:
+        system_scheduler(i_ecs& aEcs);
+        ~system_scheduler();
+    public:
+        i_ecs& ecs() const;
+        const std::vector<i_system*>& systems() const;
+        void add(i_system& aSystem);
+        void remove(i_system& aSystem);
+        static bool conflicts(const i_system& aLhs, const i_system& aRhs);
+    public:
+        void run_frame();
+        std::size_t run_paced_frame(frame_pacer& aPacer);
+        std::size_t frame_batches() const;
+    public:
+        template <typename System>
+        void add()
+        {
+            add(ecs().system<System>());
+        }
+    private:
+        void build_graph();
+        void dispatch(std::size_t aNode);
+        void execute(std::size_t aNode);
+    private:
+        i_ecs& iEcs;
+        std::vector<i_system*> iSystems;
+        std::vector<node> iGraph;
+        std::unique_ptr<std::atomic<std::size_t>[]> iPending;
+        std::size_t iBatches = 0u;
+        std::mutex iMutex;
+        std::condition_variable iFrameDone;
+        std::size_t iRemaining = 0u;
+        std::size_t iDispatched = 0u;
+        std::exception_ptr iError;
+        std::atomic<bool> iInFrame = false;
+    };
+}
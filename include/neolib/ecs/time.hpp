@@ -36,6 +36,7 @@
 #pragma once
 
 #include <neolib/neolib.hpp>
+#include <neolib/core/timing_wheel.hpp>
 #include <neolib/ecs/ecs.hpp>
 #include <neolib/ecs/chrono.hpp>
 #include <neolib/ecs/system.hpp>
@@ -77,5 +78,8 @@ namespace neolib::ecs
         neolib::ecs::component<entity_life_span>& iLifeSpans;
         clock& iWorldClock;
         mutable optional_step_time iSystemTimeOffset;
+        neolib::ecs::component<entity_life_span>::version_t iLifeSpansVersion;
+        timing_wheel<step_time, entity_ref> iExpiries;
+        std::vector<entity_id> iExpired;
     };
 }
\ No newline at end of file
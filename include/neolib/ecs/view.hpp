@@ -0,0 +1,214 @@
+// view.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <array>
+#include <limits>
+#include <tuple>
+#include <neolib/task/thread_pool.hpp>
+#include <neolib/ecs/ecs_ids.hpp>
+#include <neolib/ecs/i_ecs.hpp>
+#include <neolib/ecs/component.hpp>
+
+namespace neolib::ecs
+{
+    // Join over the entities that have a record in every one of the given components. The component
+    // with the fewest records drives the iteration and the others are probed through their reverse
+    // indices. Const qualified component data is passed to the callable by const reference.
+    template <typename... ComponentData>
+    class view
+    {
+        static_assert(sizeof...(ComponentData) > 0, "neolib::ecs::view: no components");
+    public:
+        template <typename Data>
+        using component_type = std::conditional_t<std::is_const_v<Data>, 
+            neolib::ecs::component<ecs_data_type_t<Data>> const,
+            neolib::ecs::component<ecs_data_type_t<Data>>>;
+        typedef std::tuple<component_type<ComponentData>*...> components_t;
+        static constexpr std::size_t default_grain_size = 1024u;
+    private:
+        typedef std::array<std::size_t, sizeof...(ComponentData)> record_indices_t;
+        template <typename Data>
+        struct probe
+        {
+            component_type<Data>* component;
+            decltype(std::as_const(std::declval<component_type<Data>&>()).component_data().data()) data;
+            std::size_t const* reverseIndices;
+            std::size_t reverseIndexCount;
+            // Writable records are fetched through the component so that only those visited are marked
+            // modified.
+            decltype(auto) record(std::size_t aIndex) const
+            {
+                if constexpr (std::is_const_v<component_type<Data>>)
+                    return data[aIndex];
+                else
+                    return (*component)[aIndex];
+            }
+        };
+        typedef std::tuple<probe<ComponentData>...> probes_t;
+        static constexpr std::size_t invalid = ~std::size_t{};
+    public:
+        view(i_ecs& aEcs) :
+            iEcs{ aEcs }, iComponents{ &aEcs.component<ecs_data_type_t<ComponentData>>()... }
+        {
+        }
+    public:
+        i_ecs& ecs() const
+        {
+            return iEcs;
+        }
+        template <typename Data>
+        component_type<Data>& component() const
+        {
+            return *std::get<component_type<Data>*>(iComponents);
+        }
+        std::size_t driver_no_lock() const
+        {
+            std::size_t result = 0u;
+            std::size_t smallest = std::numeric_limits<std::size_t>::max();
+            std::size_t index = 0u;
+            std::apply([&](auto*... components)
+            {
+                ((to_const(*components).entities().size() < smallest ? 
+                    (void)(smallest = to_const(*components).entities().size(), result = index++) : (void)index++), ...);
+            }, iComponents);
+            return result;
+        }
+        std::size_t size_hint_no_lock() const
+        {
+            std::size_t smallest = std::numeric_limits<std::size_t>::max();
+            std::apply([&](auto*... components) { ((smallest = std::min(smallest, to_const(*components).entities().size())), ...); }, iComponents);
+            return smallest;
+        }
+        bool contains_no_lock(entity_id aEntity) const
+        {
+            return std::apply([&](auto*... components) { return (components->has_entity_record_no_lock(aEntity) && ...); }, iComponents);
+        }
+    public:
+        template <typename Callable>
+        void for_each(Callable&& aCallable) const
+        {
+            scoped_component_data_lock<ecs_data_type_t<ComponentData>...> lock{ iEcs };
+            for_each_no_lock(std::forward<Callable>(aCallable));
+        }
+        template <typename Callable>
+        void for_each_no_lock(Callable&& aCallable) const
+        {
+            auto const driver = driver_no_lock();
+            auto const probes = make_probes();
+            visit_driver(driver, [&](auto aDriver)
+            {
+                auto const count = to_const(*std::get<decltype(aDriver)::value>(probes).component).entities().size();
+                visit_range<decltype(aDriver)::value>(probes, 0u, count, aCallable);
+            });
+        }
+        template <typename Callable>
+        void parallel_for_each(Callable&& aCallable, std::size_t aGrainSize = default_grain_size) const
+        {
+            scoped_component_data_lock<ecs_data_type_t<ComponentData>...> lock{ iEcs };
+            parallel_for_each_no_lock(std::forward<Callable>(aCallable), aGrainSize);
+        }
+        template <typename Callable>
+        void parallel_for_each_no_lock(Callable&& aCallable, std::size_t aGrainSize = default_grain_size) const
+        {
+            auto const driver = driver_no_lock();
+            auto const probes = make_probes();
+            visit_driver(driver, [&](auto aDriver)
+            {
+                auto const count = to_const(*std::get<decltype(aDriver)::value>(probes).component).entities().size();
+                neolib::parallel_chunks(ecs().thread_pool(), count, aGrainSize, [&](std::size_t aFirst, std::size_t aLast)
+                {
+                    visit_range<decltype(aDriver)::value>(probes, aFirst, aLast, aCallable);
+                });
+            });
+        }
+    private:
+        probes_t make_probes() const
+        {
+            return std::apply([](auto*... components)
+            {
+                return probes_t{ probe<ComponentData>{ components, to_const(*components).component_data().data(), 
+                    to_const(*components).reverse_indices().data(), to_const(*components).reverse_indices().size() }... };
+            }, iComponents);
+        }
+        template <typename Visitor>
+        static void visit_driver(std::size_t aDriver, Visitor&& aVisitor)
+        {
+            visit_driver(aDriver, std::forward<Visitor>(aVisitor), std::index_sequence_for<ComponentData...>{});
+        }
+        template <typename Visitor, std::size_t... Index>
+        static void visit_driver(std::size_t aDriver, Visitor&& aVisitor, std::index_sequence<Index...>)
+        {
+            ((aDriver == Index ? aVisitor(std::integral_constant<std::size_t, Index>{}) : void()), ...);
+        }
+        template <std::size_t Driver, typename Callable>
+        static void visit_range(probes_t const& aProbes, std::size_t aFirst, std::size_t aLast, Callable& aCallable)
+        {
+            auto const& entities = to_const(*std::get<Driver>(aProbes).component).entities();
+            record_indices_t indices;
+            for (std::size_t record = aFirst; record < aLast; ++record)
+            {
+                auto const entity = entities[record];
+                if (entity == null_entity)
+                    continue;
+                if (resolve<Driver>(aProbes, entity, record, indices, std::index_sequence_for<ComponentData...>{}))
+                    invoke(aProbes, entity, indices, aCallable, std::index_sequence_for<ComponentData...>{});
+            }
+        }
+        template <std::size_t Driver, std::size_t... Index>
+        static bool resolve(probes_t const& aProbes, entity_id aEntity, std::size_t aDriverRecord, record_indices_t& aIndices, std::index_sequence<Index...>)
+        {
+            auto probe = [&](auto const& aProbe, std::size_t& aIndex, auto aIsDriver)
+            {
+                if constexpr (decltype(aIsDriver)::value)
+                    aIndex = aDriverRecord;
+                else
+                    aIndex = aEntity < aProbe.reverseIndexCount ? aProbe.reverseIndices[aEntity] : invalid;
+                return aIndex != invalid;
+            };
+            return (probe(std::get<Index>(aProbes), aIndices[Index], std::bool_constant<Index == Driver>{}) && ...);
+        }
+        template <typename Callable, std::size_t... Index>
+        static void invoke(probes_t const& aProbes, entity_id aEntity, record_indices_t const& aIndices, Callable& aCallable, std::index_sequence<Index...>)
+        {
+            aCallable(aEntity, std::get<Index>(aProbes).record(aIndices[Index])...);
+        }
+    private:
+        i_ecs& iEcs;
+        components_t iComponents;
+    };
+}
@@ -36,11 +36,13 @@
 #pragma once
 
 #include <neolib/neolib.hpp>
+#include <atomic>
 #include <stdexcept>
 #include <vector>
 #include <neolib/core/lifetime.hpp>
 #include <neolib/task/i_async_task.hpp>
 #include <neolib/task/event.hpp>
+#include <neolib/task/co_task.hpp>
 #include <neolib/io/i_packet.hpp>
 #include <neolib/io/binary_packet.hpp>
 #include <neolib/io/string_packet.hpp>
@@ -109,6 +111,65 @@ namespace neolib
             iSendQueue.push_back(std::make_unique<packet_type>(aPacket));
             iConnection.send_packet(*iSendQueue.back(), aHighPriority);
         }
+        // co_await co_send_packet(packet): sends a packet and continues, on the awaiting thread, once it has
+        // been sent; a transfer failure or the connection closing first is thrown as
+        // boost::system::system_error. The packet is copied when the awaiter is created.
+        auto co_send_packet(const packet_type& aPacket, bool aHighPriority = false)
+        {
+            class awaiter
+            {
+            public:
+                awaiter(packet_stream& aStream, const packet_type& aPacket, bool aHighPriority) :
+                    iStream{ aStream }, iPacket{ std::make_unique<packet_type>(aPacket) }, iHighPriority{ aHighPriority }
+                {
+                }
+            public:
+                bool await_ready() const noexcept
+                {
+                    return false;
+                }
+                void await_suspend(std::coroutine_handle<> aHandle)
+                {
+                    auto& queue = async_event_queue::instance();
+                    auto const complete = [this, aHandle, &queue](boost::system::error_code const& aError)
+                    {
+                        if (iCompleted.exchange(true, std::memory_order_acq_rel))
+                            return;
+                        iResult.emplace(aError);
+                        queue.post([aHandle]() { aHandle.resume(); });
+                    };
+                    iStream.iSendQueue.push_back(std::move(iPacket));
+                    auto const sending = iStream.iSendQueue.back().get();
+                    iSink += iStream.PacketSent([sending, complete](const packet_type& aSent) 
+                    { 
+                        if (&aSent == sending) 
+                            complete({}); 
+                    });
+                    iSink += iStream.TransferFailure(complete);
+                    iSink += iStream.ConnectionClosed([complete]() { complete(boost::asio::error::connection_aborted); });
+                    iStream.iConnection.send_packet(*sending, iHighPriority);
+                }
+                void await_resume()
+                {
+                    iSink.clear();
+                    if (*iResult)
+                        throw boost::system::system_error{ *iResult };
+                }
+            private:
+                packet_stream& iStream;
+                queue_item iPacket;
+                bool iHighPriority;
+                sink iSink;
+                std::atomic<bool> iCompleted = false;
+                std::optional<boost::system::error_code> iResult;
+            };
+            return awaiter{ *this, aPacket, aHighPriority };
+        }
+        // co_await next_packet(): the next packet to arrive.
+        auto next_packet()
+        {
+            return next_event(packet_arrived());
+        }
         bool connected() const
         {
             return iConnection.connected();
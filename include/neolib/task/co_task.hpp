@@ -0,0 +1,484 @@
+// co_task.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <neolib/task/event.hpp>
+#include <neolib/task/timer.hpp>
+#include <neolib/task/thread_pool.hpp>
+
+namespace neolib
+{
+    template <typename T = void>
+    class co_task;
+
+    namespace detail
+    {
+        class co_task_promise_base
+        {
+        private:
+            struct final_awaiter
+            {
+                bool await_ready() const noexcept
+                {
+                    return false;
+                }
+                template <typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> aHandle) const noexcept
+                {
+                    auto const continuation = aHandle.promise().iContinuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+                void await_resume() const noexcept
+                {
+                }
+            };
+        public:
+            std::suspend_always initial_suspend() const noexcept
+            {
+                return {};
+            }
+            final_awaiter final_suspend() const noexcept
+            {
+                return {};
+            }
+            void unhandled_exception() noexcept
+            {
+                iError = std::current_exception();
+            }
+            void set_continuation(std::coroutine_handle<> aContinuation) noexcept
+            {
+                iContinuation = aContinuation;
+            }
+        protected:
+            void rethrow_if_failed() const
+            {
+                if (iError)
+                    std::rethrow_exception(iError);
+            }
+        private:
+            std::coroutine_handle<> iContinuation;
+            std::exception_ptr iError;
+        };
+
+        template <typename T>
+        class co_task_promise : public co_task_promise_base
+        {
+        public:
+            co_task<T> get_return_object() noexcept;
+            template <typename U>
+            void return_value(U&& aValue)
+            {
+                iValue.emplace(std::forward<U>(aValue));
+            }
+            T result()
+            {
+                rethrow_if_failed();
+                return std::move(*iValue);
+            }
+        private:
+            std::optional<T> iValue;
+        };
+
+        template <>
+        class co_task_promise<void> : public co_task_promise_base
+        {
+        public:
+            co_task<void> get_return_object() noexcept;
+            void return_void() noexcept
+            {
+            }
+            void result()
+            {
+                rethrow_if_failed();
+            }
+        };
+    }
+
+    // Lazily started coroutine producing a T. Awaiting a co_task starts it and resumes the awaiter,
+    // by symmetric transfer, when it completes; an exception escaping the coroutine is rethrown to the
+    // awaiter. Use sync_wait() to run one from ordinary code or co_spawn() to start one detached.
+    template <typename T>
+    class co_task
+    {
+        static_assert(!std::is_reference_v<T>, "neolib::co_task: reference results not supported");
+    public:
+        typedef detail::co_task_promise<T> promise_type;
+        typedef std::coroutine_handle<promise_type> handle_type;
+    private:
+        struct awaiter
+        {
+            handle_type handle;
+
+            bool await_ready() const noexcept
+            {
+                return !handle || handle.done();
+            }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> aAwaiter) noexcept
+            {
+                handle.promise().set_continuation(aAwaiter);
+                return handle;
+            }
+            T await_resume()
+            {
+                return handle.promise().result();
+            }
+        };
+    public:
+        co_task() noexcept = default;
+        explicit co_task(handle_type aHandle) noexcept : 
+            iHandle{ aHandle }
+        {
+        }
+        co_task(co_task&& aOther) noexcept : 
+            iHandle{ std::exchange(aOther.iHandle, nullptr) }
+        {
+        }
+        co_task& operator=(co_task&& aOther) noexcept
+        {
+            if (this != &aOther)
+            {
+                if (iHandle)
+                    iHandle.destroy();
+                iHandle = std::exchange(aOther.iHandle, nullptr);
+            }
+            return *this;
+        }
+        ~co_task()
+        {
+            if (iHandle)
+                iHandle.destroy();
+        }
+    public:
+        bool valid() const noexcept
+        {
+            return static_cast<bool>(iHandle);
+        }
+        bool done() const noexcept
+        {
+            return !iHandle || iHandle.done();
+        }
+        awaiter operator co_await() const noexcept
+        {
+            return awaiter{ iHandle };
+        }
+    private:
+        handle_type iHandle;
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        inline co_task<T> co_task_promise<T>::get_return_object() noexcept
+        {
+            return co_task<T>{ std::coroutine_handle<co_task_promise<T>>::from_promise(*this) };
+        }
+
+        inline co_task<void> co_task_promise<void>::get_return_object() noexcept
+        {
+            return co_task<void>{ std::coroutine_handle<co_task_promise<void>>::from_promise(*this) };
+        }
+
+        // Outermost frame used by sync_wait(): signals an atomic flag when the awaited task completes.
+        class sync_wait_frame
+        {
+        public:
+            struct promise_type
+            {
+                std::atomic<bool> done = false;
+                std::exception_ptr error;
+
+                sync_wait_frame get_return_object() noexcept
+                {
+                    return sync_wait_frame{ std::coroutine_handle<promise_type>::from_promise(*this) };
+                }
+                std::suspend_always initial_suspend() const noexcept
+                {
+                    return {};
+                }
+                auto final_suspend() noexcept
+                {
+                    struct signal
+                    {
+                        bool await_ready() const noexcept
+                        {
+                            return false;
+                        }
+                        void await_suspend(std::coroutine_handle<promise_type> aHandle) const noexcept
+                        {
+                            aHandle.promise().done.store(true, std::memory_order_release);
+                            aHandle.promise().done.notify_all();
+                        }
+                        void await_resume() const noexcept
+                        {
+                        }
+                    };
+                    return signal{};
+                }
+                void unhandled_exception() noexcept
+                {
+                    error = std::current_exception();
+                }
+                void return_void() noexcept
+                {
+                }
+            };
+        public:
+            explicit sync_wait_frame(std::coroutine_handle<promise_type> aHandle) noexcept : 
+                iHandle{ aHandle }
+            {
+            }
+            sync_wait_frame(sync_wait_frame const&) = delete;
+            ~sync_wait_frame()
+            {
+                iHandle.destroy();
+            }
+        public:
+            void run()
+            {
+                iHandle.resume();
+                iHandle.promise().done.wait(false, std::memory_order_acquire);
+                if (iHandle.promise().error)
+                    std::rethrow_exception(iHandle.promise().error);
+            }
+        private:
+            std::coroutine_handle<promise_type> iHandle;
+        };
+
+        // Self-destroying frame used by co_spawn(). There is nobody to rethrow to so, as with an exception
+        // escaping a std::thread, an exception escaping the spawned task terminates the program.
+        struct detached_frame
+        {
+            struct promise_type
+            {
+                detached_frame get_return_object() const noexcept
+                {
+                    return {};
+                }
+                std::suspend_never initial_suspend() const noexcept
+                {
+                    return {};
+                }
+                std::suspend_never final_suspend() const noexcept
+                {
+                    return {};
+                }
+                void unhandled_exception() const noexcept
+                {
+                    std::terminate();
+                }
+                void return_void() const noexcept
+                {
+                }
+            };
+        };
+
+        template <typename T>
+        inline sync_wait_frame make_sync_wait_frame(co_task<T>& aTask, std::optional<T>& aResult)
+        {
+            aResult.emplace(co_await aTask);
+        }
+
+        inline sync_wait_frame make_sync_wait_frame(co_task<void>& aTask)
+        {
+            co_await aTask;
+        }
+
+        template <typename T>
+        inline detached_frame make_detached_frame(co_task<T> aTask)
+        {
+            co_await aTask;
+        }
+    }
+
+    // Blocks the calling thread until aTask completes and returns its result. The calling thread must
+    // not be the one that the task needs in order to make progress (e.g. to pump its events).
+    template <typename T>
+    inline T sync_wait(co_task<T> aTask)
+    {
+        if constexpr (std::is_void_v<T>)
+            detail::make_sync_wait_frame(aTask).run();
+        else
+        {
+            std::optional<T> result;
+            detail::make_sync_wait_frame(aTask, result).run();
+            return std::move(*result);
+        }
+    }
+
+    // Starts aTask running on the calling thread; the frame frees itself when the task completes. An
+    // exception escaping the task calls std::terminate(); catch inside the task to handle errors.
+    template <typename T>
+    inline void co_spawn(co_task<T> aTask)
+    {
+        detail::make_detached_frame(std::move(aTask));
+    }
+
+    // co_await resume_on(pool): continues the coroutine on a worker of aThreadPool, or on the awaiting
+    // thread if the pool has been stopped.
+    inline auto resume_on(thread_pool& aThreadPool)
+    {
+        struct awaiter
+        {
+            thread_pool& pool;
+
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+            bool await_suspend(std::coroutine_handle<> aHandle) const
+            {
+                return pool.run([aHandle]() { aHandle.resume(); }).second != nullptr;
+            }
+            void await_resume() const noexcept
+            {
+            }
+        };
+        return awaiter{ aThreadPool };
+    }
+
+    // co_await resume_on(queue): continues the coroutine on the thread that owns aQueue the next time it
+    // pumps events, e.g. async_event_queue::instance(ownerThreadId) to post back to an owning thread.
+    inline auto resume_on(async_event_queue& aQueue)
+    {
+        struct awaiter
+        {
+            async_event_queue& queue;
+
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<> aHandle) const
+            {
+                queue.post([aHandle]() { aHandle.resume(); });
+            }
+            void await_resume() const noexcept
+            {
+            }
+        };
+        return awaiter{ aQueue };
+    }
+
+    // co_await delay(task, duration): continues the coroutine on aTask's thread once the duration has
+    // elapsed. The timer belongs to aTask so it must be awaited on aTask's thread.
+    inline auto delay(i_async_task& aTask, timer::duration_type const& aDuration_s)
+    {
+        class awaiter
+        {
+        public:
+            awaiter(i_async_task& aTask, timer::duration_type const& aDuration_s) :
+                iTask{ aTask }, iDuration_s{ aDuration_s }
+            {
+            }
+        public:
+            bool await_ready() const noexcept
+            {
+                return iDuration_s <= timer::duration_type::zero();
+            }
+            void await_suspend(std::coroutine_handle<> aHandle)
+            {
+                // Resumed from the event queue rather than the timer callback as the timer lives in the
+                // coroutine frame.
+                iTimer.emplace(iTask, [aHandle](callback_timer&) { async_event_queue::instance().post([aHandle]() { aHandle.resume(); }); }, iDuration_s);
+            }
+            void await_resume() const noexcept
+            {
+            }
+        private:
+            i_async_task& iTask;
+            timer::duration_type iDuration_s;
+            std::optional<callback_timer> iTimer;
+        };
+        return awaiter{ aTask, aDuration_s };
+    }
+
+    // co_await next_event(ev): continues the coroutine with the arguments of the next trigger of aEvent,
+    // on the thread that awaited it (via that thread's event queue). Only the first trigger is taken,
+    // even if several threads trigger the event at once. A single argument is returned as is, several
+    // as a tuple.
+    template <typename... Args>
+    inline auto next_event(i_event<Args...> const& aEvent)
+    {
+        class awaiter
+        {
+        public:
+            typedef std::tuple<std::decay_t<Args>...> result_tuple;
+        public:
+            awaiter(i_event<Args...> const& aEvent) :
+                iEvent{ aEvent }
+            {
+            }
+        public:
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<> aHandle)
+            {
+                auto& queue = async_event_queue::instance();
+                iSink = iEvent([this, aHandle, &queue](Args... aArgs)
+                {
+                    if (iTriggered.exchange(true, std::memory_order_acq_rel))
+                        return;
+                    iResult.emplace(aArgs...);
+                    queue.post([aHandle]() { aHandle.resume(); });
+                });
+            }
+            auto await_resume()
+            {
+                iSink.clear();
+                if constexpr (sizeof...(Args) == 1u)
+                    return std::get<0>(std::move(*iResult));
+                else if constexpr (sizeof...(Args) > 1u)
+                    return std::move(*iResult);
+            }
+        private:
+            i_event<Args...> const& iEvent;
+            sink iSink;
+            std::atomic<bool> iTriggered = false;
+            std::optional<result_tuple> iResult;
+        };
+        return awaiter{ aEvent };
+    }
+}
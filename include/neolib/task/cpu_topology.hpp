@@ -0,0 +1,87 @@
+// cpu_topology.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace neolib
+{
+    struct logical_cpu
+    {
+        std::uint32_t id;       // operating system processor number
+        std::uint32_t core;     // dense physical core index; SMT siblings share it
+        std::uint32_t node;     // NUMA node
+        std::uint32_t sibling;  // position among the core's SMT siblings
+    };
+
+    // Logical processors grouped into physical cores and NUMA nodes. On Linux the layout is read from
+    // sysfs; elsewhere (or if sysfs is unavailable) every logical processor is treated as its own core
+    // on node 0.
+    class NEOLIB_EXPORT cpu_topology
+    {
+    public:
+        struct no_cpus : std::logic_error { no_cpus() : std::logic_error("neolib::cpu_topology::no_cpus") {} };
+    public:
+        explicit cpu_topology(std::vector<logical_cpu> aCpus);
+    public:
+        static cpu_topology const& system();
+        static cpu_topology discover();
+        static std::vector<std::uint32_t> parse_cpu_list(std::string_view aList);
+    public:
+        std::vector<logical_cpu> const& cpus() const;
+        std::size_t core_count() const;
+        std::size_t node_count() const;
+        // Logical processors in the order workers should be placed: one per core, alternating between
+        // nodes, before any SMT siblings.
+        std::vector<logical_cpu> placement() const;
+        // The entries of aPlacement other than aFrom, nearest first: SMT siblings, then the same node,
+        // then the rest. aTierEnds receives the end offsets of the first two groups.
+        static void proximity_order(std::span<logical_cpu const> aPlacement, std::size_t aFrom, 
+            std::vector<std::uint32_t>& aOrder, std::array<std::size_t, 2>& aTierEnds);
+        // Restricts the calling thread to one logical processor.
+        static bool pin_this_thread(logical_cpu const& aCpu);
+    private:
+        std::vector<logical_cpu> iCpus;
+        std::size_t iCoreCount;
+        std::size_t iNodeCount;
+    };
+}
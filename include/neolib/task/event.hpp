@@ -108,6 +108,12 @@ namespace neolib
             else
                 iQueue.multiple.emplace_back(&event, event, &aSlot, aSlot, callback);
         }
+        // Queues a callback to be called by this queue's thread when it next pumps events.
+        void post(std::function<void()> aCallback)
+        {
+            std::scoped_lock lock{ iMutex };
+            iQueue.multiple.emplace_back(this, *this, this, *this, std::move(aCallback));
+        }
     public:
         void register_with_task(i_async_task& aTask) final;
         bool pump_events() final;
@@ -0,0 +1,224 @@
+// parallel_algorithm.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <vector>
+#include <neolib/task/thread_pool.hpp>
+
+namespace neolib
+{
+    // Data-parallel algorithms built on parallel_chunks(): the calling thread takes part in the work and
+    // only waits for chunks already claimed by running workers, so they may be nested inside tasks of the
+    // same pool. Inputs smaller than aMinimumParallelismCount are processed serially on the calling
+    // thread; a zero grain size picks one from the pool's thread count. Reductions and scans combine
+    // per-chunk results in chunk order so that results do not depend on scheduling.
+
+    constexpr std::size_t default_parallel_threshold = 4096u;
+
+    namespace detail
+    {
+        inline std::size_t parallel_grain(thread_pool& aThreadPool, std::size_t aCount, std::size_t aGrainSize)
+        {
+            if (aGrainSize != 0u)
+                return aGrainSize;
+            return std::max<std::size_t>(aCount / (std::max<std::size_t>(aThreadPool.max_threads(), 1u) * 4u), 1u);
+        }
+
+        inline bool run_serially(thread_pool& aThreadPool, std::size_t aCount, std::size_t aMinimumParallelismCount)
+        {
+            return aCount < aMinimumParallelismCount || aThreadPool.stopped() || aThreadPool.max_threads() <= 1u;
+        }
+    }
+
+    // Calls aFunction(index) for each index in [aFirst, aLast).
+    template <typename Index, typename Function>
+    inline void parallel_for(thread_pool& aThreadPool, Index aFirst, Index aLast, Function&& aFunction, 
+        std::size_t aGrainSize = 0u, std::size_t aMinimumParallelismCount = default_parallel_threshold)
+    {
+        if (aLast <= aFirst)
+            return;
+        auto const count = static_cast<std::size_t>(aLast - aFirst);
+        if (detail::run_serially(aThreadPool, count, aMinimumParallelismCount))
+        {
+            for (auto index = aFirst; index != aLast; ++index)
+                aFunction(index);
+            return;
+        }
+        parallel_chunks(aThreadPool, count, detail::parallel_grain(aThreadPool, count, aGrainSize), [&](std::size_t aChunkFirst, std::size_t aChunkLast)
+        {
+            for (auto index = aFirst + static_cast<Index>(aChunkFirst), end = aFirst + static_cast<Index>(aChunkLast); index != end; ++index)
+                aFunction(index);
+        });
+    }
+
+    // Reduces aTransform(*i) over [aFirst, aLast) with aReduce starting from aInit; aReduce must be
+    // associative.
+    template <std::random_access_iterator Iter, typename T, typename Reduce, typename Transform>
+    inline T parallel_transform_reduce(thread_pool& aThreadPool, Iter aFirst, Iter aLast, T aInit, Reduce aReduce, Transform aTransform,
+        std::size_t aGrainSize = 0u, std::size_t aMinimumParallelismCount = default_parallel_threshold)
+    {
+        auto const count = static_cast<std::size_t>(std::distance(aFirst, aLast));
+        if (detail::run_serially(aThreadPool, count, aMinimumParallelismCount))
+        {
+            for (; aFirst != aLast; ++aFirst)
+                aInit = aReduce(std::move(aInit), aTransform(*aFirst));
+            return aInit;
+        }
+        auto const grain = detail::parallel_grain(aThreadPool, count, aGrainSize);
+        std::vector<std::optional<T>> partials((count + grain - 1u) / grain);
+        parallel_chunks(aThreadPool, count, grain, [&](std::size_t aChunkFirst, std::size_t aChunkLast)
+        {
+            auto i = std::next(aFirst, aChunkFirst);
+            T partial = aTransform(*i);
+            for (++i; i != std::next(aFirst, aChunkLast); ++i)
+                partial = aReduce(std::move(partial), aTransform(*i));
+            partials[aChunkFirst / grain].emplace(std::move(partial));
+        });
+        for (auto& partial : partials)
+            aInit = aReduce(std::move(aInit), std::move(*partial));
+        return aInit;
+    }
+
+    template <std::random_access_iterator Iter, typename T, typename Reduce = std::plus<>>
+    inline T parallel_reduce(thread_pool& aThreadPool, Iter aFirst, Iter aLast, T aInit, Reduce aReduce = {},
+        std::size_t aGrainSize = 0u, std::size_t aMinimumParallelismCount = default_parallel_threshold)
+    {
+        return parallel_transform_reduce(aThreadPool, aFirst, aLast, std::move(aInit), aReduce, 
+            [](auto const& aValue) -> auto const& { return aValue; }, aGrainSize, aMinimumParallelismCount);
+    }
+
+    // Writes the inclusive prefix combination of [aFirst, aLast) under aOp to aResult; the ranges may be the
+    // same. Each chunk is scanned twice: once for its total and once, offset by the preceding totals, for
+    // its output.
+    template <std::random_access_iterator Iter, std::random_access_iterator OutIter, typename Op = std::plus<>>
+    inline OutIter parallel_inclusive_scan(thread_pool& aThreadPool, Iter aFirst, Iter aLast, OutIter aResult, Op aOp = {},
+        std::size_t aGrainSize = 0u, std::size_t aMinimumParallelismCount = default_parallel_threshold)
+    {
+        typedef typename std::iterator_traits<Iter>::value_type value_type;
+        auto const count = static_cast<std::size_t>(std::distance(aFirst, aLast));
+        if (detail::run_serially(aThreadPool, count, aMinimumParallelismCount))
+            return std::inclusive_scan(aFirst, aLast, aResult, aOp);
+        auto const grain = detail::parallel_grain(aThreadPool, count, aGrainSize);
+        std::vector<std::optional<value_type>> totals((count + grain - 1u) / grain);
+        parallel_chunks(aThreadPool, count, grain, [&](std::size_t aChunkFirst, std::size_t aChunkLast)
+        {
+            value_type total = *std::next(aFirst, aChunkFirst);
+            for (auto i = std::next(aFirst, aChunkFirst + 1u); i != std::next(aFirst, aChunkLast); ++i)
+                total = aOp(std::move(total), *i);
+            totals[aChunkFirst / grain].emplace(std::move(total));
+        });
+        for (std::size_t chunk = 1u; chunk < totals.size(); ++chunk)
+            totals[chunk].emplace(aOp(*totals[chunk - 1u], *totals[chunk]));
+        parallel_chunks(aThreadPool, count, grain, [&](std::size_t aChunkFirst, std::size_t aChunkLast)
+        {
+            auto const chunk = aChunkFirst / grain;
+            auto out = std::next(aResult, aChunkFirst);
+            if (chunk == 0u)
+                std::inclusive_scan(std::next(aFirst, aChunkFirst), std::next(aFirst, aChunkLast), out, aOp);
+            else
+                std::inclusive_scan(std::next(aFirst, aChunkFirst), std::next(aFirst, aChunkLast), out, aOp, *totals[chunk - 1u]);
+        });
+        return std::next(aResult, count);
+    }
+
+    // As parallel_inclusive_scan() but each output excludes its own element and starts from aInit.
+    template <std::random_access_iterator Iter, std::random_access_iterator OutIter, typename T, typename Op = std::plus<>>
+    inline OutIter parallel_exclusive_scan(thread_pool& aThreadPool, Iter aFirst, Iter aLast, OutIter aResult, T aInit, Op aOp = {},
+        std::size_t aGrainSize = 0u, std::size_t aMinimumParallelismCount = default_parallel_threshold)
+    {
+        auto const count = static_cast<std::size_t>(std::distance(aFirst, aLast));
+        if (detail::run_serially(aThreadPool, count, aMinimumParallelismCount))
+            return std::exclusive_scan(aFirst, aLast, aResult, std::move(aInit), aOp);
+        auto const grain = detail::parallel_grain(aThreadPool, count, aGrainSize);
+        std::vector<std::optional<T>> totals((count + grain - 1u) / grain);
+        parallel_chunks(aThreadPool, count, grain, [&](std::size_t aChunkFirst, std::size_t aChunkLast)
+        {
+            T total = *std::next(aFirst, aChunkFirst);
+            for (auto i = std::next(aFirst, aChunkFirst + 1u); i != std::next(aFirst, aChunkLast); ++i)
+                total = aOp(std::move(total), *i);
+            totals[aChunkFirst / grain].emplace(std::move(total));
+        });
+        std::optional<T> offset = std::move(aInit);
+        for (auto& total : totals)
+        {
+            T next = aOp(*offset, *total);
+            total.emplace(*offset);
+            offset.emplace(std::move(next));
+        }
+        parallel_chunks(aThreadPool, count, grain, [&](std::size_t aChunkFirst, std::size_t aChunkLast)
+        {
+            std::exclusive_scan(std::next(aFirst, aChunkFirst), std::next(aFirst, aChunkLast), std::next(aResult, aChunkFirst), *totals[aChunkFirst / grain], aOp);
+        });
+        return std::next(aResult, count);
+    }
+
+    // Sorts chunks in parallel and then merges neighbouring runs pairwise, each round in parallel. Not
+    // stable.
+    template <std::random_access_iterator Iter, typename Compare = std::less<>>
+    inline void parallel_sort(thread_pool& aThreadPool, Iter aFirst, Iter aLast, Compare aCompare = {},
+        std::size_t aGrainSize = 0u, std::size_t aMinimumParallelismCount = default_parallel_threshold)
+    {
+        auto const count = static_cast<std::size_t>(std::distance(aFirst, aLast));
+        if (detail::run_serially(aThreadPool, count, aMinimumParallelismCount))
+        {
+            std::sort(aFirst, aLast, aCompare);
+            return;
+        }
+        auto const grain = std::max<std::size_t>(detail::parallel_grain(aThreadPool, count, aGrainSize), aMinimumParallelismCount / 4u);
+        parallel_chunks(aThreadPool, count, grain, [&](std::size_t aChunkFirst, std::size_t aChunkLast)
+        {
+            std::sort(std::next(aFirst, aChunkFirst), std::next(aFirst, aChunkLast), aCompare);
+        });
+        for (auto run = grain; run < count; run *= 2u)
+        {
+            auto const pairs = (count + 2u * run - 1u) / (2u * run);
+            parallel_chunks(aThreadPool, pairs, 1u, [&](std::size_t aPair, std::size_t)
+            {
+                auto const first = aPair * 2u * run;
+                auto const middle = std::min(count, first + run);
+                auto const last = std::min(count, first + 2u * run);
+                if (middle < last)
+                    std::inplace_merge(std::next(aFirst, first), std::next(aFirst, middle), std::next(aFirst, last), aCompare);
+            });
+        }
+    }
+}
@@ -0,0 +1,186 @@
+// task_group.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <neolib/task/task.hpp>
+#include <neolib/task/thread_pool.hpp>
+
+namespace neolib
+{
+    // A set of tasks run on a thread pool that can be waited for, and cancelled, independently of any
+    // other work in the pool. wait() executes queued pool tasks on the calling thread while members are
+    // outstanding and then rethrows the first exception thrown by a member; an exception also cancels
+    // the members that have not started yet. The destructor waits but discards any exception.
+    class task_group
+    {
+    private:
+        // Shared with the members so that a member finishing after wait() has returned, and the group
+        // has been destroyed, still has somewhere to signal.
+        struct state
+        {
+            std::atomic<std::size_t> pending = 0u;
+            std::atomic<bool> waiting = false;
+            std::atomic<bool> cancelled = false;
+            std::mutex errorMutex;
+            std::exception_ptr error;
+
+            void failed(std::exception_ptr aError)
+            {
+                {
+                    std::scoped_lock lock{ errorMutex };
+                    if (!error)
+                        error = aError;
+                }
+                cancelled.store(true, std::memory_order_release);
+            }
+            void completed()
+            {
+                if (pending.fetch_sub(1u, std::memory_order_acq_rel) == 1u || waiting.load(std::memory_order_acquire))
+                    pending.notify_all();
+            }
+        };
+        template <typename Callable>
+        class member : public task<>
+        {
+        public:
+            member(std::shared_ptr<state> aState, Callable&& aCallable) :
+                iState{ std::move(aState) }, iCallable{ std::forward<Callable>(aCallable) }
+            {
+            }
+        public:
+            const std::string& name() const override
+            {
+                static std::string const sName = "neolib::task_group::member";
+                return sName;
+            }
+            void run(yield_type) override
+            {
+                if (!iState->cancelled.load(std::memory_order_acquire))
+                {
+                    try
+                    {
+                        iCallable();
+                    }
+                    catch (...)
+                    {
+                        iState->failed(std::current_exception());
+                    }
+                }
+                iState->completed();
+            }
+        private:
+            std::shared_ptr<state> iState;
+            std::decay_t<Callable> iCallable;
+        };
+    public:
+        task_group(thread_pool& aThreadPool = thread_pool::default_thread_pool()) :
+            iThreadPool{ aThreadPool }, iState{ std::make_shared<state>() }
+        {
+        }
+        ~task_group()
+        {
+            try
+            {
+                wait();
+            }
+            catch (...)
+            {
+            }
+        }
+        task_group(task_group const&) = delete;
+        task_group& operator=(task_group const&) = delete;
+    public:
+        thread_pool& pool() const
+        {
+            return iThreadPool;
+        }
+        std::size_t pending() const
+        {
+            return iState->pending.load(std::memory_order_acquire);
+        }
+        bool cancelled() const
+        {
+            return iState->cancelled.load(std::memory_order_acquire);
+        }
+    public:
+        template <typename Callable>
+        void run(Callable&& aCallable, int32_t aPriority = 0)
+        {
+            iState->pending.fetch_add(1u, std::memory_order_acq_rel);
+            auto newMember = std::make_shared<member<Callable>>(iState, std::forward<Callable>(aCallable));
+            if (!iThreadPool.start(newMember, aPriority))
+            {
+                // The pool is (or has just been) stopped: run the member here so that pending still drops.
+                newMember->run(yield_type::NoYield);
+                return;
+            }
+            if (iState->waiting.load(std::memory_order_acquire))
+                iState->pending.notify_all();
+        }
+        // Members that have not started yet are skipped; running members are not interrupted.
+        void cancel()
+        {
+            iState->cancelled.store(true, std::memory_order_release);
+        }
+        void wait()
+        {
+            auto& s = *iState;
+            s.waiting.store(true, std::memory_order_release);
+            for (auto pending = s.pending.load(std::memory_order_acquire); pending != 0u; pending = s.pending.load(std::memory_order_acquire))
+                if (!iThreadPool.help())
+                    s.pending.wait(pending, std::memory_order_acquire);
+            s.waiting.store(false, std::memory_order_release);
+            s.cancelled.store(false, std::memory_order_release);
+            std::exception_ptr error;
+            {
+                std::scoped_lock lock{ s.errorMutex };
+                error = std::exchange(s.error, nullptr);
+            }
+            if (error)
+                std::rethrow_exception(error);
+        }
+    private:
+        thread_pool& iThreadPool;
+        std::shared_ptr<state> iState;
+    };
+}
@@ -36,19 +36,150 @@
 #pragma once
 
 #include <neolib/neolib.hpp>
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <exception>
+#include <latch>
 #include <memory>
+#include <ranges>
+#include <type_traits>
 #include <vector>
 #include <deque>
 #include <future>
 #include <mutex>
+#include <condition_variable>
 #include <neolib/task/i_thread.hpp>
+#include <neolib/task/cpu_topology.hpp>
 #include <neolib/task/task.hpp>
 
 namespace neolib
 {
     class thread_pool_thread;
 
+    namespace detail
+    {
+        // Queue entry for a started task; pooled entries are embedded in the object that owns the task
+        // rather than allocated per start.
+        struct pool_task_node
+        {
+            std::shared_ptr<i_task> task;
+            pool_task_node* next = nullptr;
+            bool pooled = false;
+        };
+
+        // Shared state of a bulk submission: the index space [0, count) is claimed grain by grain by
+        // however many participant tasks (and the waiting thread) get to run.
+        class bulk_job
+        {
+        public:
+            class participant : public task<>
+            {
+            public:
+                participant(bulk_job& aJob) : iJob{ aJob }
+                {
+                }
+            public:
+                const std::string& name() const override
+                {
+                    static std::string const sName = "neolib::bulk_job::participant";
+                    return sName;
+                }
+                void run(yield_type) override
+                {
+                    iJob.participate();
+                }
+            private:
+                bulk_job& iJob;
+            };
+        public:
+            bulk_job(std::size_t aCount, std::size_t aGrainSize) :
+                iCount{ aCount }, iGrainSize{ std::max<std::size_t>(aGrainSize, 1u) }, iNext{ 0u }, iRemaining{ aCount }, iDone{ aCount == 0u }
+            {
+            }
+            virtual ~bulk_job() = default;
+        public:
+            std::size_t count() const
+            {
+                return iCount;
+            }
+            bool done() const
+            {
+                return iDone.load(std::memory_order_acquire);
+            }
+            void participate()
+            {
+                for (auto first = iNext.fetch_add(iGrainSize, std::memory_order_relaxed); first < iCount; first = iNext.fetch_add(iGrainSize, std::memory_order_relaxed))
+                {
+                    auto const last = std::min(iCount, first + iGrainSize);
+                    try
+                    {
+                        if (!iFailed.load(std::memory_order_relaxed))
+                            invoke(first, last);
+                    }
+                    catch (...)
+                    {
+                        std::scoped_lock lock{ iErrorMutex };
+                        if (!iError)
+                            iError = std::current_exception();
+                        iFailed.store(true, std::memory_order_relaxed);
+                    }
+                    if (iRemaining.fetch_sub(last - first, std::memory_order_acq_rel) == last - first)
+                    {
+                        iDone.store(true, std::memory_order_release);
+                        iDone.notify_all();
+                    }
+                }
+            }
+            void wait()
+            {
+                participate();
+                iDone.wait(false, std::memory_order_acquire);
+                if (iError)
+                    std::rethrow_exception(iError);
+            }
+        public:
+            std::deque<participant> participants;
+            std::vector<pool_task_node> nodes;
+        private:
+            virtual void invoke(std::size_t aFirst, std::size_t aLast) = 0;
+        private:
+            std::size_t const iCount;
+            std::size_t const iGrainSize;
+            alignas(64) std::atomic<std::size_t> iNext;
+            alignas(64) std::atomic<std::size_t> iRemaining;
+            std::atomic<bool> iDone;
+            std::atomic<bool> iFailed = false;
+            std::mutex iErrorMutex;
+            std::exception_ptr iError;
+        };
+
+        template <typename Callable>
+        class bulk_job_impl final : public bulk_job
+        {
+        public:
+            bulk_job_impl(std::size_t aCount, std::size_t aGrainSize, Callable&& aCallable) :
+                bulk_job{ aCount, aGrainSize }, iCallable{ std::forward<Callable>(aCallable) }
+            {
+            }
+        private:
+            void invoke(std::size_t aFirst, std::size_t aLast) final
+            {
+                for (auto index = aFirst; index < aLast; ++index)
+                    iCallable(index);
+            }
+        private:
+            std::decay_t<Callable> iCallable;
+        };
+    }
+
+    // Work-stealing thread pool. Each worker owns a lock-free deque: tasks started from a worker are
+    // pushed onto its own deque (LIFO) and idle workers steal from the opposite end of a randomly chosen
+    // victim (FIFO). Tasks started from other threads go to a lock-free inbox of a worker chosen round
+    // robin; inboxes can be stolen as a whole. Tasks with a non-zero priority are kept in a small ordered
+    // queue: positive priorities run before deque work and negative ones only when there is none.
+    // Workers are placed on the logical processors of a cpu_topology (optionally pinned to them) and
+    // idle workers steal from SMT siblings first, then from workers on the same NUMA node.
     class NEOLIB_EXPORT thread_pool
     {
         friend class thread_pool_thread;
@@ -59,8 +190,58 @@ namespace neolib
         struct task_not_found : std::logic_error { task_not_found() : std::logic_error("neolib::thread_pool::task_not_found") {} };
     private:
         typedef std::vector<std::unique_ptr<i_thread>> thread_list;
+        struct worker_table
+        {
+            std::vector<thread_pool_thread*> workers;
+            std::vector<std::vector<std::uint32_t>> victims;
+            std::vector<std::array<std::size_t, 2>> victimTiers;
+            std::vector<std::vector<std::uint32_t>> nodeWorkers;
+        };
+        struct prioritised_task
+        {
+            task_pointer task;
+            int32_t priority;
+            std::uint64_t sequence;
+        };
+    public:
+        // Preferred placement of a started task: a logical processor (cpu_topology id) or a NUMA node.
+        // The task is queued on a matching worker, from which it can still be stolen.
+        struct locality
+        {
+            static constexpr std::uint32_t any = ~0u;
+            std::uint32_t node = any;
+            std::uint32_t cpu = any;
+        };
+    public:
+        // Completion handle for a bulk submission; wait() lends the calling thread to the remaining work
+        // and rethrows the first exception thrown by a work item.
+        class bulk_handle
+        {
+        public:
+            bulk_handle() = default;
+            bulk_handle(std::shared_ptr<detail::bulk_job> aJob) : iJob{ std::move(aJob) }
+            {
+            }
+        public:
+            bool valid() const
+            {
+                return iJob != nullptr;
+            }
+            bool done() const
+            {
+                return !valid() || iJob->done();
+            }
+            void wait() const
+            {
+                if (valid())
+                    iJob->wait();
+            }
+        private:
+            std::shared_ptr<detail::bulk_job> iJob;
+        };
     public:
         thread_pool();
+        explicit thread_pool(cpu_topology const& aTopology, bool aPinWorkers = false);
         ~thread_pool();
     public:
         void reserve(std::size_t aMaxThreads);
@@ -68,14 +249,29 @@ namespace neolib
         std::size_t available_threads() const;
         std::size_t total_threads() const;
         std::size_t max_threads() const;
+        cpu_topology const& topology() const;
+        bool pinned() const;
+        logical_cpu const& placement(std::size_t aWorker) const;
     public:
-        void start(i_task& aTask, int32_t aPriority = 0);
-        void start(task_pointer aTask, int32_t aPriority = 0);
+        // Returns false, without queuing the task, if the pool has been stopped.
+        bool start(i_task& aTask, int32_t aPriority = 0);
+        bool start(task_pointer aTask, int32_t aPriority = 0);
+        bool start(i_task& aTask, locality const& aLocality, int32_t aPriority = 0);
+        bool start(task_pointer aTask, locality const& aLocality, int32_t aPriority = 0);
         bool try_start(i_task& aTask, int32_t aPriority = 0);
         bool try_start(task_pointer aTask, int32_t aPriority = 0);
         std::pair<std::future<void>, task_pointer> run(std::function<void()> aFunction, int32_t aPriority = 0);
+        std::pair<std::future<void>, task_pointer> run(std::function<void()> aFunction, locality const& aLocality, int32_t aPriority = 0);
         template <typename T>
         std::pair<std::future<T>, task_pointer> run(std::function<T()> aFunction, int32_t aPriority = 0);
+        template <typename T>
+        std::pair<std::future<T>, task_pointer> run(std::function<T()> aFunction, locality const& aLocality, int32_t aPriority = 0);
+        // Calls aCallable(index) for every index in [0, aCount); the callable is stored once, inline, and
+        // all participant tasks are enqueued together. A zero grain size picks one from the thread count.
+        template <typename Callable>
+        bulk_handle run_bulk(std::size_t aCount, Callable&& aCallable, std::size_t aGrainSize = 0u, int32_t aPriority = 0);
+        template <std::ranges::random_access_range Range, typename Callable>
+        bulk_handle run_bulk(Range& aItems, Callable&& aCallable, std::size_t aGrainSize = 0u, int32_t aPriority = 0);
     public:
         bool idle() const;
         void update_idle();
@@ -83,35 +279,208 @@ namespace neolib
         void wait() const;
         bool stopped() const;
         void stop();
+        // Runs one queued task on the calling thread; returns false if none could be found.
+        bool help();
     public:
         static thread_pool& default_thread_pool();
         std::recursive_mutex& mutex() const;
     private:
-        void steal_work(thread_pool_thread& aIdleThread);
-        void thread_gone_idle();
-        void thread_gone_busy();
+        void start_bulk(detail::bulk_job& aJob, std::shared_ptr<detail::bulk_job> const& aOwner, std::size_t aParticipants, int32_t aPriority);
+        worker_table const& workers() const;
+        thread_pool_thread* current_worker() const;
+        thread_pool_thread& local_worker(worker_table const& aTable, locality const& aLocality);
+        bool take_prioritised(task_pointer& aTask, bool aUrgentOnly);
+        bool steal_work(thread_pool_thread& aThief, task_pointer& aTask);
+        void execute(task_pointer& aTask, yield_type aYieldType, std::atomic<bool>* aActive);
+        void work_added(std::size_t aCount = 1u);
+        void task_completed();
+        void wait_for_work(thread_pool_thread& aIdleThread);
     private:
         mutable std::recursive_mutex iMutex;
-        std::atomic<bool> iIdle;
+        cpu_topology const iTopology;
+        std::vector<logical_cpu> const iPlacement;
+        bool const iPinWorkers;
         std::atomic<bool> iStopped;
         std::size_t iMaxThreads;
         thread_list iThreads;
+        std::atomic<worker_table const*> iWorkers;
+        std::vector<std::unique_ptr<worker_table const>> iWorkerTables;
+        std::atomic<std::size_t> iNextWorker;
+        std::atomic<std::size_t> iPending;
+        std::atomic<std::uint32_t> iWorkSignal;
+        std::atomic<std::size_t> iSleepers;
+        std::mutex iPrioritisedMutex;
+        std::vector<prioritised_task> iPrioritised;
+        std::atomic<std::size_t> iPrioritisedCount;
+        std::uint64_t iPrioritisedSequence;
         mutable std::mutex iWaitMutex;
         mutable std::condition_variable iWaitConditionVariable;
     };
 
     template <typename T>
     inline std::pair<std::future<T>, thread_pool::task_pointer> thread_pool::run(std::function<T()> aFunction, int32_t aPriority)
+    {
+        return run(std::move(aFunction), locality{}, aPriority);
+    }
+
+    template <typename T>
+    inline std::pair<std::future<T>, thread_pool::task_pointer> thread_pool::run(std::function<T()> aFunction, locality const& aLocality, int32_t aPriority)
     {
         if (stopped())
             return {};
         auto newTask = std::make_shared<function_task<T>>(aFunction);
-        start(newTask, aPriority);
+        if (!start(newTask, aLocality, aPriority))
+            return {};
         return std::make_pair(newTask->get_future(), newTask);
     }
 
-    template <typename Container>
-    inline void parallel_apply(thread_pool& aThreadPool, Container& aContainer, std::function<void(typename Container::value_type& aElement)> aFunction, std::size_t aMinimumParallelismCount = 0)
+    template <typename Callable>
+    inline thread_pool::bulk_handle thread_pool::run_bulk(std::size_t aCount, Callable&& aCallable, std::size_t aGrainSize, int32_t aPriority)
+    {
+        auto const threads = std::max<std::size_t>(max_threads(), 1u);
+        auto const grain = aGrainSize != 0u ? aGrainSize : std::max<std::size_t>(aCount / (threads * 4u), 1u);
+        auto const participants = std::min(threads, (aCount + grain - 1u) / grain);
+        auto job = std::make_shared<detail::bulk_job_impl<Callable>>(aCount, grain, std::forward<Callable>(aCallable));
+        if (stopped() || participants <= 1u)
+            job->participate();
+        else
+            start_bulk(*job, job, participants, aPriority);
+        return bulk_handle{ std::move(job) };
+    }
+
+    template <std::ranges::random_access_range Range, typename Callable>
+    inline thread_pool::bulk_handle thread_pool::run_bulk(Range& aItems, Callable&& aCallable, std::size_t aGrainSize, int32_t aPriority)
+    {
+        return run_bulk(static_cast<std::size_t>(std::ranges::size(aItems)), [first = std::ranges::begin(aItems), callable = std::forward<Callable>(aCallable)](std::size_t aIndex) mutable
+        {
+            callable(first[aIndex]);
+        }, aGrainSize, aPriority);
+    }
+
+    namespace detail
+    {
+        // Per-call state for parallel_chunks(). Each participant owns a contiguous range of chunks packed
+        // into one word (first chunk in the low half, end chunk in the high half); owners take chunks from
+        // the front and idle participants steal the back half of another participant's range.
+        struct parallel_chunks_state
+        {
+            parallel_chunks_state(std::size_t aParticipants, std::size_t aChunks) :
+                ranges( aParticipants ), nextParticipant{ 1u }, remaining{ static_cast<std::ptrdiff_t>(aChunks) }
+            {
+                for (std::size_t participant = 0u; participant < aParticipants; ++participant)
+                    ranges[participant].store(pack(aChunks * participant / aParticipants, aChunks * (participant + 1u) / aParticipants), std::memory_order_relaxed);
+            }
+            static std::uint64_t pack(std::size_t aFirst, std::size_t aLast)
+            {
+                return (static_cast<std::uint64_t>(aLast) << 32u) | static_cast<std::uint32_t>(aFirst);
+            }
+            static std::size_t first(std::uint64_t aRange)
+            {
+                return static_cast<std::size_t>(aRange & 0xFFFFFFFFu);
+            }
+            static std::size_t last(std::uint64_t aRange)
+            {
+                return static_cast<std::size_t>(aRange >> 32u);
+            }
+            bool pop(std::size_t aParticipant, std::size_t& aChunk)
+            {
+                auto& range = ranges[aParticipant];
+                auto current = range.load(std::memory_order_acquire);
+                while (first(current) < last(current))
+                    if (range.compare_exchange_weak(current, pack(first(current) + 1u, last(current)), std::memory_order_acq_rel, std::memory_order_acquire))
+                    {
+                        aChunk = first(current);
+                        return true;
+                    }
+                return false;
+            }
+            bool steal(std::size_t aThief)
+            {
+                for (std::size_t offset = 1u; offset < ranges.size(); ++offset)
+                {
+                    auto& victim = ranges[(aThief + offset) % ranges.size()];
+                    auto current = victim.load(std::memory_order_acquire);
+                    while (first(current) < last(current))
+                    {
+                        auto const split = last(current) - (last(current) - first(current) + 1u) / 2u;
+                        if (victim.compare_exchange_weak(current, pack(first(current), split), std::memory_order_acq_rel, std::memory_order_acquire))
+                        {
+                            ranges[aThief].store(pack(split, last(current)), std::memory_order_release);
+                            return true;
+                        }
+                    }
+                }
+                return false;
+            }
+            template <typename Callable>
+            void participate(std::size_t aParticipant, std::size_t aCount, std::size_t aGrainSize, Callable& aCallable)
+            {
+                std::ptrdiff_t completed = 0;
+                do
+                {
+                    std::size_t chunk;
+                    while (pop(aParticipant, chunk))
+                    {
+                        try
+                        {
+                            if (!failed.load(std::memory_order_relaxed))
+                                aCallable(chunk * aGrainSize, std::min(aCount, (chunk + 1u) * aGrainSize));
+                        }
+                        catch (...)
+                        {
+                            std::scoped_lock lock{ errorMutex };
+                            if (!error)
+                                error = std::current_exception();
+                            failed.store(true, std::memory_order_relaxed);
+                        }
+                        ++completed;
+                    }
+                } while (steal(aParticipant));
+                if (completed != 0)
+                    remaining.count_down(completed);
+            }
+            std::vector<std::atomic<std::uint64_t>> ranges;
+            std::atomic<std::size_t> nextParticipant;
+            std::latch remaining;
+            std::atomic<bool> failed = false;
+            std::mutex errorMutex;
+            std::exception_ptr error;
+        };
+    }
+
+    // Calls aCallable(first, last) for consecutive ranges of aGrainSize indices covering [0, aCount). Chunk
+    // boundaries depend only on aCount and aGrainSize, so per-chunk results are reproducible regardless of
+    // which thread runs a chunk. The calling thread participates and waits only for this call's chunks;
+    // helper tasks that start late find no work and never touch aCallable. The first exception thrown by
+    // aCallable is rethrown once all chunks have been accounted for.
+    template <typename Callable>
+    inline void parallel_chunks(thread_pool& aThreadPool, std::size_t aCount, std::size_t aGrainSize, Callable&& aCallable)
+    {
+        auto const grain = std::max<std::size_t>(aGrainSize, 1u);
+        auto const chunks = (aCount + grain - 1u) / grain;
+        auto const participants = aThreadPool.stopped() ? std::size_t{ 1u } : std::clamp<std::size_t>(aThreadPool.max_threads(), 1u, std::max<std::size_t>(chunks, 1u));
+        if (participants <= 1u || chunks > 0xFFFFFFFFu)
+        {
+            for (std::size_t chunk = 0u; chunk < chunks; ++chunk)
+                aCallable(chunk * grain, std::min(aCount, (chunk + 1u) * grain));
+            return;
+        }
+        auto state = std::make_shared<detail::parallel_chunks_state>(participants, chunks);
+        for (std::size_t helper = 1u; helper < participants; ++helper)
+            aThreadPool.run([state, aCount, grain, &aCallable]()
+            {
+                auto const participant = state->nextParticipant++;
+                if (participant < state->ranges.size())
+                    state->participate(participant, aCount, grain, aCallable);
+            });
+        state->participate(0u, aCount, grain, aCallable);
+        state->remaining.wait();
+        if (state->error)
+            std::rethrow_exception(state->error);
+    }
+
+    template <typename Container, typename Function>
+    inline void parallel_apply(thread_pool& aThreadPool, Container& aContainer, Function&& aFunction, std::size_t aMinimumParallelismCount = 0)
     {
         if (aThreadPool.stopped())
             return;
@@ -121,26 +490,11 @@ namespace neolib
                 aFunction(e);
             return;
         }
-        auto subrange = aContainer.size() / aThreadPool.max_threads();
-        if (subrange < 1)
-            subrange = 1;
-        auto next = aContainer.begin();
-        for (auto left = aContainer.size(); left >= subrange; left -= subrange)
+        auto const grain = std::max<std::size_t>(aContainer.size() / std::max<std::size_t>(aThreadPool.max_threads(), 1u), 1u);
+        parallel_chunks(aThreadPool, aContainer.size(), grain, [&](std::size_t aFirst, std::size_t aLast)
         {
-            auto end = std::next(next, subrange);
-            aThreadPool.run([next, end, &aFunction]()
-            {
-                for (auto i = next; i != end; ++i)
-                    aFunction(*i);
-            });
-            next = end;
-        }
-        if (next != aContainer.end())
-            aThreadPool.run([next, &aContainer, &aFunction]()
-            {
-                for (auto i = next; i != aContainer.end(); ++i)
-                    aFunction(*i);
-            });
-        aThreadPool.wait();
+            for (auto i = std::next(aContainer.begin(), aFirst), end = std::next(aContainer.begin(), aLast); i != end; ++i)
+                aFunction(*i);
+        });
     }
 }
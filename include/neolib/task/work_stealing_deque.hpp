@@ -0,0 +1,170 @@
+// work_stealing_deque.hpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <neolib/neolib.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace neolib
+{
+    // Chase-Lev work-stealing deque (Le, Pop, Cohen and Zappa Nardelli formulation). The owning thread
+    // pushes and pops at the bottom (LIFO); any other thread may steal from the top (FIFO). Buffers
+    // replaced when the deque grows are kept until destruction as a thief may still be reading one.
+    template <typename T>
+    class work_stealing_deque
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "neolib::work_stealing_deque: element type must be trivially copyable");
+    public:
+        typedef T value_type;
+    private:
+        class buffer
+        {
+        public:
+            buffer(std::int64_t aCapacity) :
+                iMask{ aCapacity - 1 }, iSlots{ std::make_unique<std::atomic<value_type>[]>(static_cast<std::size_t>(aCapacity)) }
+            {
+            }
+        public:
+            std::int64_t capacity() const
+            {
+                return iMask + 1;
+            }
+            value_type get(std::int64_t aIndex) const
+            {
+                return iSlots[aIndex & iMask].load(std::memory_order_relaxed);
+            }
+            void put(std::int64_t aIndex, value_type aValue)
+            {
+                iSlots[aIndex & iMask].store(aValue, std::memory_order_relaxed);
+            }
+        private:
+            std::int64_t iMask;
+            std::unique_ptr<std::atomic<value_type>[]> iSlots;
+        };
+    public:
+        work_stealing_deque(std::int64_t aInitialCapacity = 256) :
+            iTop{ 0 }, iBottom{ 0 }
+        {
+            std::int64_t capacity = 1;
+            while (capacity < aInitialCapacity)
+                capacity *= 2;
+            iBuffers.push_back(std::make_unique<buffer>(capacity));
+            iBuffer.store(iBuffers.back().get(), std::memory_order_relaxed);
+        }
+        work_stealing_deque(work_stealing_deque const&) = delete;
+        work_stealing_deque& operator=(work_stealing_deque const&) = delete;
+    public:
+        bool empty() const
+        {
+            return size() == 0u;
+        }
+        // Approximate when called concurrently with the owner or thieves.
+        std::size_t size() const
+        {
+            auto const bottom = iBottom.load(std::memory_order_relaxed);
+            auto const top = iTop.load(std::memory_order_relaxed);
+            return bottom > top ? static_cast<std::size_t>(bottom - top) : 0u;
+        }
+    public:
+        // Owner only.
+        void push(value_type aValue)
+        {
+            auto const bottom = iBottom.load(std::memory_order_relaxed);
+            auto const top = iTop.load(std::memory_order_acquire);
+            auto* current = iBuffer.load(std::memory_order_relaxed);
+            if (bottom - top > current->capacity() - 1)
+                current = grow(current, top, bottom);
+            current->put(bottom, aValue);
+            std::atomic_thread_fence(std::memory_order_release);
+            iBottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        // Owner only.
+        std::optional<value_type> pop()
+        {
+            auto const bottom = iBottom.load(std::memory_order_relaxed) - 1;
+            auto* current = iBuffer.load(std::memory_order_relaxed);
+            iBottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto top = iTop.load(std::memory_order_relaxed);
+            if (top > bottom)
+            {
+                iBottom.store(bottom + 1, std::memory_order_relaxed);
+                return {};
+            }
+            std::optional<value_type> result = current->get(bottom);
+            if (top == bottom)
+            {
+                if (!iTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    result = std::nullopt;
+                iBottom.store(bottom + 1, std::memory_order_relaxed);
+            }
+            return result;
+        }
+        // Any thread; fails spuriously if it loses a race with the owner or another thief.
+        std::optional<value_type> steal()
+        {
+            auto top = iTop.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto const bottom = iBottom.load(std::memory_order_acquire);
+            if (top >= bottom)
+                return {};
+            auto const value = iBuffer.load(std::memory_order_acquire)->get(top);
+            if (!iTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return {};
+            return value;
+        }
+    private:
+        buffer* grow(buffer* aCurrent, std::int64_t aTop, std::int64_t aBottom)
+        {
+            iBuffers.push_back(std::make_unique<buffer>(aCurrent->capacity() * 2));
+            auto* grown = iBuffers.back().get();
+            for (auto index = aTop; index < aBottom; ++index)
+                grown->put(index, aCurrent->get(index));
+            iBuffer.store(grown, std::memory_order_release);
+            return grown;
+        }
+    private:
+        alignas(64) std::atomic<std::int64_t> iTop;
+        alignas(64) std::atomic<std::int64_t> iBottom;
+        std::atomic<buffer*> iBuffer;
+        std::vector<std::unique_ptr<buffer>> iBuffers;
+    };
+}
@@ -34,6 +34,12 @@
  */
 
 #include <neolib/neolib.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <neolib/app/i_power.hpp>
 #include <neolib/ecs/ecs.hpp>
 #include <neolib/ecs/entity_info.hpp>
@@ -51,6 +57,139 @@ namespace neolib
     
 namespace neolib::ecs
 {
+    namespace
+    {
+        // Handle ids carry their slot's full generation above the slot index so that a released handle
+        // id is rejected after its slot has been reused; a slot's generation only repeats after 2^31
+        // reuses. Once all 2^32 - 1 slots are in use add_handle() throws handle_ids_exhausted.
+        constexpr std::uint32_t handle_index_bits = 32u;
+        constexpr handle_id handle_index_mask = (handle_id{ 1u } << handle_index_bits) - 1u;
+
+        std::uint32_t handle_index(handle_id aId)
+        {
+            return static_cast<std::uint32_t>(aId & handle_index_mask);
+        }
+
+        // World files hold a header, a table of component entries and then 64-byte aligned blocks
+        // (entity generations, entity info, then each component's records, entities and reverse indices)
+        // so that a memory-mapped file can be adopted without per-record parsing. Entity info holds
+        // atomics so it is written as plain (entity, archetype, creation time) entries instead.
+        constexpr std::array<char, 8> world_file_magic = { 'N', 'E', 'O', 'E', 'C', 'S', '\0', '\x01' };
+        constexpr std::uint32_t world_file_version = 2u;
+        constexpr std::uint32_t world_file_byte_order = 0x01020304u;
+        constexpr std::uint64_t world_file_block_alignment = 64u;
+
+        struct world_file_header
+        {
+            std::array<char, 8> magic;
+            std::uint32_t version;
+            std::uint32_t byteOrder;
+            std::uint64_t entityCount;
+            std::uint64_t componentCount;
+            std::uint64_t generationsOffset;
+            std::uint64_t entityInfoCount;
+            std::uint64_t entityInfoOffset;
+        };
+
+        struct world_file_entity_info
+        {
+            entity_id entity;
+            entity_archetype_id archetype;
+            i64 creationTime;
+        };
+
+        struct world_file_component
+        {
+            component_id id;
+            std::uint64_t layout;
+            std::uint64_t recordSize;
+            std::uint64_t recordCount;
+            std::uint64_t reverseIndexCount;
+            std::uint64_t dataOffset;
+            std::uint64_t entitiesOffset;
+            std::uint64_t reverseIndicesOffset;
+        };
+
+        std::uint64_t world_file_aligned(std::uint64_t aOffset)
+        {
+            return (aOffset + world_file_block_alignment - 1u) / world_file_block_alignment * world_file_block_alignment;
+        }
+
+        // FNV-1a of the record layout and field metadata; a mismatch means the component has changed
+        // shape since the file was written.
+        std::uint64_t world_file_layout(const i_component& aComponent)
+        {
+            std::uint64_t hash = 0xcbf29ce484222325ull;
+            auto const add = [&](void const* aData, std::size_t aSize)
+            {
+                for (auto byte : std::span<unsigned char const>{ static_cast<unsigned char const*>(aData), aSize })
+                    hash = (hash ^ byte) * 0x100000001b3ull;
+            };
+            auto const addValue = [&](std::uint64_t aValue)
+            {
+                add(&aValue, sizeof(aValue));
+            };
+            addValue(aComponent.record_size());
+            addValue(aComponent.record_alignment());
+            addValue(aComponent.field_count());
+            for (std::uint32_t fieldIndex = 0u; fieldIndex < aComponent.field_count(); ++fieldIndex)
+            {
+                addValue(static_cast<std::uint64_t>(aComponent.field_type(fieldIndex)));
+                auto const fieldTypeId = aComponent.field_type_id(fieldIndex);
+                add(&fieldTypeId, sizeof(fieldTypeId));
+                auto const& fieldName = aComponent.field_name(fieldIndex);
+                add(fieldName.c_str(), fieldName.size());
+            }
+            return hash;
+        }
+
+        template <typename T>
+        std::span<T const> world_file_block(std::span<std::byte const> aFile, std::uint64_t aOffset, std::uint64_t aCount)
+        {
+            if (aOffset % alignof(T) != 0u || aOffset > aFile.size() || aCount > (aFile.size() - aOffset) / sizeof(T))
+                throw i_ecs::invalid_world_file("block out of range");
+            return std::span<T const>{ reinterpret_cast<T const*>(aFile.data() + aOffset), static_cast<std::size_t>(aCount) };
+        }
+
+        bool world_file_entity_alive(std::span<generation_t const> aGenerations, entity_id aEntity)
+        {
+            return aEntity != null_entity && aEntity <= aGenerations.size() && (aGenerations[aEntity - 1u] & 1u) == 1u;
+        }
+
+        // Every entity of a component block must be alive in the file's generation table and the entity
+        // and reverse index blocks must describe the same one-to-one mapping.
+        void world_file_validate(std::span<generation_t const> aGenerations, std::span<entity_id const> aEntities, std::span<std::size_t const> aReverseIndices)
+        {
+            constexpr std::size_t noRecord = ~std::size_t{};
+            if (aReverseIndices.size() > aGenerations.size() + 1u)
+                throw i_ecs::invalid_world_file("reverse index block out of range");
+            for (std::size_t index = 0u; index < aEntities.size(); ++index)
+            {
+                auto const entity = aEntities[index];
+                if (!world_file_entity_alive(aGenerations, entity) || entity >= aReverseIndices.size() || aReverseIndices[entity] != index)
+                    throw i_ecs::invalid_world_file("entity out of range");
+            }
+            std::size_t indexed = 0u;
+            for (auto reverseIndex : aReverseIndices)
+                if (reverseIndex != noRecord)
+                {
+                    if (reverseIndex >= aEntities.size())
+                        throw i_ecs::invalid_world_file("reverse index out of range");
+                    ++indexed;
+                }
+            if (indexed != aEntities.size())
+                throw i_ecs::invalid_world_file("reverse index mismatch");
+        }
+
+        void world_file_write(std::ofstream& aStream, std::uint64_t aOffset, std::span<std::byte const> aBlock)
+        {
+            static constexpr std::array<char, world_file_block_alignment> padding = {};
+            auto const position = static_cast<std::uint64_t>(aStream.tellp());
+            aStream.write(padding.data(), static_cast<std::streamsize>(aOffset - position));
+            aStream.write(reinterpret_cast<char const*>(aBlock.data()), static_cast<std::streamsize>(aBlock.size()));
+        }
+    }
+
     const ecs::archetype_registry_t& ecs::archetypes() const
     {
         return iArchetypeRegistry;
@@ -61,6 +200,16 @@ namespace neolib::ecs
         return iArchetypeRegistry;
     }
 
+    const ecs::archetype_storages_t& ecs::archetype_storages() const
+    {
+        return iArchetypeStorages;
+    }
+
+    ecs::archetype_storages_t& ecs::archetype_storages()
+    {
+        return iArchetypeStorages;
+    }
+
     const ecs::component_factories_t& ecs::component_factories() const
     {
         return iComponentFactories;
@@ -153,6 +302,10 @@ namespace neolib::ecs
         {
             auto& c = *iComponents.emplace(aComponentId, existingFactory->second()).first->second;
             iComponentMutexes.emplace_back(c.mutex());
+            auto const componentOrdinal = const_cast<ecs&>(*this).ordinal(aComponentId);
+            if (iOrdinalComponents.size() <= componentOrdinal)
+                iOrdinalComponents.resize(componentOrdinal + 1u, nullptr);
+            iOrdinalComponents[componentOrdinal] = &c;
             for (auto& s : iSystems)
                 s.second->update_component_availability();
             return c;
@@ -219,26 +372,234 @@ namespace neolib::ecs
 
     entity_id ecs::next_entity_id()
     {
-        std::unique_lock lock{ entity_mutex() };
-        if (!iFreedEntityIds.empty())
-        {
-            auto nextId = iFreedEntityIds.back();
-            iFreedEntityIds.pop_back();
-            return nextId;
-        }
-        if (++iNextEntityId == null_entity)
+        auto const nextId = iEntityIds.allocate();
+        if (nextId == null_entity)
             throw entity_ids_exhausted();
-        return iNextEntityId;
+        return nextId;
     }
 
     void ecs::free_entity_id(entity_id aId)
     {
-        std::unique_lock lock{ entity_mutex() };
-        iFreedEntityIds.push_back(aId);
+        iEntityIds.free(aId);
+    }
+
+    generation_t ecs::entity_generation(entity_id aId) const
+    {
+        return iEntityIds.generation(aId);
+    }
+
+    void ecs::save_world(const std::string& aPath) const
+    {
+        std::unique_lock lock1{ component_mutex() };
+        scoped_multi_lock<decltype(iComponentMutexes)> lock2{ iComponentMutexes };
+        std::vector<i_component const*> components;
+        for (auto const& c : iComponents)
+            if (c.second->bitwise_serializable() && !c.second->entity_block_no_lock().empty())
+                components.push_back(c.second.get());
+        std::vector<generation_t> generations(iEntityIds.high_water());
+        for (std::size_t index = 0u; index < generations.size(); ++index)
+            generations[index] = iEntityIds.generation(static_cast<entity_id>(index + 1u));
+        std::vector<world_file_entity_info> infos;
+        auto const existingInfos = iComponents.find(entity_info::meta::id());
+        if (existingInfos != iComponents.end())
+        {
+            auto const& c = static_cast<const neolib::ecs::component<entity_info>&>(*existingInfos->second);
+            infos.reserve(c.entities().size());
+            for (auto entity : c.entities())
+                if (entity != null_entity)
+                {
+                    auto const& info = c.entity_record_no_lock(entity);
+                    infos.push_back(world_file_entity_info{ entity, info.archetypeId, info.creationTime });
+                }
+        }
+        world_file_header header{ world_file_magic, world_file_version, world_file_byte_order, generations.size(), components.size(), 0u, infos.size(), 0u };
+        std::uint64_t offset = sizeof(world_file_header) + components.size() * sizeof(world_file_component);
+        header.generationsOffset = world_file_aligned(offset);
+        offset = header.generationsOffset + generations.size() * sizeof(generation_t);
+        header.entityInfoOffset = world_file_aligned(offset);
+        offset = header.entityInfoOffset + infos.size() * sizeof(world_file_entity_info);
+        std::vector<world_file_component> entries;
+        entries.reserve(components.size());
+        for (auto c : components)
+        {
+            auto& entry = entries.emplace_back();
+            entry.id = c->id();
+            entry.layout = world_file_layout(*c);
+            entry.recordSize = c->record_size();
+            entry.recordCount = c->entity_block_no_lock().size();
+            entry.reverseIndexCount = c->reverse_index_block_no_lock().size();
+            entry.dataOffset = world_file_aligned(offset);
+            offset = entry.dataOffset + c->data_block_no_lock().size();
+            entry.entitiesOffset = world_file_aligned(offset);
+            offset = entry.entitiesOffset + entry.recordCount * sizeof(entity_id);
+            entry.reverseIndicesOffset = world_file_aligned(offset);
+            offset = entry.reverseIndicesOffset + entry.reverseIndexCount * sizeof(std::size_t);
+        }
+        std::ofstream file{ aPath, std::ios::binary | std::ios::trunc };
+        if (!file)
+            throw invalid_world_file("cannot create " + aPath);
+        file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        file.write(reinterpret_cast<char const*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(world_file_component)));
+        world_file_write(file, header.generationsOffset, std::as_bytes(std::span{ generations }));
+        world_file_write(file, header.entityInfoOffset, std::as_bytes(std::span{ infos }));
+        for (std::size_t index = 0u; index < components.size(); ++index)
+        {
+            world_file_write(file, entries[index].dataOffset, components[index]->data_block_no_lock());
+            world_file_write(file, entries[index].entitiesOffset, std::as_bytes(components[index]->entity_block_no_lock()));
+            world_file_write(file, entries[index].reverseIndicesOffset, std::as_bytes(components[index]->reverse_index_block_no_lock()));
+        }
+        if (!file.flush())
+            throw invalid_world_file("cannot write " + aPath);
+    }
+
+    void ecs::load_world(const std::string& aPath)
+    {
+        if (iEntityIds.high_water() != null_entity)
+            throw world_not_empty();
+        std::error_code ec;
+        auto const fileSize = std::filesystem::file_size(aPath, ec);
+        if (ec || fileSize < sizeof(world_file_header))
+            throw invalid_world_file("truncated: " + aPath);
+        boost::interprocess::file_mapping mapping{ aPath.c_str(), boost::interprocess::read_only };
+        boost::interprocess::mapped_region region{ mapping, boost::interprocess::read_only };
+        std::span<std::byte const> const file{ static_cast<std::byte const*>(region.get_address()), region.get_size() };
+        auto const& header = world_file_block<world_file_header>(file, 0u, 1u)[0];
+        if (header.magic != world_file_magic || header.version != world_file_version || header.byteOrder != world_file_byte_order)
+            throw invalid_world_file("unrecognized format: " + aPath);
+        auto const entries = world_file_block<world_file_component>(file, sizeof(world_file_header), header.componentCount);
+        auto const generations = world_file_block<generation_t>(file, header.generationsOffset, header.entityCount);
+        if (header.entityCount > iEntityIds.max_id())
+            throw invalid_world_file("too many entities: " + aPath);
+        auto const infos = world_file_block<world_file_entity_info>(file, header.entityInfoOffset, header.entityInfoCount);
+        std::vector<bool> infoSeen(generations.size() + 1u);
+        for (auto const& info : infos)
+        {
+            if (!world_file_entity_alive(generations, info.entity))
+                throw invalid_world_file("entity out of range");
+            if (infoSeen[info.entity])
+                throw invalid_world_file("duplicate entity info");
+            infoSeen[info.entity] = true;
+        }
+        std::vector<i_component*> components;
+        components.reserve(entries.size());
+        struct component_blocks
+        {
+            std::span<std::byte const> data;
+            std::span<entity_id const> entities;
+            std::span<std::size_t const> reverseIndices;
+        };
+        std::vector<component_blocks> blocks;
+        blocks.reserve(entries.size());
+        for (auto const& entry : entries)
+        {
+            auto& c = component(entry.id);
+            if (std::find(components.begin(), components.end(), &c) != components.end())
+                throw invalid_world_file("duplicate component: " + c.name().to_std_string());
+            if (!c.bitwise_serializable() || entry.recordSize != c.record_size() || entry.layout != world_file_layout(c))
+                throw incompatible_component(c.name().to_std_string());
+            if (entry.recordCount > header.entityCount)
+                throw invalid_world_file("record count out of range");
+            auto const entities = world_file_block<entity_id>(file, entry.entitiesOffset, entry.recordCount);
+            auto const reverseIndices = world_file_block<std::size_t>(file, entry.reverseIndicesOffset, entry.reverseIndexCount);
+            world_file_validate(generations, entities, reverseIndices);
+            blocks.push_back({ world_file_block<std::byte>(file, entry.dataOffset, entry.recordCount * entry.recordSize), entities, reverseIndices });
+            components.push_back(&c);
+        }
+        iEntityIds.restore(generations);
+        if (!infos.empty())
+        {
+            std::vector<entity_id> infoEntities;
+            infoEntities.reserve(infos.size());
+            for (auto const& info : infos)
+                infoEntities.push_back(info.entity);
+            component<entity_info>().populate_from(std::span<entity_id const>{ infoEntities }, [&](std::size_t aIndex)
+            {
+                return entity_info{ infos[aIndex].archetype, infos[aIndex].creationTime };
+            });
+        }
+        std::unique_lock lock1{ component_mutex() };
+        scoped_multi_lock<decltype(iComponentMutexes)> lock2{ iComponentMutexes };
+        for (std::size_t index = 0u; index < components.size(); ++index)
+            components[index]->adopt_blocks_no_lock(blocks[index].data, blocks[index].entities, blocks[index].reverseIndices);
+    }
+
+    component_ordinal ecs::ordinal(component_id aComponentId)
+    {
+        std::unique_lock lock{ component_mutex() };
+        return iComponentOrdinals.emplace(aComponentId, static_cast<component_ordinal>(iComponentOrdinals.size())).first->second;
+    }
+
+    component_signature ecs::signature(entity_id aEntity) const
+    {
+        std::unique_lock lock{ iSignatureMutex };
+        return component_signature{ signature_no_lock(aEntity) };
+    }
+
+    bool ecs::matches(entity_id aEntity, const component_signature& aSignature) const
+    {
+        std::unique_lock lock{ iSignatureMutex };
+        return signature_includes(signature_no_lock(aEntity), aSignature.words());
+    }
+
+    bool ecs::has_component(entity_id aEntity, component_id aComponentId) const
+    {
+        std::unique_lock lock1{ component_mutex() };
+        auto const existing = iComponentOrdinals.find(aComponentId);
+        if (existing == iComponentOrdinals.end())
+            return false;
+        std::unique_lock lock2{ iSignatureMutex };
+        return component_signature{ signature_no_lock(aEntity) }.test(existing->second);
+    }
+
+    void ecs::entities_matching(const component_signature& aSignature, std::vector<entity_id>& aEntities) const
+    {
+        std::unique_lock lock{ iSignatureMutex };
+        auto const entityCount = iSignatures.size() / iSignatureStride;
+        for (entity_id entity = 1u; entity < entityCount; ++entity)
+        {
+            auto const words = signature_no_lock(entity);
+            if (std::any_of(words.begin(), words.end(), [](auto aWord) { return aWord != 0u; }) && signature_includes(words, aSignature.words()))
+                aEntities.push_back(entity);
+        }
+    }
+
+    void ecs::update_signatures(std::span<entity_id const> aEntities, component_ordinal aOrdinal, bool aPresent)
+    {
+        std::unique_lock lock{ iSignatureMutex };
+        auto const word = aOrdinal / component_signature::bits_per_word;
+        auto const bit = component_signature::word_type{ 1u } << (aOrdinal % component_signature::bits_per_word);
+        if (word >= iSignatureStride)
+        {
+            auto const newStride = word + 1u;
+            std::vector<component_signature::word_type> restrided((iSignatures.size() / iSignatureStride) * newStride, 0u);
+            for (std::size_t entity = 0u; entity < iSignatures.size() / iSignatureStride; ++entity)
+                std::copy_n(std::next(iSignatures.begin(), entity * iSignatureStride), iSignatureStride, std::next(restrided.begin(), entity * newStride));
+            iSignatures.swap(restrided);
+            iSignatureStride = newStride;
+        }
+        for (auto entity : aEntities)
+        {
+            auto const offset = entity * iSignatureStride + word;
+            if (aPresent)
+            {
+                if (iSignatures.size() <= offset)
+                    iSignatures.resize((entity + 1u) * iSignatureStride, 0u);
+                iSignatures[offset] |= bit;
+            }
+            else if (offset < iSignatures.size())
+                iSignatures[offset] &= ~bit;
+        }
+    }
+
+    std::span<component_signature::word_type const> ecs::signature_no_lock(entity_id aEntity) const
+    {
+        if ((aEntity + 1u) * iSignatureStride > iSignatures.size())
+            return {};
+        return std::span<component_signature::word_type const>{ std::next(iSignatures.data(), aEntity * iSignatureStride), iSignatureStride };
     }
 
     ecs::ecs(ecs_flags aCreationFlags) :
-        iFlags{ aCreationFlags }, iNextEntityId { null_entity }, iNextHandleId{ null_id },
+        iFlags{ aCreationFlags }, iSignatureStride{ 1u }, iHandleIds{ static_cast<std::uint32_t>(handle_index_mask) },
         iSystemTimer
         {
             service<i_async_task>(),
@@ -249,7 +610,7 @@ namespace neolib::ecs
                     if (system.second->can_apply())
                     {
                         system_id ignore;
-                        if (!is_child(system.first, ignore))
+                        if (!is_child(system.first, ignore) && !is_scheduled(system.first))
                             system.second->apply();
                     }
                 commit_async_entity_destruction();
@@ -335,9 +696,7 @@ namespace neolib::ecs
 
     entity_id ecs::create_entity(const entity_archetype_id& aArchetypeId)
     {
-        std::unique_lock lock{ entity_mutex() };
         auto entityId = next_entity_id();
-        lock.unlock();
         if ((flags() & ecs_flags::PopulateEntityInfo) == ecs_flags::PopulateEntityInfo)
             component<entity_info>().populate(entityId, entity_info{ aArchetypeId, system<time>().world_time() });
         EntityCreated.trigger(entityId);
@@ -370,17 +729,97 @@ namespace neolib::ecs
 
     void ecs::destroy_entity(entity_id aEntityId, bool aNotify)
     {
+        if (!iEntityIds.alive(aEntityId))
+            return;
         if (aNotify)
             EntityDestroyed.trigger(aEntityId);
+        destroy_entity_records(std::span<entity_id const>{ &aEntityId, 1u });
+        free_entity_id(aEntityId);
+    }
+
+    void ecs::create_entities(const entity_archetype_id& aArchetypeId, std::span<entity_id> aNewEntities)
+    {
+        for (auto& newEntity : aNewEntities)
+            newEntity = next_entity_id();
+        commit_entities(aArchetypeId, aNewEntities);
+    }
+
+    void ecs::commit_entities(const entity_archetype_id& aArchetypeId, std::span<entity_id const> aReservedEntities)
+    {
+        if ((flags() & ecs_flags::PopulateEntityInfo) == ecs_flags::PopulateEntityInfo)
+            component<entity_info>().populate(aReservedEntities, entity_info{ aArchetypeId, system<time>().world_time() });
+        EntitiesCreated.trigger(aReservedEntities);
+        if (EntityCreated.has_slots())
+            for (auto entity : aReservedEntities)
+                EntityCreated.trigger(entity);
+    }
+
+    void ecs::destroy_entities(std::span<entity_id const> aEntities, bool aNotify)
+    {
+        std::vector<entity_id> live;
+        if (std::any_of(aEntities.begin(), aEntities.end(), [&](entity_id aEntity) { return !iEntityIds.alive(aEntity); }))
         {
-            scoped_multi_lock<decltype(iComponentMutexes)> lock{ iComponentMutexes };
-            for (auto& component : iComponents)
-                if (component.second->has_entity_record(aEntityId))
-                    component.second->destroy_entity_record(aEntityId);
+            std::copy_if(aEntities.begin(), aEntities.end(), std::back_inserter(live), [&](entity_id aEntity) { return iEntityIds.alive(aEntity); });
+            aEntities = live;
         }
+        if (aEntities.empty())
+            return;
+        if (aNotify)
         {
-            std::unique_lock lock{ entity_mutex() };
-            free_entity_id(aEntityId);
+            EntitiesDestroyed.trigger(aEntities);
+            if (EntityDestroyed.has_slots())
+                for (auto entity : aEntities)
+                    EntityDestroyed.trigger(entity);
+        }
+        destroy_entity_records(aEntities);
+        for (auto entity : aEntities)
+            free_entity_id(entity);
+    }
+
+    // Signatures say which components to lock; they are read again once those locks are held so that a
+    // populate racing with the first read is not missed. Each component clears its own signature bits as
+    // it destroys its records, so bits of components that are not visited here are left alone.
+    void ecs::destroy_entity_records(std::span<entity_id const> aEntities)
+    {
+        auto const signatures = [&]()
+        {
+            component_signature result;
+            std::unique_lock lock{ iSignatureMutex };
+            for (auto entity : aEntities)
+                result |= signature_no_lock(entity);
+            return result;
+        };
+        auto touched = signatures();
+        for (;;)
+        {
+            std::vector<i_component*> touchedComponents;
+            std::vector<proxy_mutex<i_lockable>> touchedMutexes;
+            {
+                std::unique_lock lock{ component_mutex() };
+                touched.for_each([&](component_ordinal aOrdinal)
+                {
+                    if (aOrdinal < iOrdinalComponents.size() && iOrdinalComponents[aOrdinal] != nullptr)
+                    {
+                        touchedComponents.push_back(iOrdinalComponents[aOrdinal]);
+                        touchedMutexes.emplace_back(iOrdinalComponents[aOrdinal]->mutex());
+                    }
+                });
+            }
+            scoped_multi_lock<decltype(touchedMutexes)> lock{ touchedMutexes };
+            auto const current = signatures();
+            if (!touched.includes(current))
+            {
+                touched |= current;
+                continue;
+            }
+            for (auto component : touchedComponents)
+                component->destroy_entity_records(aEntities);
+            break;
+        }
+        {
+            std::unique_lock lock{ archetype_mutex() };
+            for (auto& storage : iArchetypeStorages)
+                storage.second->destroy_entity_records(aEntities);
         }
     }
 
@@ -396,6 +835,23 @@ namespace neolib::ecs
         }
     }
 
+    void ecs::async_destroy_entities(std::span<entity_id const> aEntities, bool aNotify)
+    {
+        if (aEntities.empty())
+            return;
+        {
+            scoped_component_data_lock<entity_info> lock{ *this };
+            auto& infos = component<entity_info>();
+            for (auto entity : aEntities)
+                infos.entity_record_no_lock(entity).destroyed = true;
+        }
+        {
+            std::unique_lock lock{ entity_mutex() };
+            for (auto entity : aEntities)
+                iEntitiesToDestroy.emplace_back(entity, aNotify);
+        }
+    }
+
     void ecs::commit_async_entity_destruction()
     {
         auto entitiesToDestroy = decltype(iEntitiesToDestroy){};
@@ -426,6 +882,22 @@ namespace neolib::ecs
         return false;
     }
 
+    bool ecs::is_scheduled(const system_id& aSystemId) const
+    {
+        std::unique_lock lock{ system_mutex() };
+        return std::find(iScheduledSystems.begin(), iScheduledSystems.end(), aSystemId) != iScheduledSystems.end();
+    }
+
+    void ecs::set_scheduled(const system_id& aSystemId, bool aScheduled)
+    {
+        std::unique_lock lock{ system_mutex() };
+        auto existing = std::find(iScheduledSystems.begin(), iScheduledSystems.end(), aSystemId);
+        if (aScheduled && existing == iScheduledSystems.end())
+            iScheduledSystems.push_back(aSystemId);
+        else if (!aScheduled && existing != iScheduledSystems.end())
+            iScheduledSystems.erase(existing);
+    }
+
     bool ecs::all_systems_paused() const
     {
         return iSystemsPaused;
@@ -489,6 +961,27 @@ namespace neolib::ecs
             throw uuid_exists("register_archetype");
     }
 
+    bool ecs::archetype_storage_registered(entity_archetype_id aArchetypeId) const
+    {
+        std::unique_lock lock{ archetype_mutex() };
+        return archetype_storages().find(aArchetypeId) != archetype_storages().end();
+    }
+
+    void ecs::register_archetype_storage(i_archetype_storage& aStorage)
+    {
+        std::unique_lock lock{ archetype_mutex() };
+        if (!archetype_storages().emplace(aStorage.archetype_id(), &aStorage).second)
+            throw uuid_exists("register_archetype_storage");
+    }
+
+    void ecs::unregister_archetype_storage(i_archetype_storage& aStorage)
+    {
+        std::unique_lock lock{ archetype_mutex() };
+        auto existing = archetype_storages().find(aStorage.archetype_id());
+        if (existing != archetype_storages().end() && existing->second == &aStorage)
+            archetype_storages().erase(existing);
+    }
+
     bool ecs::component_registered(component_id aComponentId) const
     {
         std::unique_lock lock{ component_factory_mutex() };
@@ -531,56 +1024,56 @@ namespace neolib::ecs
     ecs::handle_t ecs::to_handle(handle_id aId) const
     {
         std::unique_lock lock{ mutex() };
-        return iHandles[aId];
+        auto const index = handle_index(aId);
+        if (iHandles.size() <= index || iHandles[index].second != aId)
+            throw invalid_handle_id();
+        return iHandles[index].first;
     }
 
     handle_id ecs::add_handle(const std::type_info&, handle_t aHandle)
     {
-        std::unique_lock lock{ mutex() };
         auto nextHandleId = next_handle_id();
-        if (iHandles.size() <= nextHandleId)
-            iHandles.resize(nextHandleId);
-        iHandles[nextHandleId] = aHandle;
+        std::unique_lock lock{ mutex() };
+        auto const index = handle_index(nextHandleId);
+        if (iHandles.size() <= index)
+            iHandles.resize(index + 1u);
+        iHandles[index] = { aHandle, nextHandleId };
         return nextHandleId;
     }
 
     ecs::handle_t ecs::update_handle(handle_id aId, const std::type_info&, handle_t aHandle)
     {
         std::unique_lock lock{ mutex() };
-        if (iHandles.size() <= aId)
+        auto const index = handle_index(aId);
+        if (iHandles.size() <= index || iHandles[index].second != aId)
             throw invalid_handle_id();
-        iHandles[aId] = aHandle;
+        iHandles[index].first = aHandle;
         return aHandle;
     }
 
     ecs::handle_t ecs::release_handle(handle_id aId)
     {
         std::unique_lock lock{ mutex() };
-        if (iHandles.size() <= aId)
+        auto const index = handle_index(aId);
+        if (iHandles.size() <= index || iHandles[index].second != aId)
             throw invalid_handle_id();
-        auto handle = iHandles[aId];
-        iHandles[aId] = nullptr;
+        auto handle = iHandles[index].first;
+        iHandles[index] = {};
+        lock.unlock();
         free_handle_id(aId);
         return handle;
     }
 
     handle_id ecs::next_handle_id()
     {
-        std::unique_lock lock{ mutex() };
-        if (!iFreedHandleIds.empty())
-        {
-            auto nextId = iFreedHandleIds.back();
-            iFreedHandleIds.pop_back();
-            return nextId;
-        }
-        if (++iNextHandleId == null_id)
+        auto const index = iHandleIds.allocate();
+        if (index == null_id)
             throw handle_ids_exhausted();
-        return iNextHandleId;
+        return static_cast<handle_id>(index) | (static_cast<handle_id>(iHandleIds.generation(index)) << handle_index_bits);
     }
 
     void ecs::free_handle_id(handle_id aId)
     {
-        std::unique_lock lock{ mutex() };
-        iFreedHandleIds.push_back(aId);
+        iHandleIds.free(handle_index(aId));
     }
 }
\ No newline at end of file
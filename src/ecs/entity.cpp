@@ -48,6 +48,11 @@ namespace neolib::ecs
             if (aId == iId)
                 iId = null_entity;
         });
+        iSink += ecs().entities_destroyed([this](std::span<entity_id const> aIds)
+        {
+            if (std::find(aIds.begin(), aIds.end(), iId) != aIds.end())
+                iId = null_entity;
+        });
     }
 
     entity::entity(i_ecs& aEcs, const entity_archetype_id& aArchetypeId) :
@@ -78,7 +83,7 @@ namespace neolib::ecs
 
     entity_id entity::detach()
     {
-        ecs().archetype(ecs().component<entity_info>().entity_record(id()).archetypeId).populate_default_components(ecs(), id());
+        ecs().archetype(ecs().component<entity_info>().entity_record(id()).archetypeId).populate_default_components(ecs(), std::span<entity_id const>{ &iId, 1u });
         auto id = iId;
         iId = null_entity;
         return id;
@@ -0,0 +1,218 @@
+// system_scheduler.cpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <neolib/neolib.hpp>
+#include <algorithm>
+#include <neolib/ecs/system_scheduler.hpp>
+
+namespace neolib::ecs
+{
+    system_scheduler::system_scheduler(i_ecs& aEcs) :
+        iEcs{ aEcs }
+    {
+    }
+
+    system_scheduler::~system_scheduler()
+    {
+        for (auto s : iSystems)
+            ecs().set_scheduled(s->id(), false);
+    }
+
+    i_ecs& system_scheduler::ecs() const
+    {
+        return iEcs;
+    }
+
+    const std::vector<i_system*>& system_scheduler::systems() const
+    {
+        return iSystems;
+    }
+
+    void system_scheduler::add(i_system& aSystem)
+    {
+        if (iInFrame)
+            throw frame_in_progress();
+        if (std::find(iSystems.begin(), iSystems.end(), &aSystem) != iSystems.end())
+            throw system_already_scheduled();
+        iSystems.push_back(&aSystem);
+        ecs().set_scheduled(aSystem.id(), true);
+    }
+
+    void system_scheduler::remove(i_system& aSystem)
+    {
+        if (iInFrame)
+            throw frame_in_progress();
+        auto existing = std::find(iSystems.begin(), iSystems.end(), &aSystem);
+        if (existing == iSystems.end())
+            throw system_not_scheduled();
+        iSystems.erase(existing);
+        ecs().set_scheduled(aSystem.id(), false);
+    }
+
+    bool system_scheduler::conflicts(const i_system& aLhs, const i_system& aRhs)
+    {
+        auto check = [](const i_system& aFirst, const i_system& aSecond)
+        {
+            for (auto const& componentId : aFirst.components())
+            {
+                auto const first = aFirst.access(componentId);
+                auto const second = aSecond.access(componentId);
+                if (first != component_access::None && second != component_access::None &&
+                    (first == component_access::ReadWrite || second == component_access::ReadWrite))
+                    return true;
+            }
+            return false;
+        };
+        return check(aLhs, aRhs) || check(aRhs, aLhs);
+    }
+
+    void system_scheduler::run_frame()
+    {
+        if (iInFrame)
+            throw frame_in_progress();
+        scoped_atomic_flag inFrame{ iInFrame };
+        build_graph();
+        if (iGraph.empty())
+            return;
+        {
+            std::unique_lock lock{ iMutex };
+            iRemaining = iGraph.size();
+            iError = nullptr;
+        }
+        for (std::size_t n = 0u; n < iGraph.size(); ++n)
+            iPending[n] = iGraph[n].predecessors;
+        for (std::size_t n = 0u; n < iGraph.size(); ++n)
+            if (iGraph[n].predecessors == 0u)
+                dispatch(n);
+        // Help the pool while waiting: the frame may be run from a pool task and its nodes may be queued
+        // behind the caller. Only block when there was nothing to help with and nothing has been
+        // dispatched since.
+        std::unique_lock lock{ iMutex };
+        while (iRemaining != 0u)
+        {
+            auto const dispatched = iDispatched;
+            lock.unlock();
+            bool const helped = ecs().thread_pool().help();
+            lock.lock();
+            if (!helped)
+                iFrameDone.wait(lock, [this, dispatched]() { return iRemaining == 0u || iDispatched != dispatched; });
+        }
+        if (iError)
+            std::rethrow_exception(iError);
+    }
+
+    std::size_t system_scheduler::run_paced_frame(frame_pacer& aPacer)
+    {
+        auto const steps = aPacer.wait();
+        for (std::size_t step = 0u; step < steps; ++step)
+            run_frame();
+        aPacer.tick_completed();
+        return steps;
+    }
+
+    std::size_t system_scheduler::frame_batches() const
+    {
+        return iBatches;
+    }
+
+    void system_scheduler::build_graph()
+    {
+        iGraph.clear();
+        for (auto s : iSystems)
+            if (s->components_available() && s->can_apply() && !s->paused())
+                iGraph.push_back(node{ s });
+        for (std::size_t later = 0u; later < iGraph.size(); ++later)
+            for (std::size_t earlier = 0u; earlier < later; ++earlier)
+                if (conflicts(*iGraph[earlier].system, *iGraph[later].system))
+                {
+                    iGraph[earlier].successors.push_back(later);
+                    ++iGraph[later].predecessors;
+                }
+        iPending = std::make_unique<std::atomic<std::size_t>[]>(iGraph.size());
+        std::vector<std::size_t> depth(iGraph.size(), 0u);
+        iBatches = 0u;
+        for (std::size_t n = 0u; n < iGraph.size(); ++n)
+        {
+            for (auto successor : iGraph[n].successors)
+                depth[successor] = std::max(depth[successor], depth[n] + 1u);
+            iBatches = std::max(iBatches, depth[n] + 1u);
+        }
+    }
+
+    void system_scheduler::dispatch(std::size_t aNode)
+    {
+        if (ecs().thread_pool().run([this, aNode]() { execute(aNode); }).second == nullptr)
+        {
+            // The pool is stopped; run the node here rather than leave the frame waiting for it.
+            execute(aNode);
+            return;
+        }
+        std::unique_lock lock{ iMutex };
+        ++iDispatched;
+        iFrameDone.notify_all();
+    }
+
+    void system_scheduler::execute(std::size_t aNode)
+    {
+        std::optional<std::size_t> next = aNode;
+        while (next)
+        {
+            auto const current = *next;
+            next = std::nullopt;
+            auto& n = iGraph[current];
+            try
+            {
+                n.system->apply();
+            }
+            catch (...)
+            {
+                std::unique_lock lock{ iMutex };
+                if (!iError)
+                    iError = std::current_exception();
+            }
+            for (auto successor : n.successors)
+                if (--iPending[successor] == 0u)
+                {
+                    if (!next)
+                        next = successor;
+                    else
+                        dispatch(successor);
+                }
+            std::unique_lock lock{ iMutex };
+            if (--iRemaining == 0u)
+                iFrameDone.notify_all();
+        }
+    }
+}
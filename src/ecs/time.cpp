@@ -53,8 +53,10 @@ namespace neolib::ecs
         system{ aEcs },
         iInfos{ aEcs.component<entity_info>() },
         iLifeSpans{ aEcs.component<entity_life_span>() },
-        iWorldClock{ world_clock(aEcs) }
+        iWorldClock{ world_clock(aEcs) },
+        iLifeSpansVersion{ 0u }
     {
+        iLifeSpans.enable_change_tracking();
         start_thread_if();
     }
 
@@ -80,17 +82,36 @@ namespace neolib::ecs
         {
             scoped_component_lock lock{ iLifeSpans };
 
-            for (auto entity : iLifeSpans.entities())
+            // An entity expires once its age exceeds its life span; life spans added or changed since the
+            // last update are (re)scheduled and superseded wheel entries are discarded when they fire.
+            auto const& infos = std::as_const(iInfos);
+            auto const& lifeSpans = std::as_const(iLifeSpans);
+            auto expiry = [&](entity_id aEntity, entity_life_span const& aLifeSpan)
             {
-                auto const& info = iInfos.entity_record_no_lock(entity);
-                if (info.destroyed)
-                    continue;
-                auto const& lifeSpan = iLifeSpans.entity_record(entity);
-                auto const age = world_time() - info.creationTime;
-                waitDuration = std::min(waitDuration, lifeSpan.lifeSpan - age);
-                if (age > lifeSpan.lifeSpan)
-                    ecs().async_destroy_entity(entity);
-            }
+                return infos.entity_record_no_lock(aEntity).creationTime + aLifeSpan.lifeSpan + 1;
+            };
+            iLifeSpans.changed_since_no_lock(iLifeSpansVersion, [&](entity_id aEntity, entity_life_span const& aLifeSpan)
+            {
+                if (!infos.entity_record_no_lock(aEntity).destroyed)
+                    iExpiries.schedule(expiry(aEntity, aLifeSpan), ecs().to_ref(aEntity));
+            });
+            iLifeSpansVersion = iLifeSpans.checkpoint();
+
+            iExpired.clear();
+            iExpiries.advance(world_time(), [&](auto const& aEntry)
+            {
+                auto const entity = aEntry.payload.id;
+                if (!ecs().valid(aEntry.payload) || !lifeSpans.has_entity_record_no_lock(entity) || infos.entity_record_no_lock(entity).destroyed)
+                    return;
+                if (expiry(entity, lifeSpans.entity_record_no_lock(entity)) == aEntry.expiry)
+                    iExpired.push_back(entity);
+            });
+            std::sort(iExpired.begin(), iExpired.end());
+            iExpired.erase(std::unique(iExpired.begin(), iExpired.end()), iExpired.end());
+            ecs().async_destroy_entities(iExpired);
+
+            if (auto const next = iExpiries.next_expiry())
+                waitDuration = *next - world_time();
         }
 
         if (have_thread() && get_thread().in())
@@ -0,0 +1,234 @@
+// cpu_topology.cpp
+/*
+ *  Copyright (c) 2026 Leigh Johnston.
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are
+ *  met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ *     * Neither the name of Leigh Johnston nor the names of any
+ *       other contributors to this software may be used to endorse or
+ *       promote products derived from this software without specific prior
+ *       written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ *  IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ *  THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ *  PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ *  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <neolib/neolib.hpp>
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <tuple>
+#include <string>
+#include <thread>
+#include <utility>
+#include <neolib/chrono/tsc_clock.hpp>
+#include <neolib/task/cpu_topology.hpp>
+
+namespace neolib
+{
+    namespace
+    {
+        std::string read_sysfs(std::filesystem::path const& aPath)
+        {
+            std::ifstream file{ aPath };
+            std::string result;
+            std::getline(file, result);
+            return result;
+        }
+
+        std::uint32_t read_sysfs_number(std::filesystem::path const& aPath, std::uint32_t aDefault)
+        {
+            auto const text = read_sysfs(aPath);
+            std::uint32_t result = aDefault;
+            if (!text.empty())
+                std::from_chars(text.data(), text.data() + text.size(), result);
+            return result;
+        }
+
+        std::vector<logical_cpu> flat_topology()
+        {
+            std::vector<logical_cpu> result;
+            auto const count = std::max(std::thread::hardware_concurrency(), 1u);
+            for (std::uint32_t cpu = 0u; cpu < count; ++cpu)
+                result.push_back(logical_cpu{ cpu, cpu, 0u, 0u });
+            return result;
+        }
+    }
+
+    cpu_topology::cpu_topology(std::vector<logical_cpu> aCpus) :
+        iCpus{ std::move(aCpus) }
+    {
+        if (iCpus.empty())
+            throw no_cpus();
+        std::uint32_t maxCore = 0u;
+        std::uint32_t maxNode = 0u;
+        for (auto const& cpu : iCpus)
+        {
+            maxCore = std::max(maxCore, cpu.core);
+            maxNode = std::max(maxNode, cpu.node);
+        }
+        iCoreCount = maxCore + 1u;
+        iNodeCount = maxNode + 1u;
+    }
+
+    cpu_topology const& cpu_topology::system()
+    {
+        static cpu_topology const sSystem = discover();
+        return sSystem;
+    }
+
+    cpu_topology cpu_topology::discover()
+    {
+#if defined(__linux__)
+        std::filesystem::path const root{ "/sys/devices/system/cpu" };
+        std::error_code ec;
+        auto const online = parse_cpu_list(read_sysfs(root / "online"));
+        if (online.empty() || !std::filesystem::exists(root / ("cpu" + std::to_string(online[0])) / "topology", ec))
+            return cpu_topology{ flat_topology() };
+        std::map<std::uint32_t, std::uint32_t> nodeOfCpu;
+        for (auto const& entry : std::filesystem::directory_iterator{ "/sys/devices/system/node", ec })
+        {
+            auto const name = entry.path().filename().string();
+            std::uint32_t node = 0u;
+            if (name.rfind("node", 0) != 0 || std::from_chars(name.data() + 4, name.data() + name.size(), node).ec != std::errc{})
+                continue;
+            for (auto cpu : parse_cpu_list(read_sysfs(entry.path() / "cpulist")))
+                nodeOfCpu[cpu] = node;
+        }
+        std::map<std::pair<std::uint32_t, std::uint32_t>, std::uint32_t> cores;
+        std::map<std::uint32_t, std::uint32_t> siblings;
+        std::vector<logical_cpu> result;
+        for (auto cpu : online)
+        {
+            auto const topology = root / ("cpu" + std::to_string(cpu)) / "topology";
+            auto const package = read_sysfs_number(topology / "physical_package_id", 0u);
+            auto const coreId = read_sysfs_number(topology / "core_id", cpu);
+            auto const core = cores.emplace(std::make_pair(package, coreId), static_cast<std::uint32_t>(cores.size())).first->second;
+            auto const node = nodeOfCpu.contains(cpu) ? nodeOfCpu[cpu] : 0u;
+            result.push_back(logical_cpu{ cpu, core, node, siblings[core]++ });
+        }
+        return cpu_topology{ std::move(result) };
+#else
+        return cpu_topology{ flat_topology() };
+#endif
+    }
+
+    std::vector<std::uint32_t> cpu_topology::parse_cpu_list(std::string_view aList)
+    {
+        std::vector<std::uint32_t> result;
+        while (!aList.empty())
+        {
+            auto const comma = aList.find(',');
+            auto const range = aList.substr(0, comma);
+            aList = comma == std::string_view::npos ? std::string_view{} : aList.substr(comma + 1);
+            std::uint32_t first = 0u;
+            auto const parsed = std::from_chars(range.data(), range.data() + range.size(), first);
+            if (parsed.ec != std::errc{})
+                continue;
+            std::uint32_t last = first;
+            if (parsed.ptr != range.data() + range.size() && *parsed.ptr == '-')
+                std::from_chars(parsed.ptr + 1, range.data() + range.size(), last);
+            for (auto cpu = first; cpu <= last; ++cpu)
+                result.push_back(cpu);
+        }
+        return result;
+    }
+
+    std::vector<logical_cpu> const& cpu_topology::cpus() const
+    {
+        return iCpus;
+    }
+
+    std::size_t cpu_topology::core_count() const
+    {
+        return iCoreCount;
+    }
+
+    std::size_t cpu_topology::node_count() const
+    {
+        return iNodeCount;
+    }
+
+    std::vector<logical_cpu> cpu_topology::placement() const
+    {
+        std::vector<std::vector<logical_cpu>> byNode(iNodeCount);
+        for (auto const& cpu : iCpus)
+            byNode[cpu.node].push_back(cpu);
+        for (auto& node : byNode)
+            std::stable_sort(node.begin(), node.end(), [](logical_cpu const& aLeft, logical_cpu const& aRight)
+            {
+                return std::tie(aLeft.sibling, aLeft.core) < std::tie(aRight.sibling, aRight.core);
+            });
+        std::vector<logical_cpu> result;
+        result.reserve(iCpus.size());
+        for (std::size_t rank = 0u; result.size() < iCpus.size(); ++rank)
+            for (auto const& node : byNode)
+                if (rank < node.size())
+                    result.push_back(node[rank]);
+        std::stable_sort(result.begin(), result.end(), [](logical_cpu const& aLeft, logical_cpu const& aRight)
+        {
+            return aLeft.sibling < aRight.sibling;
+        });
+        return result;
+    }
+
+    void cpu_topology::proximity_order(std::span<logical_cpu const> aPlacement, std::size_t aFrom, 
+        std::vector<std::uint32_t>& aOrder, std::array<std::size_t, 2>& aTierEnds)
+    {
+        aOrder.clear();
+        auto const& from = aPlacement[aFrom];
+        auto const tier = [&](logical_cpu const& aOther)
+        {
+            if (aOther.core == from.core)
+                return 0;
+            if (aOther.node == from.node)
+                return 1;
+            return 2;
+        };
+        for (int t = 0; t < 3; ++t)
+        {
+            for (std::size_t other = 0u; other < aPlacement.size(); ++other)
+                if (other != aFrom && tier(aPlacement[other]) == t)
+                    aOrder.push_back(static_cast<std::uint32_t>(other));
+            if (t < 2)
+                aTierEnds[static_cast<std::size_t>(t)] = aOrder.size();
+        }
+    }
+
+    bool cpu_topology::pin_this_thread(logical_cpu const& aCpu)
+    {
+        chrono::detail::PrevAffinity previous;
+#if defined(_WIN32)
+        std::vector<chrono::detail::CpuHandle> cpus;
+        if (!chrono::detail::enumerate_cpus(cpus) || aCpu.id >= cpus.size())
+            return false;
+        return chrono::detail::pin_this_thread(cpus[aCpu.id], previous);
+#else
+        chrono::detail::CpuHandle cpu;
+        cpu.cpu = static_cast<int>(aCpu.id);
+        return chrono::detail::pin_this_thread(cpu, previous);
+#endif
+    }
+}
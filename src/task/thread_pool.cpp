@@ -35,140 +35,227 @@
 
 #include <neolib/neolib.hpp>
 #include <condition_variable>
+#include <utility>
 #include <neolib/core/scoped.hpp>
 #include <neolib/core/lifetime.hpp>
 #include <neolib/task/thread.hpp>
+#include <neolib/task/work_stealing_deque.hpp>
 #include <neolib/task/thread_pool.hpp>
 
 namespace neolib
 {
+    namespace
+    {
+        thread_local thread_pool_thread* tCurrentWorker = nullptr;
+    }
+
     class thread_pool_thread : public thread
     {
     public:
         typedef std::shared_ptr<i_task> task_pointer;
-        typedef std::pair<task_pointer, int32_t> task_queue_entry;
-        typedef std::deque<task_queue_entry> task_queue;
+        typedef detail::pool_task_node task_node;
+        typedef work_stealing_deque<task_node*> task_deque;
     public:
-        struct no_active_task : std::logic_error { no_active_task() : std::logic_error("neolib::thread_pool_thread::no_active_task") {} };
-        struct already_active : std::logic_error { already_active() : std::logic_error("neolib::thread_pool_thread::already_active") {} };
-    public:
-        thread_pool_thread(thread_pool& aThreadPool) : thread{ "neolib::thread_pool_thread" }, iThreadPool{ aThreadPool }, iPoolMutex{ aThreadPool.mutex() }, iStopped{ false }
+        thread_pool_thread(thread_pool& aThreadPool, std::size_t aIndex) : 
+            thread{ "neolib::thread_pool_thread" }, 
+            iThreadPool{ aThreadPool }, 
+            iIndex{ aIndex }, 
+            iCpu{ aThreadPool.placement(aIndex) }, 
+            iRandom{ 0x9E3779B97F4A7C15ull * (aIndex + 1u) }, 
+            iInbox{ nullptr }, 
+            iActive{ false }, 
+            iStopped{ false }
         {
             start();
         }
         ~thread_pool_thread()
         {
+            while (auto node = iDeque.pop())
+                release(*node);
+            for (auto node = iInbox.exchange(nullptr); node != nullptr;)
+                release(std::exchange(node, node->next));
         }
     public:
         virtual void exec(yield_type aYieldType = yield_type::NoYield)
         {
-            while (!finished())
+            tCurrentWorker = this;
+            if (iThreadPool.pinned())
+                cpu_topology::pin_this_thread(iCpu);
+            task_pointer task;
+            while (!iStopped.load(std::memory_order_acquire))
             {
-                std::unique_lock lk(iCondVarMutex);
-                iConditionVariable.wait(lk, [this] { return iActiveTask != nullptr || iStopped; });
-                lk.unlock();
-                if (iStopped)
-                    return;
-                if (!iActiveTask->cancelled())
-                    iActiveTask->run(aYieldType);
-                std::unique_lock lk2(iPoolMutex);
-                release();
-                next_task();
+                if (!next_task(task))
+                {
+                    iThreadPool.wait_for_work(*this);
+                    continue;
+                }
+                iActive.store(true, std::memory_order_relaxed);
+                iThreadPool.execute(task, aYieldType, &iActive);
             }
         }
     public:
+        thread_pool& pool() const
+        {
+            return iThreadPool;
+        }
+        std::size_t index() const
+        {
+            return iIndex;
+        }
+        logical_cpu const& cpu() const
+        {
+            return iCpu;
+        }
+        bool local_to(thread_pool::locality const& aLocality) const
+        {
+            return (aLocality.cpu == thread_pool::locality::any || aLocality.cpu == iCpu.id) &&
+                (aLocality.node == thread_pool::locality::any || aLocality.node == iCpu.node);
+        }
         bool active() const
         {
-            std::unique_lock lk(iCondVarMutex);
-            return iActiveTask != nullptr;
+            return iActive.load(std::memory_order_relaxed);
+        }
+        bool has_work() const
+        {
+            return !iDeque.empty() || iInbox.load(std::memory_order_acquire) != nullptr;
         }
         bool idle() const
         {
-            std::unique_lock lk(iPoolMutex);
-            std::unique_lock lk2(iCondVarMutex);
-            return iActiveTask == nullptr && iWaitingTasks.empty();
+            return !active() && !has_work();
         }
-        void add(task_pointer aTask, int32_t aPriority)
+        // Owner only.
+        void push(task_node* aNode)
         {
-            std::unique_lock lk(iPoolMutex);
-            auto where = std::upper_bound(iWaitingTasks.begin(), iWaitingTasks.end(), task_queue_entry{ task_pointer{}, aPriority },
-                [](const task_queue_entry& aLeft, const task_queue_entry& aRight)
-            {
-                return aLeft.second > aRight.second;
-            });
-            iWaitingTasks.emplace(where, aTask, aPriority);
-            if (!active())
-                next_task();
+            iDeque.push(aNode);
+        }
+        // Any thread.
+        void post(task_node* aNode)
+        {
+            aNode->next = iInbox.load(std::memory_order_relaxed);
+            while (!iInbox.compare_exchange_weak(aNode->next, aNode, std::memory_order_release, std::memory_order_relaxed));
         }
-        bool steal_work(thread_pool_thread& aIdleThread)
+        // Called by aThief: takes the oldest task from this worker's deque or, failing that, its whole inbox.
+        bool steal(thread_pool_thread& aThief, task_pointer& aTask)
         {
-            std::unique_lock<std::recursive_mutex> lk(iPoolMutex);
-            if (!iWaitingTasks.empty())
+            if (auto node = iDeque.steal())
+                return take(*node, aTask);
+            return aThief.adopt(iInbox.exchange(nullptr, std::memory_order_acquire)) && aThief.pop(aTask);
+        }
+        // Called from a thread that is not a worker of this pool: takes the oldest task from this worker's
+        // deque or, failing that, the oldest task in its inbox. The rest of the inbox is spliced back with a
+        // single CAS, keeping its order; tasks posted in the meantime end up ahead of it.
+        bool steal(task_pointer& aTask)
+        {
+            if (auto node = iDeque.steal())
+                return take(*node, aTask);
+            auto list = iInbox.exchange(nullptr, std::memory_order_acquire);
+            if (list == nullptr)
+                return false;
+            task_node* oldest = list;
+            task_node* remainderTail = nullptr;
+            while (oldest->next != nullptr)
+                remainderTail = std::exchange(oldest, oldest->next);
+            if (remainderTail != nullptr)
             {
-                auto newTask = iWaitingTasks.front();
-                iWaitingTasks.pop_front();
-                aIdleThread.add(newTask.first, newTask.second);
-                return true;
+                remainderTail->next = iInbox.load(std::memory_order_relaxed);
+                while (!iInbox.compare_exchange_weak(remainderTail->next, list, std::memory_order_release, std::memory_order_relaxed));
             }
-            return false;
+            return take(oldest, aTask);
+        }
+        bool next_task(task_pointer& aTask)
+        {
+            if (iThreadPool.take_prioritised(aTask, true))
+                return true;
+            if (pop(aTask))
+                return true;
+            if (adopt(iInbox.exchange(nullptr, std::memory_order_acquire)) && pop(aTask))
+                return true;
+            if (iThreadPool.take_prioritised(aTask, false))
+                return true;
+            return iThreadPool.steal_work(*this, aTask);
+        }
+        bool stopping() const
+        {
+            return iStopped.load(std::memory_order_acquire);
+        }
+        std::uint64_t random()
+        {
+            iRandom ^= iRandom << 13u;
+            iRandom ^= iRandom >> 7u;
+            iRandom ^= iRandom << 17u;
+            return iRandom;
         }
         void stop()
         {
-            if (!iStopped)
+            if (!iStopped.exchange(true))
             {
-                {
-                    std::unique_lock lk2(iCondVarMutex);
-                    iStopped = true;
-                }
-                iConditionVariable.notify_one();
+                iThreadPool.iWorkSignal.fetch_add(1u);
+                iThreadPool.iWorkSignal.notify_all();
                 wait();
             }
         }
     private:
-        void next_task()
-        {
-            std::unique_lock<std::recursive_mutex> lk(iPoolMutex);
-            if (active())
-                throw already_active();
-            if (iWaitingTasks.empty())
-                iThreadPool.steal_work(*this);
-            if (!iWaitingTasks.empty())
-            {
-                {
-                    std::unique_lock lk2(iCondVarMutex);
-                    iActiveTask = iWaitingTasks.front().first;
-                    iWaitingTasks.pop_front();
-                }
-                iConditionVariable.notify_one();
-                iThreadPool.thread_gone_busy();
-            }
-            else
-                iThreadPool.thread_gone_idle();
+        bool pop(task_pointer& aTask)
+        {
+            if (auto node = iDeque.pop())
+                return take(*node, aTask);
+            return false;
         }
-        void release()
+        // Inbox lists are newest first; pushing them in that order leaves the oldest to be popped first.
+        bool adopt(task_node* aList)
         {
-            task_pointer currentTask;
-            {
-                std::unique_lock lk(iCondVarMutex);
-                if (iActiveTask == nullptr)
-                    throw no_active_task();
-                currentTask = iActiveTask;
-                iActiveTask = nullptr;
-            }
+            if (aList == nullptr)
+                return false;
+            while (aList != nullptr)
+                iDeque.push(std::exchange(aList, aList->next));
+            return true;
+        }
+        static bool take(task_node* aNode, task_pointer& aTask)
+        {
+            aTask = std::move(aNode->task);
+            release(aNode);
+            return true;
+        }
+        static void release(task_node* aNode)
+        {
+            if (aNode->pooled)
+                aNode->task = nullptr;
+            else
+                delete aNode;
         }
     private:
         thread_pool& iThreadPool;
-        std::recursive_mutex& iPoolMutex;
-        mutable std::mutex iCondVarMutex;
-        std::condition_variable iConditionVariable;
-        task_queue iWaitingTasks;
-        task_pointer iActiveTask;
+        std::size_t const iIndex;
+        logical_cpu const iCpu;
+        std::uint64_t iRandom;
+        task_deque iDeque;
+        std::atomic<task_node*> iInbox;
+        std::atomic<bool> iActive;
         std::atomic<bool> iStopped;
     };
 
-    thread_pool::thread_pool() : iIdle{ true }, iStopped { false }, iMaxThreads{ 0 }
+    thread_pool::thread_pool() : 
+        thread_pool{ cpu_topology::system() }
     {
-        reserve(std::thread::hardware_concurrency());
+    }
+
+    thread_pool::thread_pool(cpu_topology const& aTopology, bool aPinWorkers) : 
+        iTopology{ aTopology }, 
+        iPlacement{ aTopology.placement() }, 
+        iPinWorkers{ aPinWorkers }, 
+        iStopped{ false }, 
+        iMaxThreads{ 0 }, 
+        iWorkers{ nullptr }, 
+        iNextWorker{ 0u }, 
+        iPending{ 0u }, 
+        iWorkSignal{ 0u }, 
+        iSleepers{ 0u }, 
+        iPrioritisedCount{ 0u }, 
+        iPrioritisedSequence{ 0u }
+    {
+        iWorkerTables.push_back(std::make_unique<worker_table const>());
+        iWorkers.store(iWorkerTables.back().get(), std::memory_order_release);
+        reserve(iPlacement.size());
     }
 
     thread_pool::~thread_pool()
@@ -182,32 +269,49 @@ namespace neolib
     {
         std::unique_lock lk(iMutex);
         iMaxThreads = aMaxThreads;
+        if (iThreads.size() >= iMaxThreads)
+            return;
+        auto table = std::make_unique<worker_table>(workers());
         while (iThreads.size() < iMaxThreads)
-            iThreads.push_back(std::make_unique<thread_pool_thread>(*this));
+        {
+            auto worker = std::make_unique<thread_pool_thread>(*this, iThreads.size());
+            table->workers.push_back(worker.get());
+            iThreads.push_back(std::move(worker));
+        }
+        std::vector<logical_cpu> workerCpus;
+        for (auto worker : table->workers)
+            workerCpus.push_back(worker->cpu());
+        table->victims.resize(workerCpus.size());
+        table->victimTiers.resize(workerCpus.size());
+        table->nodeWorkers.assign(iTopology.node_count(), {});
+        for (std::size_t worker = 0u; worker < workerCpus.size(); ++worker)
+        {
+            cpu_topology::proximity_order(workerCpus, worker, table->victims[worker], table->victimTiers[worker]);
+            table->nodeWorkers[workerCpus[worker].node].push_back(static_cast<std::uint32_t>(worker));
+        }
+        iWorkers.store(table.get(), std::memory_order_release);
+        iWorkerTables.push_back(std::move(table));
     }
 
     std::size_t thread_pool::active_threads() const
     {
-        std::unique_lock lk(iMutex);
         std::size_t result = 0;
-        for (auto& t : iThreads)
-            if (static_cast<thread_pool_thread&>(*t).active())
+        for (auto worker : workers().workers)
+            if (worker->active())
                 ++result;
         return result;
     }
 
     std::size_t thread_pool::available_threads() const
     {
-        std::unique_lock lk(iMutex);
-        return max_threads() - active_threads();
+        return max_threads() - std::min(max_threads(), active_threads());
     }
 
     std::size_t thread_pool::total_threads() const
     {
-        std::unique_lock lk(iMutex);
         std::size_t result = 0;
-        for (auto& t : iThreads)
-            if (!static_cast<thread_pool_thread&>(*t).finished())
+        for (auto worker : workers().workers)
+            if (!worker->finished())
                 ++result;
         return result;
     }
@@ -217,28 +321,103 @@ namespace neolib
         return iMaxThreads;
     }
 
-    void thread_pool::start(i_task& aTask, int32_t aPriority)
+    cpu_topology const& thread_pool::topology() const
+    {
+        return iTopology;
+    }
+
+    bool thread_pool::pinned() const
     {
-        start(task_pointer{ task_pointer{}, &aTask }, aPriority);
+        return iPinWorkers;
     }
 
-    void thread_pool::start(task_pointer aTask, int32_t aPriority)
+    // Workers beyond the number of logical processors wrap around the placement order.
+    logical_cpu const& thread_pool::placement(std::size_t aWorker) const
+    {
+        return iPlacement[aWorker % iPlacement.size()];
+    }
+
+    bool thread_pool::start(i_task& aTask, int32_t aPriority)
+    {
+        return start(task_pointer{ task_pointer{}, &aTask }, aPriority);
+    }
+
+    bool thread_pool::start(task_pointer aTask, int32_t aPriority)
+    {
+        return start(std::move(aTask), locality{}, aPriority);
+    }
+
+    bool thread_pool::start(i_task& aTask, locality const& aLocality, int32_t aPriority)
+    {
+        return start(task_pointer{ task_pointer{}, &aTask }, aLocality, aPriority);
+    }
+
+    bool thread_pool::start(task_pointer aTask, locality const& aLocality, int32_t aPriority)
     {
         if (stopped())
-            return;
-        std::unique_lock lk(iMutex);
-        if (iThreads.empty())
+            return false;
+        auto const& table = workers();
+        if (table.workers.empty())
             throw no_threads();
-        for (auto& t : iThreads)
+        iPending.fetch_add(1u, std::memory_order_relaxed);
+        if (aPriority != 0)
+        {
+            std::unique_lock lk(iPrioritisedMutex);
+            prioritised_task entry{ std::move(aTask), aPriority, iPrioritisedSequence++ };
+            auto where = std::upper_bound(iPrioritised.begin(), iPrioritised.end(), entry,
+                [](const prioritised_task& aLeft, const prioritised_task& aRight)
+            {
+                return aLeft.priority > aRight.priority;
+            });
+            iPrioritised.insert(where, std::move(entry));
+            iPrioritisedCount.fetch_add(1u, std::memory_order_release);
+        }
+        else if (auto self = current_worker(); self != nullptr && self->local_to(aLocality))
+            self->push(new detail::pool_task_node{ std::move(aTask) });
+        else
+            local_worker(table, aLocality).post(new detail::pool_task_node{ std::move(aTask) });
+        work_added();
+        return true;
+    }
+
+    void thread_pool::start_bulk(detail::bulk_job& aJob, std::shared_ptr<detail::bulk_job> const& aOwner, std::size_t aParticipants, int32_t aPriority)
+    {
+        auto const& table = workers();
+        if (table.workers.empty())
+            throw no_threads();
+        aJob.nodes.resize(aParticipants);
+        for (auto& node : aJob.nodes)
         {
-            auto& tpt = static_cast<thread_pool_thread&>(*t);
-            if (!tpt.active())
+            node.task = task_pointer{ aOwner, &aJob.participants.emplace_back(aJob) };
+            node.pooled = true;
+        }
+        iPending.fetch_add(aParticipants, std::memory_order_relaxed);
+        if (aPriority != 0)
+        {
+            std::unique_lock lk(iPrioritisedMutex);
+            for (auto& node : aJob.nodes)
             {
-                tpt.add(aTask, aPriority);
-                return;
+                prioritised_task entry{ std::move(node.task), aPriority, iPrioritisedSequence++ };
+                iPrioritised.insert(std::upper_bound(iPrioritised.begin(), iPrioritised.end(), entry,
+                    [](const prioritised_task& aLeft, const prioritised_task& aRight)
+                {
+                    return aLeft.priority > aRight.priority;
+                }), std::move(entry));
             }
+            iPrioritisedCount.fetch_add(aParticipants, std::memory_order_release);
         }
-        static_cast<thread_pool_thread&>(*iThreads[0]).add(aTask, aPriority);
+        else if (auto self = current_worker())
+        {
+            for (auto& node : aJob.nodes)
+                self->push(&node);
+        }
+        else
+        {
+            auto const first = iNextWorker.fetch_add(aParticipants, std::memory_order_relaxed);
+            for (std::size_t participant = 0u; participant < aParticipants; ++participant)
+                table.workers[(first + participant) % table.workers.size()]->post(&aJob.nodes[participant]);
+        }
+        work_added(aParticipants);
     }
 
     bool thread_pool::try_start(i_task& aTask, int32_t aPriority)
@@ -247,8 +426,7 @@ namespace neolib
             return false;
         if (available_threads() == 0)
             return false;
-        start(aTask, aPriority);
-        return true;
+        return start(aTask, aPriority);
     }
 
     bool thread_pool::try_start(task_pointer aTask, int32_t aPriority)
@@ -257,39 +435,36 @@ namespace neolib
             return false;
         if (available_threads() == 0)
             return false;
-        start(aTask, aPriority);
-        return true;
+        return start(aTask, aPriority);
     }
 
     std::pair<std::future<void>, thread_pool::task_pointer> thread_pool::run(std::function<void()> aFunction, int32_t aPriority)
+    {
+        return run(std::move(aFunction), locality{}, aPriority);
+    }
+
+    std::pair<std::future<void>, thread_pool::task_pointer> thread_pool::run(std::function<void()> aFunction, locality const& aLocality, int32_t aPriority)
     {
         if (stopped())
             return {};
         auto newTask = std::make_shared<function_task<void>>(aFunction);
-        start(newTask, aPriority);
+        if (!start(newTask, aLocality, aPriority))
+            return {};
         return std::make_pair(newTask->get_future(), newTask);
     }
 
     bool thread_pool::idle() const
     {
-        return iIdle;
+        return iPending.load(std::memory_order_acquire) == 0u;
     }
 
     void thread_pool::update_idle()
     {
-        std::unique_lock lk1(iMutex);
-        std::optional<std::unique_lock<std::mutex>> lk2;
-        for (auto& t : iThreads)
+        if (idle())
         {
-            if (!static_cast<thread_pool_thread&>(*t).idle())
-            {
-                lk2.emplace(iWaitMutex);
-                iIdle = false;
-                return;
-            }
+            std::unique_lock lk(iWaitMutex);
+            iWaitConditionVariable.notify_all();
         }
-        lk2.emplace(iWaitMutex);
-        iIdle = true;
     }
 
     bool thread_pool::busy() const
@@ -322,7 +497,7 @@ namespace neolib
                 std::unique_lock lk(iWaitMutex);
                 iStopped = true;
             }
-            iWaitConditionVariable.notify_one();
+            iWaitConditionVariable.notify_all();
         }
     }
 
@@ -337,29 +512,159 @@ namespace neolib
         return iMutex;
     }
 
-    void thread_pool::steal_work(thread_pool_thread& aIdleThread)
+    thread_pool::worker_table const& thread_pool::workers() const
     {
-        std::unique_lock lk(iMutex);
-        if (iThreads.empty())
-            throw no_threads();
-        for (auto& t : iThreads)
+        return *iWorkers.load(std::memory_order_acquire);
+    }
+
+    thread_pool_thread* thread_pool::current_worker() const
+    {
+        if (tCurrentWorker != nullptr && &tCurrentWorker->pool() == this)
+            return tCurrentWorker;
+        return nullptr;
+    }
+
+    // Round robin over the workers matching aLocality, or over all workers if none match.
+    thread_pool_thread& thread_pool::local_worker(worker_table const& aTable, locality const& aLocality)
+    {
+        auto const next = iNextWorker.fetch_add(1u, std::memory_order_relaxed);
+        if (aLocality.cpu == locality::any && aLocality.node < aTable.nodeWorkers.size() && !aTable.nodeWorkers[aLocality.node].empty())
         {
-            if (&*t == &aIdleThread)
-                continue;
-            auto& tpt = static_cast<thread_pool_thread&>(*t);
-            if (tpt.steal_work(aIdleThread))
-                return;
+            auto const& nodeWorkers = aTable.nodeWorkers[aLocality.node];
+            return *aTable.workers[nodeWorkers[next % nodeWorkers.size()]];
         }
+        if (aLocality.cpu != locality::any)
+            for (std::size_t offset = 0u; offset < aTable.workers.size(); ++offset)
+            {
+                auto worker = aTable.workers[(next + offset) % aTable.workers.size()];
+                if (worker->local_to(aLocality))
+                    return *worker;
+            }
+        return *aTable.workers[next % aTable.workers.size()];
+    }
+
+    bool thread_pool::take_prioritised(task_pointer& aTask, bool aUrgentOnly)
+    {
+        if (iPrioritisedCount.load(std::memory_order_acquire) == 0u)
+            return false;
+        std::unique_lock lk(iPrioritisedMutex);
+        if (iPrioritised.empty() || (aUrgentOnly && iPrioritised.front().priority <= 0))
+            return false;
+        aTask = std::move(iPrioritised.front().task);
+        iPrioritised.erase(iPrioritised.begin());
+        iPrioritisedCount.fetch_sub(1u, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool thread_pool::steal_work(thread_pool_thread& aThief, task_pointer& aTask)
+    {
+        auto const& table = workers();
+        auto const count = table.workers.size();
+        if (count < 2u)
+            return false;
+        if (aThief.index() < table.victims.size())
+        {
+            auto const& victims = table.victims[aThief.index()];
+            auto const& tiers = table.victimTiers[aThief.index()];
+            std::size_t tierBegin = 0u;
+            for (auto tierEnd : { tiers[0], tiers[1], victims.size() })
+            {
+                auto const tierSize = tierEnd - tierBegin;
+                if (tierSize != 0u)
+                {
+                    auto const first = static_cast<std::size_t>(aThief.random() % tierSize);
+                    for (std::size_t offset = 0u; offset < tierSize; ++offset)
+                        if (table.workers[victims[tierBegin + (first + offset) % tierSize]]->steal(aThief, aTask))
+                            return true;
+                }
+                tierBegin = tierEnd;
+            }
+            return false;
+        }
+        auto const first = static_cast<std::size_t>(aThief.random() % count);
+        for (std::size_t offset = 0u; offset < count; ++offset)
+        {
+            auto victim = table.workers[(first + offset) % count];
+            if (victim != &aThief && victim->steal(aThief, aTask))
+                return true;
+        }
+        return false;
+    }
+
+    bool thread_pool::help()
+    {
+        task_pointer task;
+        if (auto self = current_worker())
+        {
+            if (!self->next_task(task))
+                return false;
+        }
+        else if (!take_prioritised(task, false))
+        {
+            auto const& table = workers();
+            auto const first = iNextWorker.load(std::memory_order_relaxed);
+            bool found = false;
+            for (std::size_t offset = 0u; !found && offset < table.workers.size(); ++offset)
+                found = table.workers[(first + offset) % table.workers.size()]->steal(task);
+            if (!found)
+                return false;
+        }
+        execute(task, yield_type::NoYield, nullptr);
+        return true;
+    }
+
+    // A worker's active flag is cleared before the task is counted as completed so that the pool is
+    // never seen idle with an active thread.
+    void thread_pool::execute(task_pointer& aTask, yield_type aYieldType, std::atomic<bool>* aActive)
+    {
+        auto const finished = [&]()
+        {
+            aTask = nullptr;
+            if (aActive != nullptr)
+                aActive->store(false, std::memory_order_release);
+            task_completed();
+        };
+        try
+        {
+            if (!aTask->cancelled())
+                aTask->run(aYieldType);
+        }
+        catch (...)
+        {
+            finished();
+            throw;
+        }
+        finished();
+    }
+
+    void thread_pool::work_added(std::size_t aCount)
+    {
+        iWorkSignal.fetch_add(1u);
+        if (iSleepers.load() == 0u)
+            return;
+        if (aCount == 1u)
+            iWorkSignal.notify_one();
+        else
+            iWorkSignal.notify_all();
     }
 
-    void thread_pool::thread_gone_idle()
+    void thread_pool::task_completed()
     {
-        update_idle();
-        iWaitConditionVariable.notify_one();
+        if (iPending.fetch_sub(1u, std::memory_order_acq_rel) == 1u)
+            update_idle();
     }
 
-    void thread_pool::thread_gone_busy()
+    // A worker announces itself as a sleeper before sampling the work signal and checking for work so
+    // that a task added after the check always advances the signal it waits on.
+    void thread_pool::wait_for_work(thread_pool_thread& aIdleThread)
     {
-        update_idle();
+        iSleepers.fetch_add(1u);
+        auto const signal = iWorkSignal.load();
+        bool haveWork = iPrioritisedCount.load() != 0u;
+        for (auto worker : workers().workers)
+            haveWork = haveWork || worker->has_work();
+        if (!haveWork && !aIdleThread.stopping())
+            iWorkSignal.wait(signal);
+        iSleepers.fetch_sub(1u);
     }
 }
@@ -0,0 +1,1339 @@
+#include <iostream>
+#include <stdexcept>
+#include <source_location>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include <neolib/task/async_task.hpp>
+#include <neolib/task/async_thread.hpp>
+#include <neolib/ecs/ecs.hpp>
+#include <neolib/ecs/entity_archetype.hpp>
+#include <neolib/ecs/entity_info.hpp>
+#include <neolib/ecs/archetype_storage.hpp>
+#include <neolib/ecs/system_scheduler.hpp>
+#include <neolib/ecs/view.hpp>
+#include <neolib/ecs/spatial_index.hpp>
+#include <neolib/ecs/command_buffer.hpp>
+#include <neolib/ecs/time.hpp>
+#include <neolib/ecs/soa_mirror.hpp>
+#include <neolib/core/timing_wheel.hpp>
+
+template<> neolib::i_async_task& neolib::services::start_service<neolib::i_async_task>()
+{
+    static neolib::async_task mainTask;
+    static neolib::async_thread mainThread{ mainTask, "neolib::ecs unit test(s)", true };
+    return mainTask;
+}
+
+namespace
+{
+    void test_assert(bool assertion, std::source_location const& location = std::source_location::current())
+    {
+        if (!assertion)
+            throw std::logic_error("Test failed at " + std::string{ location.file_name() } + ":" + std::to_string(location.line()));
+    }
+
+    struct position
+    {
+        neolib::vec3 value;
+
+        struct meta : neolib::ecs::i_component_data::meta
+        {
+            static const neolib::uuid& id()
+            {
+                static const neolib::uuid sId = { 0x3c6f1a52, 0x8e2d, 0x4a41, 0x9b27, { 0x51, 0x0e, 0x6c, 0x9d, 0x2a, 0x11 } };
+                return sId;
+            }
+            static const neolib::i_string& name()
+            {
+                static const neolib::string sName = "Position";
+                return sName;
+            }
+            static uint32_t field_count()
+            {
+                return 1;
+            }
+            static neolib::ecs::component_data_field_type field_type(uint32_t aFieldIndex)
+            {
+                switch (aFieldIndex)
+                {
+                case 0:
+                    return neolib::ecs::component_data_field_type::Vec3;
+                default:
+                    throw invalid_field_index();
+                }
+            }
+            static const neolib::i_string& field_name(uint32_t aFieldIndex)
+            {
+                static const neolib::string sFieldNames[] =
+                {
+                    "Value"
+                };
+                return sFieldNames[aFieldIndex];
+            }
+        };
+    };
+
+    struct velocity
+    {
+        neolib::vec3 value;
+
+        struct meta : neolib::ecs::i_component_data::meta
+        {
+            static const neolib::uuid& id()
+            {
+                static const neolib::uuid sId = { 0x7d2b9e04, 0x16c3, 0x4f5e, 0x8a90, { 0x2f, 0x4b, 0x7e, 0x13, 0xc6, 0x58 } };
+                return sId;
+            }
+            static const neolib::i_string& name()
+            {
+                static const neolib::string sName = "Velocity";
+                return sName;
+            }
+            static uint32_t field_count()
+            {
+                return 1;
+            }
+            static neolib::ecs::component_data_field_type field_type(uint32_t aFieldIndex)
+            {
+                switch (aFieldIndex)
+                {
+                case 0:
+                    return neolib::ecs::component_data_field_type::Vec3;
+                default:
+                    throw invalid_field_index();
+                }
+            }
+            static const neolib::i_string& field_name(uint32_t aFieldIndex)
+            {
+                static const neolib::string sFieldNames[] =
+                {
+                    "Value"
+                };
+                return sFieldNames[aFieldIndex];
+            }
+        };
+    };
+
+    struct heat
+    {
+        double value;
+
+        struct meta : neolib::ecs::i_component_data::meta
+        {
+            static const neolib::uuid& id()
+            {
+                static const neolib::uuid sId = { 0x5a0e7c31, 0x2b94, 0x4d1f, 0xa6c2, { 0x83, 0x1d, 0x4e, 0x97, 0x0b, 0x6a } };
+                return sId;
+            }
+            static const neolib::i_string& name()
+            {
+                static const neolib::string sName = "Heat";
+                return sName;
+            }
+            static uint32_t field_count()
+            {
+                return 1;
+            }
+            static neolib::ecs::component_data_field_type field_type(uint32_t aFieldIndex)
+            {
+                switch (aFieldIndex)
+                {
+                case 0:
+                    return neolib::ecs::component_data_field_type::Scalar;
+                default:
+                    throw invalid_field_index();
+                }
+            }
+            static const neolib::i_string& field_name(uint32_t aFieldIndex)
+            {
+                static const neolib::string sFieldNames[] =
+                {
+                    "Value"
+                };
+                return sFieldNames[aFieldIndex];
+            }
+        };
+    };
+
+    struct spin
+    {
+        std::int32_t value;
+
+        struct meta : neolib::ecs::i_component_data::meta
+        {
+            static const neolib::uuid& id()
+            {
+                static const neolib::uuid sId = { 0x1f6b2d88, 0x7c05, 0x4e3a, 0x9d41, { 0x6e, 0x2c, 0xb8, 0x15, 0x73, 0xf0 } };
+                return sId;
+            }
+            static const neolib::i_string& name()
+            {
+                static const neolib::string sName = "Spin";
+                return sName;
+            }
+            static uint32_t field_count()
+            {
+                return 1;
+            }
+            static neolib::ecs::component_data_field_type field_type(uint32_t aFieldIndex)
+            {
+                switch (aFieldIndex)
+                {
+                case 0:
+                    return neolib::ecs::component_data_field_type::Int32;
+                default:
+                    throw invalid_field_index();
+                }
+            }
+            static const neolib::i_string& field_name(uint32_t aFieldIndex)
+            {
+                static const neolib::string sFieldNames[] =
+                {
+                    "Value"
+                };
+                return sFieldNames[aFieldIndex];
+            }
+        };
+    };
+
+    template <typename Derived, typename... ComponentData>
+    class test_system : public neolib::ecs::system<ComponentData...>
+    {
+    public:
+        test_system(neolib::ecs::i_ecs& aEcs) :
+            neolib::ecs::system<ComponentData...>{ aEcs }
+        {
+        }
+    public:
+        const neolib::ecs::system_id& id() const override
+        {
+            return Derived::meta::id();
+        }
+        const neolib::i_string& name() const override
+        {
+            return Derived::meta::name();
+        }
+    public:
+        std::atomic<int> applied = 0;
+    };
+
+    class integrator : public test_system<integrator, position, const velocity>
+    {
+    public:
+        using test_system::test_system;
+    public:
+        bool apply() override
+        {
+            neolib::ecs::scoped_component_data_lock<position, velocity> lock{ ecs() };
+            auto& positions = ecs().component<position>();
+            auto const& velocities = ecs().component<velocity>();
+            for (auto entity : positions.entities())
+                positions.entity_record_no_lock(entity).value += velocities.entity_record_no_lock(entity).value;
+            ++applied;
+            return true;
+        }
+    public:
+        struct meta
+        {
+            static const neolib::uuid& id()
+            {
+                static const neolib::uuid sId = { 0x0b7f3d6e, 0x3c1a, 0x4d2b, 0x8f40, { 0x6a, 0x1d, 0x93, 0x27, 0xe5, 0x0c } };
+                return sId;
+            }
+            static const neolib::i_string& name()
+            {
+                static const neolib::string sName = "Integrator";
+                return sName;
+            }
+        };
+    };
+
+    class velocity_reader : public test_system<velocity_reader, const velocity>
+    {
+    public:
+        using test_system::test_system;
+    public:
+        bool apply() override
+        {
+            ++applied;
+            return true;
+        }
+    public:
+        struct meta
+        {
+            static const neolib::uuid& id()
+            {
+                static const neolib::uuid sId = { 0x58e21c97, 0x7a04, 0x4b6f, 0x9d13, { 0x2c, 0x88, 0x41, 0xf0, 0x6b, 0x3e } };
+                return sId;
+            }
+            static const neolib::i_string& name()
+            {
+                static const neolib::string sName = "Velocity Reader";
+                return sName;
+            }
+        };
+    };
+
+    class damper : public test_system<damper, velocity>
+    {
+    public:
+        using test_system::test_system;
+    public:
+        bool apply() override
+        {
+            test_assert(ecs().system<integrator>().applied == applied + 1);
+            ecs().component<velocity>().apply([](auto&, velocity& v) { v.value *= 0.5; });
+            ++applied;
+            return true;
+        }
+    public:
+        struct meta
+        {
+            static const neolib::uuid& id()
+            {
+                static const neolib::uuid sId = { 0xc4a9056b, 0x2e7d, 0x4c83, 0xa1f6, { 0x9b, 0x30, 0x5e, 0x72, 0x0d, 0xa4 } };
+                return sId;
+            }
+            static const neolib::i_string& name()
+            {
+                static const neolib::string sName = "Damper";
+                return sName;
+            }
+        };
+    };
+
+    struct bounds
+    {
+        neolib::aabb box;
+
+        struct meta : neolib::ecs::i_component_data::meta
+        {
+            static const neolib::uuid& id()
+            {
+                static const neolib::uuid sId = { 0x5e81c7d3, 0x42b9, 0x4d10, 0xb6e2, { 0x7a, 0x19, 0xc4, 0x03, 0x8f, 0x6d } };
+                return sId;
+            }
+            static const neolib::i_string& name()
+            {
+                static const neolib::string sName = "Bounds";
+                return sName;
+            }
+            static uint32_t field_count()
+            {
+                return 1;
+            }
+            static neolib::ecs::component_data_field_type field_type(uint32_t aFieldIndex)
+            {
+                switch (aFieldIndex)
+                {
+                case 0:
+                    return neolib::ecs::component_data_field_type::Aabb;
+                default:
+                    throw invalid_field_index();
+                }
+            }
+            static const neolib::i_string& field_name(uint32_t aFieldIndex)
+            {
+                static const neolib::string sFieldNames[] =
+                {
+                    "Box"
+                };
+                return sFieldNames[aFieldIndex];
+            }
+        };
+    };
+
+    struct material
+    {
+        double shininess;
+
+        struct meta : neolib::ecs::i_component_data::meta
+        {
+            static const neolib::uuid& id()
+            {
+                static const neolib::uuid sId = { 0x6b0e93d4, 0x21c7, 0x4f5a, 0xa3d8, { 0x7e, 0x14, 0x9c, 0x02, 0x5b, 0xe6 } };
+                return sId;
+            }
+            static const neolib::i_string& name()
+            {
+                static const neolib::string sName = "Material";
+                return sName;
+            }
+            static uint32_t field_count()
+            {
+                return 1;
+            }
+            static neolib::ecs::component_data_field_type field_type(uint32_t aFieldIndex)
+            {
+                switch (aFieldIndex)
+                {
+                case 0:
+                    return neolib::ecs::component_data_field_type::Scalar;
+                default:
+                    throw invalid_field_index();
+                }
+            }
+            static const neolib::i_string& field_name(uint32_t aFieldIndex)
+            {
+                static const neolib::string sFieldNames[] =
+                {
+                    "Shininess"
+                };
+                return sFieldNames[aFieldIndex];
+            }
+        };
+    };
+
+    neolib::ecs::entity_archetype const& particle_archetype()
+    {
+        static neolib::ecs::entity_archetype const sArchetype{ "Particle", { position::meta::id(), velocity::meta::id() } };
+        return sArchetype;
+    }
+
+    neolib::ecs::entity_archetype const& body_archetype()
+    {
+        static neolib::ecs::entity_archetype const sArchetype{ "Body", { position::meta::id() } };
+        return sArchetype;
+    }
+
+    neolib::ecs::entity_archetype const& collider_archetype()
+    {
+        static neolib::ecs::entity_archetype const sArchetype{ "Collider", { bounds::meta::id() } };
+        return sArchetype;
+    }
+
+    void test_archetype_storage()
+    {
+        neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        neolib::ecs::basic_archetype_storage<1024u, position, velocity> storage{ world, particle_archetype() };
+
+        std::vector<neolib::ecs::entity_id> entities;
+        for (int i = 0; i < 1000; ++i)
+            entities.push_back(storage.create_entity(position{ { i * 1.0, 0.0, 0.0 } }, velocity{ { 1.0, 2.0, 3.0 } }));
+        test_assert(storage.size() == 1000u);
+        test_assert(storage.chunk_count() == (1000u + decltype(storage)::chunk_capacity - 1u) / decltype(storage)::chunk_capacity);
+
+        storage.apply([](neolib::ecs::entity_id, position& p, velocity const& v) { p.value += v.value; });
+        test_assert(storage.entity_record<position>(entities[10]).value == neolib::vec3{ 11.0, 2.0, 3.0 });
+
+        for (std::size_t i = 0; i < entities.size(); i += 2)
+            world.destroy_entity(entities[i]);
+        test_assert(storage.size() == 500u);
+        for (std::size_t i = 0; i < entities.size(); ++i)
+            test_assert(storage.has_entity_record(entities[i]) == (i % 2 == 1));
+        test_assert(storage.entity_record<position>(entities[11]).value == neolib::vec3{ 12.0, 2.0, 3.0 });
+
+        std::size_t rows = 0u;
+        storage.apply_chunks([&](auto const& aChunk)
+        {
+            for (auto e : aChunk.entities())
+                test_assert(storage.has_entity_record_no_lock(e));
+            rows += aChunk.template column<velocity>().size();
+        });
+        test_assert(rows == storage.size());
+    }
+
+    void test_system_scheduler()
+    {
+        neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        auto const entity = world.create_entity(particle_archetype(), position{ { 0.0, 0.0, 0.0 } }, velocity{ { 8.0, 0.0, 0.0 } });
+
+        auto& first = world.system<integrator>();
+        auto& second = world.system<velocity_reader>();
+        auto& third = world.system<damper>();
+        test_assert(first.access(velocity::meta::id()) == neolib::ecs::component_access::ReadOnly);
+        test_assert(first.access(position::meta::id()) == neolib::ecs::component_access::ReadWrite);
+        test_assert(!neolib::ecs::system_scheduler::conflicts(first, second));
+        test_assert(neolib::ecs::system_scheduler::conflicts(first, third));
+        test_assert(neolib::ecs::system_scheduler::conflicts(second, third));
+
+        neolib::ecs::system_scheduler scheduler{ world };
+        scheduler.add(first);
+        scheduler.add(second);
+        scheduler.add(third);
+        for (int frame = 0; frame < 3; ++frame)
+            scheduler.run_frame();
+        test_assert(scheduler.frame_batches() == 2u);
+        test_assert(first.applied == 3 && second.applied == 3 && third.applied == 3);
+        test_assert(world.component<position>().entity_record(entity).value == neolib::vec3{ 14.0, 0.0, 0.0 });
+
+        neolib::ecs::ecs stoppedWorld{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        stoppedWorld.create_entity(particle_archetype(), position{}, velocity{ { 1.0, 0.0, 0.0 } });
+        neolib::ecs::system_scheduler stoppedScheduler{ stoppedWorld };
+        stoppedScheduler.add(stoppedWorld.system<integrator>());
+        stoppedScheduler.add(stoppedWorld.system<velocity_reader>());
+        stoppedScheduler.add(stoppedWorld.system<damper>());
+        stoppedWorld.thread_pool().stop();
+        stoppedScheduler.run_frame();
+        test_assert(stoppedWorld.system<integrator>().applied == 1 && stoppedWorld.system<damper>().applied == 1);
+    }
+
+    void test_view()
+    {
+        neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        std::vector<neolib::ecs::entity_id> particles;
+        for (int i = 0; i < 5000; ++i)
+        {
+            world.create_entity(body_archetype(), position{ { 0.0, 0.0, 0.0 } });
+            if (i % 5 == 0)
+                particles.push_back(world.create_entity(particle_archetype(), position{ { 0.0, 0.0, 0.0 } }, velocity{ { 1.0, 0.0, 0.0 } }));
+        }
+
+        neolib::ecs::view<position, const velocity> particleView{ world };
+        test_assert(particleView.size_hint_no_lock() == particles.size());
+        test_assert(particleView.driver_no_lock() == 1u);
+
+        std::size_t visited = 0u;
+        particleView.for_each([&](neolib::ecs::entity_id, position& p, velocity const& v) { p.value += v.value; ++visited; });
+        test_assert(visited == particles.size());
+
+        std::atomic<std::size_t> parallelVisited = 0u;
+        particleView.parallel_for_each([&](neolib::ecs::entity_id, position& p, velocity const& v) { p.value += v.value; ++parallelVisited; }, 16u);
+        test_assert(parallelVisited == particles.size());
+        for (auto e : particles)
+            test_assert(world.component<position>().entity_record(e).value == neolib::vec3{ 2.0, 0.0, 0.0 });
+
+        std::size_t positions = 0u;
+        neolib::ecs::view<const position>{ world }.for_each([&](neolib::ecs::entity_id, position const&) { ++positions; });
+        test_assert(positions == 5000u + particles.size());
+    }
+
+    void test_snapshot()
+    {
+        neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        std::vector<neolib::ecs::entity_id> bodies;
+        for (int i = 0; i < 5000; ++i)
+            bodies.push_back(world.create_entity(body_archetype(), position{ { i * 1.0, 0.0, 0.0 } }));
+        auto& positions = world.component<position>();
+        typedef std::remove_reference_t<decltype(positions)>::snapshot_type snapshot_type;
+        test_assert(!positions.have_snapshot());
+
+        positions.take_snapshot();
+        auto const first = positions.snapshot();
+        test_assert(first.data().size() == 5000u);
+        test_assert(first.data().pages().size() == (5000u + snapshot_type::page_size - 1u) / snapshot_type::page_size);
+
+        positions.entity_record(bodies[42]).value.x = -1.0;
+        positions.take_snapshot();
+        auto const second = positions.snapshot();
+        test_assert(second.data().version() > first.data().version());
+        test_assert(first.data().entity_record(bodies[42]).value.x == 42.0);
+        test_assert(second.data().entity_record(bodies[42]).value.x == -1.0);
+        for (std::size_t pageIndex = 0u; pageIndex < second.data().pages().size(); ++pageIndex)
+            test_assert((first.data().pages()[pageIndex] == second.data().pages()[pageIndex]) == (pageIndex != 42u / snapshot_type::page_size));
+        test_assert(first.data().index_pages() == second.data().index_pages());
+
+        world.destroy_entity(bodies[0]);
+        test_assert(positions.snapshot().ptr() == second.ptr());
+        test_assert(!second.data().has_entity_record(bodies[0]) && second.data().size() == 4999u);
+        std::size_t secondRecords = 0u;
+        second.data().for_each([&](neolib::ecs::entity_id aEntity, position const&) { test_assert(aEntity != bodies[0]); ++secondRecords; });
+        test_assert(secondRecords == 4999u);
+        test_assert(second.data().extent() == 5000u && !second.data().live(0u) && second.data().live(4999u));
+        std::size_t liveIndices = 0u;
+        for (std::size_t index = 0u; index < second.data().extent(); ++index)
+            if (second.data().live(index))
+            {
+                test_assert(second.data().entity(index) != bodies[0] && second.data().entity_record_no_lock(second.data().entity(index)).value == second.data()[index].value);
+                ++liveIndices;
+            }
+        test_assert(liveIndices == second.data().size());
+        test_assert(first.data().has_entity_record(bodies[0]));
+        positions.take_snapshot();
+        auto const third = positions.snapshot();
+        test_assert(third.data().size() == 4999u && !third.data().has_entity_record(bodies[0]));
+        test_assert(third.data().entity_record(bodies.back()).value.x == 4999.0);
+        std::size_t records = 0u;
+        third.data().for_each([&](neolib::ecs::entity_id aEntity, position const& aPosition) { test_assert(positions.entity_record(aEntity).value == aPosition.value); ++records; });
+        test_assert(records == 4999u);
+    }
+
+    void test_bulk_entities()
+    {
+        neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        std::size_t createdEvents = 0u;
+        std::size_t destroyedEvents = 0u;
+        std::size_t entityCreatedEvents = 0u;
+        std::size_t entityDestroyedEvents = 0u;
+        neolib::sink sink;
+        sink += world.entity_created([&](neolib::ecs::entity_id) { ++entityCreatedEvents; });
+        sink += world.entity_destroyed([&](neolib::ecs::entity_id) { ++entityDestroyedEvents; });
+        sink += world.entities_created([&](std::span<neolib::ecs::entity_id const>) { ++createdEvents; });
+        sink += world.entities_destroyed([&](std::span<neolib::ecs::entity_id const>) { ++destroyedEvents; });
+
+        auto const particles = world.create_entities(particle_archetype(), 3000u, position{ { 1.0, 0.0, 0.0 } }, velocity{ { 0.0, 1.0, 0.0 } });
+        test_assert(particles.size() == 3000u && createdEvents == 1u);
+        test_assert(world.component<position>().entity_record(particles[1234]).value == neolib::vec3{ 1.0, 0.0, 0.0 });
+        test_assert(world.component<neolib::ecs::entity_info>().entity_record(particles[1234]).archetypeId == particle_archetype().id());
+
+        std::vector<position> positions;
+        for (int i = 0; i < 100; ++i)
+            positions.push_back(position{ { i * 1.0, 0.0, 0.0 } });
+        auto const bodies = world.create_entities(body_archetype(), positions);
+        test_assert(bodies.size() == 100u && createdEvents == 2u && entityCreatedEvents == 3100u);
+        test_assert(world.component<position>().entity_record(bodies[99]).value == neolib::vec3{ 99.0, 0.0, 0.0 });
+        test_assert(!world.component<velocity>().has_entity_record(bodies[0]));
+
+        std::vector<neolib::ecs::entity_id> doomed;
+        for (std::size_t i = 0; i < particles.size(); i += 3)
+            doomed.push_back(particles[i]);
+        doomed.insert(doomed.end(), bodies.begin(), bodies.begin() + 50);
+        world.destroy_entities(doomed);
+        test_assert(destroyedEvents == 1u && entityDestroyedEvents == doomed.size());
+        test_assert(world.component<position>().entities().size() == 3000u - 1000u + 50u);
+        test_assert(world.component<velocity>().entities().size() == 2000u);
+        for (std::size_t i = 0; i < particles.size(); ++i)
+            test_assert(world.component<velocity>().has_entity_record(particles[i]) == (i % 3 != 0));
+        test_assert(world.component<position>().entity_record(bodies[75]).value == neolib::vec3{ 75.0, 0.0, 0.0 });
+
+        struct drifting_archetype : neolib::ecs::entity_archetype
+        {
+            using entity_archetype::entity_archetype;
+            using entity_archetype::populate_default_components;
+            void populate_default_components(neolib::ecs::i_ecs& aEcs, std::span<neolib::ecs::entity_id const> aEntities) override
+            {
+                ++batches;
+                auto& velocities = aEcs.component<velocity>();
+                std::vector<neolib::ecs::entity_id> missing;
+                for (auto entity : aEntities)
+                    if (!velocities.has_entity_record(entity))
+                        missing.push_back(entity);
+                velocities.populate(missing, velocity{ { 0.0, 0.0, 1.0 } });
+            }
+            std::size_t batches = 0u;
+        };
+        drifting_archetype drifting{ "Drifting", { position::meta::id(), velocity::meta::id() } };
+        neolib::ecs::ecs defaults{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        auto const drifters = defaults.create_entities(drifting, 500u, position{});
+        test_assert(drifting.batches == 1u && defaults.component<velocity>().entities().size() == 500u);
+        test_assert(defaults.component<velocity>().entity_record(drifters[499]).value == neolib::vec3{ 0.0, 0.0, 1.0 });
+        defaults.create_entity(drifting, position{});
+        test_assert(drifting.batches == 2u && defaults.component<velocity>().entities().size() == 501u);
+
+        struct falling_archetype : neolib::ecs::entity_archetype
+        {
+            using entity_archetype::entity_archetype;
+            using entity_archetype::populate_default_components;
+            void populate_default_components(neolib::ecs::i_ecs& aEcs, neolib::ecs::entity_id aEntity) override
+            {
+                if (!aEcs.component<velocity>().has_entity_record(aEntity))
+                    aEcs.populate(aEntity, velocity{ { 0.0, -1.0, 0.0 } });
+            }
+        };
+        falling_archetype falling{ "Falling", { position::meta::id(), velocity::meta::id() } };
+        auto const fallers = defaults.create_entities(falling, 10u, position{});
+        test_assert(defaults.component<velocity>().entities().size() == 511u);
+        test_assert(defaults.component<velocity>().entity_record(fallers[9]).value == neolib::vec3{ 0.0, -1.0, 0.0 });
+    }
+
+    void test_component_signature()
+    {
+        neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        auto const particle = world.create_entity(particle_archetype(), position{}, velocity{});
+        auto const body = world.create_entity(body_archetype(), position{});
+        auto const particleSignature = world.signature_of<position, velocity>();
+        test_assert(particleSignature.count() == 2u);
+        test_assert(world.signature(particle).includes(particleSignature));
+        test_assert(world.matches(particle, particleSignature) && !world.matches(body, particleSignature));
+        test_assert(world.has_component<velocity>(particle) && !world.has_component<velocity>(body));
+        test_assert(world.has_component<neolib::ecs::entity_info>(body));
+
+        std::vector<neolib::ecs::entity_id> matching;
+        world.entities_matching(particleSignature, matching);
+        test_assert(matching == std::vector<neolib::ecs::entity_id>{ particle });
+
+        neolib::ecs::component_signature wide;
+        wide.set(130u).set(3u);
+        test_assert(wide.test(130u) && wide.test(3u) && !wide.test(64u) && wide.count() == 2u);
+        std::vector<neolib::ecs::component_ordinal> ordinals;
+        wide.for_each([&](neolib::ecs::component_ordinal aOrdinal) { ordinals.push_back(aOrdinal); });
+        test_assert(ordinals == std::vector<neolib::ecs::component_ordinal>{ 3u, 130u });
+
+        world.component<velocity>().destroy_entity_record(particle);
+        test_assert(!world.has_component<velocity>(particle) && world.has_component<position>(particle));
+        world.destroy_entity(particle);
+        test_assert(world.signature(particle).empty());
+        test_assert(!world.component<position>().has_entity_record(particle));
+        test_assert(world.component<position>().has_entity_record(body));
+    }
+
+    void test_generational_ids()
+    {
+        neolib::ecs::generational_id_allocator<neolib::ecs::entity_id, 64u> allocator;
+        std::vector<std::vector<neolib::ecs::entity_id>> allocated(4u);
+        std::vector<std::thread> threads;
+        for (auto& ids : allocated)
+            threads.emplace_back([&]()
+            {
+                for (int i = 0; i < 2000; ++i)
+                {
+                    ids.push_back(allocator.allocate());
+                    if (i % 2 == 1)
+                    {
+                        allocator.free(ids.back());
+                        ids.pop_back();
+                    }
+                }
+            });
+        for (auto& t : threads)
+            t.join();
+        std::vector<neolib::ecs::entity_id> all;
+        for (auto const& ids : allocated)
+            all.insert(all.end(), ids.begin(), ids.end());
+        std::sort(all.begin(), all.end());
+        test_assert(all.size() == 4000u && std::adjacent_find(all.begin(), all.end()) == all.end());
+        for (auto id : all)
+            test_assert(allocator.alive(id));
+
+        neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        auto const first = world.create_entity(body_archetype(), position{});
+        auto const firstRef = world.to_ref(first);
+        test_assert(world.valid(firstRef) && world.resolve(firstRef) == first);
+        world.destroy_entity(first);
+        test_assert(!world.valid(firstRef));
+        auto const second = world.create_entity(body_archetype(), position{});
+        test_assert(second == first && world.to_ref(second) != firstRef);
+        bool stale = false;
+        try
+        {
+            world.resolve(firstRef);
+        }
+        catch (neolib::ecs::i_ecs::stale_entity_ref const&)
+        {
+            stale = true;
+        }
+        test_assert(stale);
+        test_assert(!world.component<position>().has_entity_record(firstRef) && world.component<position>().has_entity_record(world.to_ref(second)));
+        stale = false;
+        try
+        {
+            world.component<position>().entity_record(firstRef);
+        }
+        catch (neolib::ecs::i_ecs::stale_entity_ref const&)
+        {
+            stale = true;
+        }
+        test_assert(stale);
+
+        world.destroy_entity(second);
+        world.destroy_entity(second);
+        world.destroy_entities(std::vector<neolib::ecs::entity_id>{ second, second });
+        test_assert(!world.valid(world.to_ref(second)));
+        auto const third = world.create_entity(body_archetype(), position{});
+        auto const fourth = world.create_entity(body_archetype(), position{});
+        test_assert(third != fourth && world.valid(world.to_ref(third)) && world.valid(world.to_ref(fourth)));
+        test_assert(!allocator.free(0u) && allocator.free(all.front()) && !allocator.free(all.front()));
+
+        int resource = 42;
+        neolib::ecs::i_ecs& handles = world;
+        auto const handle = handles.add_handle<position>(&resource);
+        test_assert(handles.to_handle<int*>(handle) == &resource);
+        handles.release_handle<int*>(handle);
+        auto const reused = handles.add_handle<position>(&resource);
+        test_assert(reused != handle && static_cast<std::uint32_t>(reused) == static_cast<std::uint32_t>(handle) && (reused >> 32u) == (handle >> 32u) + 2u);
+        bool rejected = false;
+        try
+        {
+            handles.to_handle<int*>(handle);
+        }
+        catch (neolib::ecs::i_ecs::invalid_handle_id const&)
+        {
+            rejected = true;
+        }
+        test_assert(rejected);
+    }
+
+    void test_change_tracking()
+    {
+        neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        auto& positions = world.component<position>();
+        positions.enable_change_tracking();
+        auto const bodies = world.create_entities(body_archetype(), 5000u, position{});
+        auto const checkpoint = positions.checkpoint();
+        std::vector<neolib::ecs::entity_id> changed;
+        positions.changed_entities_since(checkpoint, changed);
+        test_assert(changed.empty());
+
+        std::vector<neolib::ecs::entity_id> const modified = { bodies[7], bodies[1500], bodies[4999] };
+        for (auto entity : modified)
+            positions.entity_record(entity).value.x = 1.0;
+        test_assert(std::as_const(positions).entity_record(bodies[8]).value.x == 0.0);
+        positions.changed_since(checkpoint, [&](neolib::ecs::entity_id aEntity, position const& aPosition)
+        {
+            test_assert(aPosition.value.x == 1.0);
+            changed.push_back(aEntity);
+        });
+        test_assert(changed == modified);
+
+        auto const next = positions.checkpoint();
+        changed.clear();
+        positions.changed_entities_since(next, changed);
+        test_assert(changed.empty());
+        positions.apply([](auto&, position& p) { p.value.y = 2.0; });
+        positions.changed_entities_since(next, changed);
+        test_assert(changed.size() == bodies.size());
+
+        auto copy = positions;
+        test_assert(copy.change_tracking() && copy.page_count() == positions.page_count());
+        auto const copyCheckpoint = copy.checkpoint();
+        copy[4999].value.z = 3.0;
+        changed.clear();
+        copy.changed_entities_since(copyCheckpoint, changed);
+        test_assert(changed == std::vector<neolib::ecs::entity_id>{ copy.entities()[4999] });
+        copy.take_snapshot();
+        test_assert(copy.snapshot().data().size() == bodies.size());
+    }
+
+    void test_world_file()
+    {
+        auto const path = (std::filesystem::temp_directory_path() / "neolib_ecs_test_world.bin").string();
+        std::vector<neolib::ecs::entity_id> particles;
+        std::vector<neolib::ecs::entity_ref> refs;
+        {
+            neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+            particles = world.create_entities(particle_archetype(), 3000u, position{}, velocity{ { 0.0, 1.0, 0.0 } });
+            world.component<heat>().populate_from(std::span<neolib::ecs::entity_id const>{ particles }, [](std::size_t aIndex) { return heat{ static_cast<double>(aIndex) }; });
+            world.component<spin>().populate(std::span<neolib::ecs::entity_id const>{ particles }, spin{ 1 });
+            std::vector<neolib::ecs::entity_id> doomed;
+            for (std::size_t i = 0; i < particles.size(); i += 4)
+                doomed.push_back(particles[i]);
+            world.destroy_entities(doomed);
+            world.create_entity(body_archetype(), position{ { -1.0, 0.0, 0.0 } }, heat{ -1.0 });
+            for (auto entity : particles)
+                refs.push_back({ entity, world.entity_generation(entity) });
+            world.save_world(path);
+        }
+        neolib::ecs::ecs restored{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        restored.component<heat>();
+        restored.component<spin>();
+        restored.load_world(path);
+        auto const particleSignature = restored.signature_of<heat, spin>();
+        for (std::size_t i = 0; i < particles.size(); ++i)
+        {
+            test_assert(restored.entity_generation(particles[i]) == refs[i].generation);
+            test_assert(restored.matches(particles[i], particleSignature) == (i % 4 != 0));
+            if (i % 4 != 0)
+            {
+                test_assert(restored.component<heat>().entity_record(particles[i]).value == static_cast<double>(i));
+                test_assert(restored.component<spin>().entity_record(particles[i]).value == 1);
+            }
+        }
+        test_assert(restored.component<heat>().entities().size() == 3000u - 750u + 1u);
+        test_assert(restored.component<neolib::ecs::entity_info>().entity_record(particles[1]).archetypeId == particle_archetype().id());
+        test_assert(!restored.component<position>().has_entity_record(particles[1]));
+        auto const reused = restored.create_entity(body_archetype(), heat{});
+        test_assert(reused != neolib::ecs::null_entity && !restored.component<spin>().has_entity_record(reused));
+        test_assert(restored.component<heat>().entities().size() == 3000u - 750u + 2u);
+
+        bool rejected = false;
+        try
+        {
+            restored.load_world(path);
+        }
+        catch (neolib::ecs::i_ecs::world_not_empty const&)
+        {
+            rejected = true;
+        }
+        test_assert(rejected);
+
+        std::vector<char> bytes;
+        {
+            std::ifstream file{ path, std::ios::binary };
+            bytes.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+        }
+        auto const corrupt = [&](std::size_t aSize, std::size_t aPatchOffset)
+        {
+            {
+                std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+                std::vector<char> patched{ bytes.begin(), bytes.begin() + aSize };
+                if (aPatchOffset < aSize)
+                    std::fill(patched.begin() + aPatchOffset, patched.end(), '\x7F');
+                file.write(patched.data(), static_cast<std::streamsize>(patched.size()));
+            }
+            neolib::ecs::ecs damaged{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+            damaged.component<heat>();
+            damaged.component<spin>();
+            try
+            {
+                damaged.load_world(path);
+            }
+            catch (neolib::ecs::i_ecs::invalid_world_file const&)
+            {
+                return true;
+            }
+            return false;
+        };
+        test_assert(corrupt(16u, 16u));
+        test_assert(corrupt(bytes.size() / 2u, bytes.size()));
+        test_assert(corrupt(bytes.size(), bytes.size() - sizeof(std::size_t)));
+        std::filesystem::remove(path);
+    }
+
+    void test_parallel_chunks()
+    {
+        neolib::thread_pool pool;
+        pool.reserve(4u);
+        std::size_t const count = 100000u;
+        std::size_t const grain = 64u;
+        std::vector<std::atomic<int>> visits(count);
+        std::vector<std::pair<std::size_t, std::size_t>> chunks((count + grain - 1u) / grain);
+        neolib::parallel_chunks(pool, count, grain, [&](std::size_t aFirst, std::size_t aLast)
+        {
+            if (aFirst == 0u)
+                std::this_thread::sleep_for(std::chrono::milliseconds{ 20 });
+            chunks[aFirst / grain] = { aFirst, aLast };
+            for (auto index = aFirst; index < aLast; ++index)
+                ++visits[index];
+        });
+        test_assert(std::all_of(visits.begin(), visits.end(), [](auto const& aVisits) { return aVisits == 1; }));
+        for (std::size_t chunk = 0u; chunk < chunks.size(); ++chunk)
+            test_assert(chunks[chunk] == std::make_pair(chunk * grain, std::min(count, (chunk + 1u) * grain)));
+
+        bool thrown = false;
+        try
+        {
+            neolib::parallel_chunks(pool, count, grain, [&](std::size_t aFirst, std::size_t)
+            {
+                if (aFirst == grain * 100u)
+                    throw std::runtime_error("chunk failed");
+            });
+        }
+        catch (std::runtime_error const&)
+        {
+            thrown = true;
+        }
+        test_assert(thrown);
+
+        neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        auto const bodies = world.create_entities(body_archetype(), 5000u, position{});
+        world.component<position>().parallel_apply([](auto&, position& p) { p.value.x += 1.0; }, 0u, 100u);
+        for (auto entity : bodies)
+            test_assert(world.component<position>().entity_record(entity).value.x == 1.0);
+    }
+
+    void test_spatial_index()
+    {
+        neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        auto box_at = [](double x, double y, double z) { return bounds{ neolib::aabb{ neolib::vec3{ x, y, z }, neolib::vec3{ x + 1.0, y + 1.0, z + 1.0 } } }; };
+        std::vector<neolib::ecs::entity_id> colliders;
+        for (int i = 0; i < 2000; ++i)
+            colliders.push_back(world.create_entity(collider_archetype(), box_at((i * 37) % 101, (i * 53) % 97, (i * 11) % 13)));
+        neolib::ecs::spatial_index<bounds> index{ world, [](bounds const& aBounds) { return aBounds.box; } };
+        index.update();
+        test_assert(index.size() == colliders.size());
+        test_assert(index.height() < 40);
+
+        auto brute_overlapping = [&](neolib::aabb const& aQuery)
+        {
+            std::vector<neolib::ecs::entity_id> result;
+            for (auto entity : std::as_const(world.component<bounds>()).entities())
+                if (neolib::aabb_intersects(std::as_const(world.component<bounds>()).entity_record(entity).box, aQuery))
+                    result.push_back(entity);
+            std::sort(result.begin(), result.end());
+            return result;
+        };
+        auto indexed_overlapping = [&](neolib::aabb const& aQuery)
+        {
+            std::vector<neolib::ecs::entity_id> result;
+            index.overlapping(aQuery, result);
+            std::sort(result.begin(), result.end());
+            return result;
+        };
+        neolib::aabb const query{ neolib::vec3{ 20.0, 20.0, 0.0 }, neolib::vec3{ 40.0, 35.0, 5.0 } };
+        test_assert(!brute_overlapping(query).empty() && indexed_overlapping(query) == brute_overlapping(query));
+
+        for (std::size_t i = 0; i < colliders.size(); i += 7)
+            world.component<bounds>().entity_record(colliders[i]) = box_at(200.0 + i, 0.0, 0.0);
+        world.destroy_entity(colliders[1]);
+        world.component<bounds>().destroy_entity_record(colliders[2]);
+        index.update();
+        test_assert(index.size() == colliders.size() - 2u && !index.contains(colliders[1]) && !index.contains(colliders[2]));
+        test_assert(indexed_overlapping(query) == brute_overlapping(query));
+        neolib::aabb const far{ neolib::vec3{ 190.0, -1.0, -1.0 }, neolib::vec3{ 260.0, 2.0, 2.0 } };
+        test_assert(indexed_overlapping(far) == brute_overlapping(far));
+
+        std::vector<neolib::ecs::entity_id> nearest;
+        index.nearest(neolib::vec3{ 300.0, 0.5, 0.5 }, 3u, nearest);
+        test_assert(nearest.size() == 3u && nearest[0] == colliders[98] && nearest[1] == colliders[105] && nearest[2] == colliders[91]);
+
+        auto const hit = index.nearest_hit(neolib::vec3{ 3000.0, 0.5, 0.5 }, neolib::vec3{ -1.0, 0.0, 0.0 }, 5000.0);
+        test_assert(hit && hit->first == colliders[1995] && hit->second == 3000.0 - (200.0 + 1995.0 + 1.0));
+        std::size_t rayHits = 0u;
+        index.raycast(neolib::vec3{ 3000.0, 0.5, 0.5 }, neolib::vec3{ -1.0, 0.0, 0.0 }, 5000.0, [&](neolib::ecs::entity_id, double) { ++rayHits; });
+        test_assert(rayHits >= 286u);
+
+        std::size_t inRadius = 0u;
+        index.within(neolib::vec3{ 300.0, 0.5, 0.5 }, 10.0, [&](neolib::ecs::entity_id) { ++inRadius; });
+        test_assert(inRadius == 3u);
+    }
+
+    void test_command_buffers()
+    {
+        neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        auto const existing = world.create_entities(particle_archetype(), 1000u, position{}, velocity{});
+        neolib::ecs::command_buffers buffers{ world };
+        std::size_t const threadCount = 4u;
+        std::size_t const perThread = 2500u;
+        std::vector<std::vector<neolib::ecs::entity_id>> created(threadCount);
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0u; t < threadCount; ++t)
+            threads.emplace_back([&, t]()
+            {
+                auto& buffer = buffers.local();
+                test_assert(&buffer == &buffers.local());
+                for (std::size_t i = 0u; i < perThread; ++i)
+                {
+                    auto const e = buffer.create_entity(particle_archetype(), position{ { static_cast<double>(t), static_cast<double>(i), 0.0 } }, velocity{});
+                    created[t].push_back(e);
+                    if (i % 10u == 0u)
+                        buffer.populate(e, position{ { -1.0, static_cast<double>(i), 0.0 } });
+                }
+                for (std::size_t i = t; i < existing.size(); i += threadCount)
+                {
+                    if (i % 2u == 0u)
+                        buffer.destroy_entity(existing[i]);
+                    else
+                        buffer.remove_component<velocity>(existing[i]);
+                }
+            });
+        for (auto& thread : threads)
+            thread.join();
+        test_assert(std::as_const(world.component<position>()).entities().size() == existing.size());
+        buffers.commit();
+        test_assert(std::as_const(world.component<position>()).entities().size() == existing.size() / 2u + threadCount * perThread);
+        test_assert(std::as_const(world.component<velocity>()).entities().size() == threadCount * perThread);
+        for (std::size_t t = 0u; t < threadCount; ++t)
+            for (std::size_t i = 0u; i < perThread; ++i)
+            {
+                auto const e = created[t][i];
+                test_assert(world.component<position>().entity_record(e).value.x == (i % 10u == 0u ? -1.0 : static_cast<double>(t)));
+                test_assert(world.component<position>().entity_record(e).value.y == static_cast<double>(i));
+                test_assert(world.component<velocity>().has_entity_record(e));
+                test_assert(world.component<neolib::ecs::entity_info>().entity_record(e).archetypeId == particle_archetype().id());
+            }
+        for (std::size_t i = 0u; i < existing.size(); ++i)
+            test_assert(world.component<position>().has_entity_record(existing[i]) == (i % 2u != 0u) && !world.component<velocity>().has_entity_record(existing[i]));
+
+        auto& buffer = buffers.local();
+        buffer.destroy_entity(existing[0]);
+        buffer.destroy_entity(created[0][0]);
+        buffer.destroy_entity(created[0][0]);
+        buffers.commit();
+        test_assert(buffer.empty() && !world.component<position>().has_entity_record(created[0][0]));
+
+        auto const replaced = created[1][1];
+        auto const removed = created[1][2];
+        buffer.remove_component<position>(replaced);
+        buffer.populate(replaced, position{ { 7.0, 0.0, 0.0 } });
+        buffer.populate(removed, position{ { 8.0, 0.0, 0.0 } });
+        buffer.remove_component<position>(removed);
+        buffers.commit();
+        test_assert(world.component<position>().entity_record(replaced).value.x == 7.0);
+        test_assert(!world.component<position>().has_entity_record(removed));
+        {
+            neolib::ecs::command_buffer discarded{ world };
+            auto const pending = discarded.create_entity(body_archetype(), position{});
+            test_assert((world.entity_generation(pending) & 1u) == 1u && discarded.size() == 2u);
+        }
+    }
+
+    void test_sort_by_key()
+    {
+        neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        auto& positions = world.component<position>();
+        positions.enable_change_tracking();
+        std::vector<neolib::ecs::entity_id> bodies;
+        for (int i = 0; i < 20000; ++i)
+            bodies.push_back(world.create_entity(body_archetype(), position{ { ((i * 7919) % 20011) - 10000.5, static_cast<double>(i), 0.0 } }));
+        auto consistent = [&]()
+        {
+            auto const& data = std::as_const(positions).component_data();
+            auto const& entities = std::as_const(positions).entities();
+            for (std::size_t index = 0u; index < data.size(); ++index)
+                if (positions.reverse_index(entities[index]) != index || bodies[static_cast<std::size_t>(data[index].value.y)] != entities[index])
+                    return false;
+            return true;
+        };
+        auto sorted_by_x = [&]()
+        {
+            auto const& data = std::as_const(positions).component_data();
+            return std::is_sorted(data.begin(), data.end(), [](position const& aLhs, position const& aRhs) { return aLhs.value.x < aRhs.value.x; });
+        };
+        positions.sort_by_key([](position const& aPosition) { return aPosition.value.x; }, 1000u);
+        test_assert(sorted_by_x() && consistent());
+
+        auto const checkpoint = positions.checkpoint();
+        positions.resort_by_key([](position const& aPosition) { return aPosition.value.x; });
+        std::vector<neolib::ecs::entity_id> changed;
+        positions.changed_entities_since(checkpoint, changed);
+        test_assert(changed.empty());
+        positions.entity_record(bodies[42]).value.x += 0.75;
+        positions.entity_record(bodies[4242]).value.x -= 2.0;
+        auto const nudged = positions.checkpoint();
+        positions.resort_by_key([](position const& aPosition) { return aPosition.value.x; });
+        positions.changed_entities_since(nudged, changed);
+        test_assert(sorted_by_x() && consistent() && changed.size() < 10u);
+
+        positions.resort([](position const& aLhs, position const& aRhs) { return aLhs.value.y < aRhs.value.y; });
+        test_assert(consistent() && std::as_const(positions).entities() == bodies);
+        positions.sort_by_key([](position const& aPosition) { return static_cast<std::int32_t>(aPosition.value.x); });
+        test_assert(consistent());
+        auto const& data = std::as_const(positions).component_data();
+        test_assert(std::is_sorted(data.begin(), data.end(), [](position const& aLhs, position const& aRhs) { return static_cast<std::int32_t>(aLhs.value.x) < static_cast<std::int32_t>(aRhs.value.x); }));
+    }
+
+    void test_shared_component()
+    {
+        neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        auto& materials = world.shared_component<material>();
+        std::vector<neolib::ecs::shared<material>> pointers;
+        for (int i = 0; i < 10000; ++i)
+            pointers.push_back(materials.populate("material" + std::to_string(i), material{ static_cast<double>(i) }));
+        test_assert(materials.size() == 10000u);
+        for (std::size_t i = 0u; i < materials.size(); ++i)
+            test_assert(materials[i].shininess == static_cast<double>(i) && materials.name(i) == "material" + std::to_string(i));
+        neolib::ecs::shared_key const key{ "material1234" };
+        auto const handle = materials.handle(key);
+        test_assert(handle == 1234u && &materials[key] == pointers[1234].ptr() && !materials.find(neolib::ecs::shared_key{ "missing" }));
+        materials.populate(key, material{ -1.0 });
+        world.populate_shared<material>("material5000", material{ -2.0 });
+        test_assert(materials.size() == 10000u && pointers[1234]->shininess == -1.0 && std::as_const(materials)[std::string{ "material5000" }].shininess == -2.0);
+        materials["extra"].shininess = 3.0;
+        test_assert(materials.size() == 10001u && materials[10000u].shininess == 3.0 && pointers[0]->shininess == 0.0);
+        std::string_view const view{ "material42 and more" };
+        test_assert(materials.find(view.substr(0u, 10u)) == std::optional<std::size_t>{ 42u } && !materials.find(view));
+        materials.populate(view.substr(0u, 10u), material{ 4.2 });
+        test_assert(materials.size() == 10001u && pointers[42]->shininess == 4.2 && std::as_const(materials)["material42"].shininess == 4.2);
+    }
+
+    void test_life_spans()
+    {
+        neolib::timing_wheel<std::int64_t, int> wheel{ -1000 };
+        std::vector<std::pair<std::int64_t, int>> scheduled;
+        for (int i = 0; i < 5000; ++i)
+        {
+            auto const expiry = static_cast<std::int64_t>((i * 7919ll) % 2000003ll) * ((i % 3 == 0) ? 1000ll : 1ll) - 900;
+            wheel.schedule(expiry, i);
+            scheduled.emplace_back(expiry, i);
+        }
+        std::vector<int> fired;
+        for (std::int64_t now = -1000, step = 7; now < 4000000000ll; now += step, step = step * 3 / 2)
+        {
+            wheel.advance(now, [&](auto const& aEntry) { test_assert(aEntry.expiry <= now); fired.push_back(aEntry.payload); });
+            test_assert(std::count_if(scheduled.begin(), scheduled.end(), [&](auto const& e) { return e.first <= now; }) == static_cast<std::ptrdiff_t>(fired.size()));
+            test_assert(wheel.size() + fired.size() == scheduled.size());
+            test_assert(wheel.empty() || *wheel.next_expiry() > now);
+        }
+        test_assert(wheel.empty());
+
+        neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        auto& timeSystem = world.system<neolib::ecs::time>();
+        auto& clock = world.shared_component<neolib::ecs::clock>()[0u];
+        std::vector<neolib::ecs::entity_id> mortals;
+        for (int i = 0; i < 1000; ++i)
+        {
+            mortals.push_back(world.create_entity(body_archetype(), position{}));
+            world.populate(mortals.back(), neolib::ecs::entity_life_span{ (i % 10 + 1) * 100 });
+        }
+        auto const immortal = world.create_entity(body_archetype(), position{});
+        auto alive = [&](neolib::ecs::entity_id aEntity) { return world.component<position>().has_entity_record(aEntity); };
+        auto tick = [&](std::int64_t aTime)
+        {
+            clock.time = aTime;
+            timeSystem.apply();
+            world.commit_async_entity_destruction();
+        };
+        tick(100);
+        test_assert(std::all_of(mortals.begin(), mortals.end(), alive));
+        tick(150);
+        for (std::size_t i = 0u; i < mortals.size(); ++i)
+            test_assert(alive(mortals[i]) == (i % 10u != 0u));
+        world.component<neolib::ecs::entity_life_span>().entity_record(mortals[9]).lifeSpan = 50;
+        world.component<neolib::ecs::entity_life_span>().entity_record(mortals[8]).lifeSpan = 5000;
+        tick(150);
+        test_assert(!alive(mortals[9]) && alive(mortals[19]));
+        tick(1001);
+        test_assert(alive(mortals[8]) && !alive(mortals[18]) && !alive(mortals[19]) && alive(immortal));
+        tick(5001);
+        test_assert(!alive(mortals[8]) && alive(immortal));
+    }
+
+    void test_epoch_reads()
+    {
+        neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        auto const bodies = world.create_entities(body_archetype(), 5000u, position{});
+        auto& positions = world.component<position>();
+        test_assert(!positions.have_published() && positions.read()->empty());
+        positions.publish();
+        std::atomic<bool> done = false;
+        std::atomic<std::size_t> reads = 0u;
+        std::atomic<bool> consistent = true;
+        std::vector<std::thread> readers;
+        for (int r = 0; r < 4; ++r)
+            readers.emplace_back([&]()
+            {
+                while (!done)
+                {
+                    auto const view = positions.read();
+                    auto const expected = view->entity_record(bodies[0]).value.x;
+                    view->for_each([&](neolib::ecs::entity_id, position const& aPosition)
+                    {
+                        if (aPosition.value.x != expected)
+                            consistent = false;
+                    });
+                    if (view->size() != bodies.size())
+                        consistent = false;
+                    ++reads;
+                }
+            });
+        for (int version = 1; version <= 200; ++version)
+        {
+            positions.apply([&](auto&, position& p) { p.value.x = static_cast<double>(version); });
+            positions.publish();
+        }
+        while (reads < 100u)
+            std::this_thread::yield();
+        done = true;
+        for (auto& reader : readers)
+            reader.join();
+        test_assert(consistent);
+        positions.reclaim();
+        test_assert(positions.epochs().retired_count() == 0u && positions.read()->entity_record(bodies[4999]).value.x == 200.0);
+
+        auto const published = positions.read();
+        world.destroy_entity(bodies[1]);
+        test_assert(positions.read().operator->() == published.operator->());
+        test_assert(!published->has_entity_record(bodies[1]) && published->size() == bodies.size() - 1u);
+    }
+
+    struct manual_clock
+    {
+        typedef std::chrono::nanoseconds duration;
+        typedef duration::rep rep;
+        typedef duration::period period;
+        typedef std::chrono::time_point<manual_clock> time_point;
+        static constexpr bool is_steady = true;
+        static inline time_point current = {};
+        static time_point now() noexcept
+        {
+            return current;
+        }
+    };
+
+    void test_frame_pacer()
+    {
+        using namespace std::chrono_literals;
+
+        // Pacing arithmetic against a manual clock; wait() is only called at or after a step boundary so it never sleeps.
+        neolib::ecs::basic_frame_pacer<manual_clock> pacer{ 2ms, 4u };
+        manual_clock::current = manual_clock::time_point{ 100ms };
+        test_assert(pacer.wait() == 1u);
+        manual_clock::current += 2ms;
+        test_assert(pacer.wait() == 1u);
+        manual_clock::current += 1ms;
+        pacer.tick_completed();
+        test_assert(pacer.statistics().overruns == 0u && pacer.statistics().lastTickTime == 1ms);
+        manual_clock::current += 1ms;
+        test_assert(pacer.wait() == 1u && pacer.statistics().maxLateness == 0ms);
+        manual_clock::current += 7ms;
+        pacer.tick_completed();
+        test_assert(pacer.statistics().overruns == 1u && pacer.statistics().maxOverrun == 5ms && pacer.statistics().maxTickTime == 7ms);
+        test_assert(pacer.wait() == 3u && pacer.statistics().catchUpSteps == 2u && pacer.statistics().maxLateness == 5ms);
+        pacer.tick_completed();
+        test_assert(pacer.statistics().overruns == 1u);
+        manual_clock::current += 31ms;
+        test_assert(pacer.wait() == 4u && pacer.statistics().droppedSteps == 12u && pacer.statistics().catchUpSteps == 5u);
+        test_assert(pacer.statistics().ticks == 5u && pacer.statistics().steps == 10u && pacer.statistics().totalLateness == 35ms);
+        manual_clock::current += 3ms;
+        test_assert(pacer.wait() == 1u && pacer.statistics().maxLateness == 30ms);
+        pacer.reset();
+        test_assert(pacer.wait() == 1u && pacer.statistics().ticks == 1u && pacer.statistics().totalLateness == 0ms);
+
+        // Scheduler integration on the real clock; only tick/step bookkeeping is checked.
+        neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        world.create_entity(particle_archetype(), position{}, velocity{ { 1.0, 0.0, 0.0 } });
+        neolib::ecs::system_scheduler scheduler{ world };
+        scheduler.add(world.system<integrator>());
+        neolib::ecs::frame_pacer realPacer{ 1ms, 4u };
+        std::size_t steps = 0u;
+        for (int tick = 0; tick < 10; ++tick)
+            steps += scheduler.run_paced_frame(realPacer);
+        test_assert(steps >= 10u && realPacer.statistics().ticks == 10u && realPacer.statistics().steps == steps);
+    }
+
+    void test_soa_mirror()
+    {
+        neolib::ecs::ecs world{ neolib::ecs::ecs_flags::PopulateEntityInfo | neolib::ecs::ecs_flags::NoThreads };
+        auto const bodies = world.create_entities(body_archetype(), 3000u, position{});
+        auto& positions = world.component<position>();
+        for (std::size_t i = 0u; i < bodies.size(); ++i)
+            positions.entity_record(bodies[i]).value = neolib::vec3{ double(i), 2.0 * double(i), 3.0 * double(i) };
+        auto const& layout = neolib::ecs::soa_mirror<position>::layout();
+        test_assert(layout.size() == 1u && layout[0].offset == 0u && layout[0].lanes == 3u && 
+            layout[0].scalarType == neolib::ecs::component_data_field_type::Float64);
+        test_assert(neolib::ecs::soa_mirror<material>::layout()[0].lanes == 1u);
+        neolib::ecs::soa_mirror<position> mirror{ positions };
+        test_assert(mirror.update() == bodies.size() && mirror.size() == bodies.size());
+        auto const check = [&]()
+        {
+            auto const x = mirror.column<double>(0u, 0u);
+            auto const z = mirror.column<double>(0u, 2u);
+            for (std::size_t i = 0u; i < mirror.size(); ++i)
+            {
+                auto const& record = std::as_const(positions).entity_record(mirror.entities()[i]);
+                if (x[i] != record.value.x || z[i] != record.value.z)
+                    return false;
+            }
+            return reinterpret_cast<std::uintptr_t>(x.data()) % neolib::ecs::soa_column_alignment == 0u;
+        };
+        test_assert(check());
+        test_assert(mirror.update() == 0u);
+        positions.entity_record(bodies[2500]).value.z = -1.0;
+        test_assert(mirror.update() == 3000u - 2048u && check());
+        for (auto& y : mirror.mutable_column<double>(0u, 1u))
+            y += 0.5;
+        mirror.commit();
+        test_assert(mirror.update() == 0u);
+        test_assert(std::as_const(positions).entity_record(bodies[10]).value.y == 20.5 && std::as_const(positions).entity_record(bodies[10]).value.x == 10.0);
+        auto const beforeCommit = positions.checkpoint();
+        mirror.mutable_column<double>(0u, 0u)[2100] = -5.0;
+        mirror.commit();
+        test_assert(positions.page_version(0u) <= beforeCommit && positions.page_version(1u) <= beforeCommit && positions.page_version(2u) > beforeCommit);
+        test_assert(mirror.update() == 0u && std::as_const(positions).entity_record(mirror.entities()[2100]).value.x == -5.0);
+        bool threw = false;
+        try { mirror.column<float>(0u, 0u); } catch (neolib::ecs::soa_mirror<position>::wrong_column_type const&) { threw = true; }
+        test_assert(threw);
+        world.destroy_entity(bodies[0]);
+        threw = false;
+        try { mirror.commit(); } catch (neolib::ecs::soa_mirror<position>::outdated const&) { threw = true; }
+        test_assert(threw && mirror.update() > 0u && mirror.size() == 2999u && check());
+    }
+}
+
+int main()
+{
+    neolib::allocate_service_provider();
+
+    test_archetype_storage();
+    test_system_scheduler();
+    test_view();
+    test_snapshot();
+    test_bulk_entities();
+    test_component_signature();
+    test_generational_ids();
+    test_change_tracking();
+    test_world_file();
+    test_parallel_chunks();
+    test_spatial_index();
+    test_command_buffers();
+    test_sort_by_key();
+    test_shared_component();
+    test_life_spans();
+    test_epoch_reads();
+    test_frame_pacer();
+    test_soa_mirror();
+}
@@ -1,8 +1,26 @@
+#include <algorithm>
+#include <numeric>
+#include <source_location>
+#include <thread>
+#include <vector>
 #include <boost/signals2/signal.hpp>
 
 #include <neolib/task/event.hpp>
 #include <neolib/task/async_thread.hpp>
 #include <neolib/task/timer.hpp>
+#include <neolib/task/thread_pool.hpp>
+#include <neolib/task/cpu_topology.hpp>
+#include <neolib/task/parallel_algorithm.hpp>
+#include <neolib/task/task_group.hpp>
+#include <neolib/task/co_task.hpp>
+#include <neolib/task/work_stealing_deque.hpp>
+
+template<> neolib::i_async_task& neolib::services::start_service<neolib::i_async_task>()
+{
+	static neolib::async_task mainTask;
+	static neolib::async_thread mainThread{ mainTask, "neolib::task unit test(s)", true };
+	return mainTask;
+}
 
 namespace test
 {
@@ -23,19 +41,336 @@ namespace test
 		std::atomic<std::optional<std::chrono::steady_clock::time_point>> end;
 		std::optional<neolib::callback_timer> timer;
 	};
-}
 
-template<> neolib::i_async_task& neolib::services::start_service<neolib::i_async_task>()
-{
-	static neolib::async_task mainTask;
-	static neolib::async_thread mainThread{ mainTask, "neolib::task unit test(s)", true };
-	return mainTask;
+	void test_assert(bool assertion, std::source_location const& location = std::source_location::current())
+	{
+		if (!assertion)
+			throw std::logic_error("Test failed at " + std::string{ location.file_name() } + ":" + std::to_string(location.line()));
+	}
+
+	void test_work_stealing_deque()
+	{
+		int const count = 200000;
+		neolib::work_stealing_deque<int> deque{ 2 };
+		std::vector<std::atomic<int>> seen(count);
+		std::atomic<bool> done = false;
+		std::vector<std::thread> thieves;
+		for (int t = 0; t < 3; ++t)
+			thieves.emplace_back([&]()
+			{
+				while (!done || !deque.empty())
+					if (auto value = deque.steal())
+						++seen[*value];
+			});
+		for (int i = 0; i < count; ++i)
+		{
+			deque.push(i);
+			if (i % 3 == 0)
+				if (auto value = deque.pop())
+					++seen[*value];
+		}
+		while (auto value = deque.pop())
+			++seen[*value];
+		done = true;
+		for (auto& thief : thieves)
+			thief.join();
+		test_assert(std::all_of(seen.begin(), seen.end(), [](auto const& n) { return n == 1; }));
+	}
+
+	void test_thread_pool()
+	{
+		neolib::thread_pool pool;
+		pool.reserve(4);
+		std::atomic<int> total = 0;
+		for (int i = 0; i < 1000; ++i)
+			pool.run([&]()
+			{
+				for (int j = 0; j < 100; ++j)
+					pool.run([&]() { ++total; });
+			});
+		pool.wait();
+		test_assert(total == 100000 && pool.idle() && pool.active_threads() == 0);
+
+		neolib::thread_pool serial;
+		serial.reserve(1);
+		std::atomic<bool> release = false;
+		std::vector<int> order;
+		serial.run([&]() { while (!release) std::this_thread::yield(); });
+		while (serial.active_threads() != 1)
+			std::this_thread::yield();
+		for (int priority : { -1, 0, 2, 1 })
+			serial.run([&, priority]() { order.push_back(priority); }, priority);
+		release = true;
+		serial.wait();
+		test_assert((order == std::vector<int>{ 2, 1, 0, -1 }));
+		release = false;
+		order.clear();
+		serial.run([&]() { while (!release) std::this_thread::yield(); });
+		while (serial.active_threads() != 1)
+			std::this_thread::yield();
+		for (int i = 0; i < 4; ++i)
+			serial.run([&, i]() { order.push_back(i); });
+		while (serial.help());
+		release = true;
+		serial.wait();
+		test_assert((order == std::vector<int>{ 0, 1, 2, 3 }));
+		auto result = pool.run(std::function<int()>{ []() { return 42; } });
+		test_assert(result.first.get() == 42);
+	}
+
+	void test_bulk_submission()
+	{
+		neolib::thread_pool pool;
+		pool.reserve(4);
+		std::vector<std::atomic<int>> hits(100000);
+		auto handle = pool.run_bulk(hits.size(), [&](std::size_t aIndex) { ++hits[aIndex]; });
+		handle.wait();
+		test_assert(handle.done() && std::all_of(hits.begin(), hits.end(), [](auto const& n) { return n == 1; }));
+		std::vector<int> items(10000, 1);
+		pool.run_bulk(items, [](int& aItem) { aItem *= 3; }, 64u).wait();
+		test_assert(std::all_of(items.begin(), items.end(), [](int n) { return n == 3; }));
+		std::atomic<int> nested = 0;
+		pool.run([&]() { pool.run_bulk(1000u, [&](std::size_t) { ++nested; }, 10u).wait(); }).first.wait();
+		test_assert(nested == 1000);
+		bool threw = false;
+		try
+		{
+			pool.run_bulk(1000u, [](std::size_t aIndex) { if (aIndex == 500u) throw std::runtime_error("bulk"); }).wait();
+		}
+		catch (std::runtime_error const&)
+		{
+			threw = true;
+		}
+		test_assert(threw && pool.run_bulk(0u, [](std::size_t) {}).done());
+		pool.wait();
+		test_assert(pool.idle());
+	}
+
+	void test_parallel_algorithms()
+	{
+		neolib::thread_pool pool;
+		pool.reserve(4);
+		std::size_t const count = 100003u;
+		std::vector<std::uint64_t> values(count);
+		neolib::parallel_for(pool, std::size_t{ 0u }, count, [&](std::size_t aIndex) { values[aIndex] = aIndex % 97u; }, 1000u);
+		auto const expectedSum = std::accumulate(values.begin(), values.end(), std::uint64_t{ 0u });
+		test_assert(neolib::parallel_reduce(pool, values.begin(), values.end(), std::uint64_t{ 0u }) == expectedSum);
+		test_assert(neolib::parallel_transform_reduce(pool, values.begin(), values.end(), std::uint64_t{ 0u }, std::plus<>{},
+			[](std::uint64_t v) { return v * 2u; }) == expectedSum * 2u);
+		std::vector<std::uint64_t> inclusive(count);
+		std::vector<std::uint64_t> exclusive(count);
+		neolib::parallel_inclusive_scan(pool, values.begin(), values.end(), inclusive.begin());
+		neolib::parallel_exclusive_scan(pool, values.begin(), values.end(), exclusive.begin(), std::uint64_t{ 5u });
+		std::vector<std::uint64_t> expected(count);
+		std::inclusive_scan(values.begin(), values.end(), expected.begin());
+		test_assert(inclusive == expected);
+		std::exclusive_scan(values.begin(), values.end(), expected.begin(), std::uint64_t{ 5u });
+		test_assert(exclusive == expected);
+		std::vector<std::uint64_t> sorted(count);
+		neolib::parallel_for(pool, std::size_t{ 0u }, count, [&](std::size_t aIndex) { sorted[aIndex] = (aIndex * 7919u) % 10007u; });
+		auto reference = sorted;
+		neolib::parallel_sort(pool, sorted.begin(), sorted.end());
+		std::sort(reference.begin(), reference.end());
+		test_assert(sorted == reference);
+		std::atomic<std::uint64_t> nested = 0u;
+		neolib::parallel_for(pool, 0, 64, [&](int)
+		{
+			std::vector<std::uint64_t> inner(10000u, 1u);
+			nested += neolib::parallel_reduce(pool, inner.begin(), inner.end(), std::uint64_t{ 0u }, std::plus<>{}, 100u, 0u);
+		}, 1u, 0u);
+		test_assert(nested == 640000u);
+	}
+
+	void test_task_groups()
+	{
+		neolib::thread_pool pool;
+		pool.reserve(4);
+		std::atomic<bool> release = false;
+		neolib::task_group slow{ pool };
+		slow.run([&]() { while (!release) std::this_thread::yield(); });
+		neolib::task_group fast{ pool };
+		std::atomic<int> done = 0;
+		for (int i = 0; i < 1000; ++i)
+			fast.run([&]() { ++done; });
+		fast.wait();
+		test_assert(done == 1000 && slow.pending() == 1u);
+		release = true;
+		slow.wait();
+		test_assert(slow.pending() == 0u);
+
+		std::atomic<int> nested = 0;
+		neolib::task_group outer{ pool };
+		for (int i = 0; i < 16; ++i)
+			outer.run([&]()
+			{
+				neolib::task_group inner{ pool };
+				for (int j = 0; j < 100; ++j)
+					inner.run([&]() { ++nested; });
+				inner.wait();
+			});
+		outer.wait();
+		test_assert(nested == 1600);
+
+		neolib::task_group failing{ pool };
+		std::atomic<int> ran = 0;
+		bool threw = false;
+		try
+		{
+			failing.run([]() { throw std::runtime_error("member"); });
+			failing.wait();
+		}
+		catch (std::runtime_error const&)
+		{
+			threw = true;
+		}
+		test_assert(threw && !failing.cancelled());
+		failing.cancel();
+		for (int i = 0; i < 100; ++i)
+			failing.run([&]() { ++ran; });
+		failing.wait();
+		test_assert(ran == 0 && failing.pending() == 0u);
+
+		neolib::thread_pool stoppedPool;
+		stoppedPool.reserve(1);
+		stoppedPool.stop();
+		test_assert(!stoppedPool.start(std::make_shared<neolib::function_task<void>>([]() {})));
+		neolib::task_group orphaned{ stoppedPool };
+		int ranInline = 0;
+		orphaned.run([&]() { ++ranInline; });
+		orphaned.wait();
+		test_assert(ranInline == 1 && orphaned.pending() == 0u);
+	}
+
+	neolib::co_task<int> co_add(int aLeft, int aRight)
+	{
+		co_return aLeft + aRight;
+	}
+
+	neolib::co_task<int> co_sum_on_pool(neolib::thread_pool& aPool, std::thread::id& aResumedOn)
+	{
+		int total = co_await co_add(1, 2);
+		co_await neolib::resume_on(aPool);
+		aResumedOn = std::this_thread::get_id();
+		total += co_await co_add(3, 4);
+		co_return total;
+	}
+
+	neolib::co_task<> co_fail()
+	{
+		throw std::runtime_error("coroutine");
+		co_return;
+	}
+
+	neolib::co_task<> co_wait_for_event(neolib::event<int>& aEvent, neolib::i_async_task& aTask, int& aResult, bool& aDone)
+	{
+		aResult = co_await neolib::next_event(aEvent);
+		co_await neolib::delay(aTask, std::chrono::milliseconds{ 20 });
+		aResult *= 2;
+		aDone = true;
+	}
+
+	void test_coroutines()
+	{
+		neolib::thread_pool pool;
+		std::thread::id resumedOn;
+		test_assert(neolib::sync_wait(co_sum_on_pool(pool, resumedOn)) == 10 && resumedOn != std::this_thread::get_id());
+		neolib::thread_pool stoppedPool;
+		stoppedPool.stop();
+		test_assert(neolib::sync_wait(co_sum_on_pool(stoppedPool, resumedOn)) == 10 && resumedOn == std::this_thread::get_id());
+		bool threw = false;
+		try
+		{
+			neolib::sync_wait(co_fail());
+		}
+		catch (std::runtime_error const&)
+		{
+			threw = true;
+		}
+		test_assert(threw);
+
+		auto& mainTask = neolib::services::start_service<neolib::i_async_task>();
+		neolib::event<int> event;
+		int result = 0;
+		bool done = false;
+		neolib::co_spawn(co_wait_for_event(event, mainTask, result, done));
+		test_assert(result == 0 && !done);
+		event.trigger(21);
+		auto const start = std::chrono::steady_clock::now();
+		while (!done && std::chrono::steady_clock::now() - start < std::chrono::seconds{ 5 })
+			mainTask.do_work(neolib::yield_type::Sleep);
+		test_assert(done && result == 42 && std::chrono::steady_clock::now() - start >= std::chrono::milliseconds{ 20 });
+
+		result = 0;
+		done = false;
+		neolib::co_spawn(co_wait_for_event(event, mainTask, result, done));
+		std::thread{ [&]() { event.trigger(5); event.trigger(6); } }.join();
+		while (!done && std::chrono::steady_clock::now() - start < std::chrono::seconds{ 10 })
+			mainTask.do_work(neolib::yield_type::Sleep);
+		test_assert(done && result == 10);
+	}
+	void test_cpu_topology()
+	{
+		test_assert((neolib::cpu_topology::parse_cpu_list("0-3,8,10-11") == std::vector<std::uint32_t>{ 0, 1, 2, 3, 8, 10, 11 }));
+		bool threw = false;
+		try
+		{
+			neolib::cpu_topology{ std::vector<neolib::logical_cpu>{} };
+		}
+		catch (neolib::cpu_topology::no_cpus const&)
+		{
+			threw = true;
+		}
+		test_assert(threw);
+
+		std::vector<neolib::logical_cpu> cpus;
+		for (std::uint32_t sibling = 0u; sibling < 2u; ++sibling)
+			for (std::uint32_t core = 0u; core < 4u; ++core)
+				cpus.push_back(neolib::logical_cpu{ core + 4u * sibling, core, core / 2u, sibling });
+		neolib::cpu_topology const topology{ cpus };
+		test_assert(topology.core_count() == 4u && topology.node_count() == 2u);
+		std::vector<std::uint32_t> placed;
+		for (auto const& cpu : topology.placement())
+			placed.push_back(cpu.id);
+		test_assert((placed == std::vector<std::uint32_t>{ 0, 2, 1, 3, 4, 6, 5, 7 }));
+		std::vector<std::uint32_t> order;
+		std::array<std::size_t, 2> tiers;
+		neolib::cpu_topology::proximity_order(topology.placement(), 0u, order, tiers);
+		test_assert((order == std::vector<std::uint32_t>{ 4, 2, 6, 1, 3, 5, 7 }) && tiers[0] == 1u && tiers[1] == 3u);
+
+		neolib::thread_pool pool{ topology };
+		test_assert(pool.max_threads() == 8u && pool.placement(1u).node == 1u && pool.placement(9u).id == 2u);
+		std::atomic<int> done = 0;
+		for (int i = 0; i < 1000; ++i)
+			pool.run([&]() { ++done; }, neolib::thread_pool::locality{ .node = static_cast<std::uint32_t>(i % 3) });
+		for (int i = 0; i < 100; ++i)
+			pool.run([&]() { ++done; }, neolib::thread_pool::locality{ .cpu = 5u });
+		pool.wait();
+		test_assert(done == 1100);
+
+		auto const& system = neolib::cpu_topology::system();
+		test_assert(!system.cpus().empty() && system.core_count() <= system.cpus().size());
+		neolib::thread_pool pinned{ system, true };
+		neolib::task_group group{ pinned };
+		std::atomic<int> pinnedDone = 0;
+		for (int i = 0; i < 100; ++i)
+			group.run([&]() { ++pinnedDone; });
+		group.wait();
+		test_assert(pinnedDone == 100);
+	}
 }
 
 int main()
 {
 	neolib::allocate_service_provider();
 
+	test::test_work_stealing_deque();
+	test::test_thread_pool();
+	test::test_bulk_submission();
+	test::test_parallel_algorithms();
+	test::test_task_groups();
+	test::test_coroutines();
+	test::test_cpu_topology();
+
 	std::optional<std::pair<double, double>> stats;
 	for (int32_t i = 1; i <= 200; ++i)
 	{